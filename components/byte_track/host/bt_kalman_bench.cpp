@@ -0,0 +1,178 @@
+/*
+ * Checks the structure-aware Kalman kernels against the dense Eigen reference
+ * (predict_dense/update_dense) and compares their throughput.
+ *
+ *   bt_kalman_bench [--tracks N] [--steps N] [--seconds X] [--tolerance X] [--seed N]
+ *
+ * Every track is initiated from a random box and run through --steps predict/update
+ * cycles on both paths with the same noisy measurements. The largest difference of any
+ * mean or covariance entry, relative to the largest entry of the same vector or matrix,
+ * must stay within --tolerance (default 1e-3), otherwise the program exits with 1.
+ * Throughput is reported as predict+update cycles (tracks) per second for each path.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "kalmanFilter.h"
+
+using byte_kalman::KalmanFilter;
+
+struct Track {
+    float x, y, a, h, vx, vy;
+};
+
+static float rnd() { return rand() / float(RAND_MAX); }
+
+static std::vector<Track> make_tracks(int n) {
+    std::vector<Track> tracks(n);
+    for (auto& t : tracks) {
+        t.x  = rnd() * 1280;
+        t.y  = rnd() * 720;
+        t.a  = 0.3f + rnd() * 0.7f;
+        t.h  = 30 + rnd() * 120;
+        t.vx = (rnd() - .5f) * 8;
+        t.vy = (rnd() - .5f) * 8;
+    }
+    return tracks;
+}
+
+// xyah measurements of every track at every step, shared by both paths
+static std::vector<float> make_measurements(const std::vector<Track>& tracks, int steps) {
+    std::vector<float> z(tracks.size() * steps * 4);
+    for (size_t i = 0; i < tracks.size(); i++) {
+        const Track& t = tracks[i];
+        for (int s = 0; s < steps; s++) {
+            float* m = &z[(i * steps + s) * 4];
+            m[0]     = t.x + t.vx * (s + 1) + (rnd() - .5f) * 2;
+            m[1]     = t.y + t.vy * (s + 1) + (rnd() - .5f) * 2;
+            m[2]     = t.a + (rnd() - .5f) * 0.02f;
+            m[3]     = t.h + (rnd() - .5f) * 2;
+        }
+    }
+    return z;
+}
+
+static double relative_diff(const float* a, const float* b, int n) {
+    double diff = 0, scale = 0;
+    for (int i = 0; i < n; i++) {
+        diff  = std::max(diff, (double)std::fabs(a[i] - b[i]));
+        scale = std::max(scale, (double)std::fabs(b[i]));
+    }
+    return scale > 0 ? diff / scale : diff;
+}
+
+int main(int argc, char** argv) {
+    int      num_tracks = 64;
+    int      steps      = 50;
+    double   seconds    = 0.5;
+    double   tolerance  = 1e-3;
+    unsigned seed       = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* arg  = argv[i];
+        const char* next = argv[i + 1];
+        if (!strcmp(arg, "--tracks"))
+            num_tracks = std::max(1, atoi(next));
+        else if (!strcmp(arg, "--steps"))
+            steps = std::max(1, atoi(next));
+        else if (!strcmp(arg, "--seconds"))
+            seconds = atof(next);
+        else if (!strcmp(arg, "--tolerance"))
+            tolerance = atof(next);
+        else if (!strcmp(arg, "--seed"))
+            seed = strtoul(next, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 1;
+        }
+    }
+    if (argc % 2 == 0) {
+        fprintf(stderr, "missing value for %s\n", argv[argc - 1]);
+        return 1;
+    }
+
+    srand(seed);
+    KalmanFilter             kf;
+    const std::vector<Track> tracks = make_tracks(num_tracks);
+    const std::vector<float> z      = make_measurements(tracks, steps);
+
+    double max_mean = 0, max_cov = 0;
+    for (int i = 0; i < num_tracks; i++) {
+        DETECTBOX first;
+        first << z[i * steps * 4], z[i * steps * 4 + 1], z[i * steps * 4 + 2], z[i * steps * 4 + 3];
+        KAL_DATA dense = kf.initiate(first);
+        float    mean[8], cov[64];
+        kf.initiate(&z[i * steps * 4], mean, cov);
+
+        for (int s = 1; s < steps; s++) {
+            const float* m = &z[(i * steps + s) * 4];
+            DETECTBOX    measurement;
+            measurement << m[0], m[1], m[2], m[3];
+            kf.predict_dense(dense.first, dense.second);
+            dense = kf.update_dense(dense.first, dense.second, measurement);
+            kf.predict(mean, cov);
+            kf.update(mean, cov, m);
+
+            max_mean = std::max(max_mean, relative_diff(mean, dense.first.data(), 8));
+            max_cov  = std::max(max_cov, relative_diff(cov, dense.second.data(), 64));
+        }
+    }
+    const bool ok = max_mean <= tolerance && max_cov <= tolerance;
+    printf("%d tracks x %d steps: max relative difference mean %.2e, covariance %.2e  %s\n", num_tracks, steps,
+           max_mean, max_cov, ok ? "ok" : "MISMATCH");
+
+    // Every pass runs one predict+update per track; passes repeat until --seconds elapse.
+    double dense_rate = 0, fast_rate = 0;
+    {
+        std::vector<KAL_DATA> states(num_tracks);
+        for (int i = 0; i < num_tracks; i++) {
+            DETECTBOX first;
+            first << z[i * steps * 4], z[i * steps * 4 + 1], z[i * steps * 4 + 2], z[i * steps * 4 + 3];
+            states[i] = kf.initiate(first);
+        }
+        long cycles = 0;
+        auto t0     = std::chrono::steady_clock::now();
+        auto t1     = t0;
+        for (int s = 0; std::chrono::duration<double>(t1 - t0).count() < seconds; s = (s + 1) % steps) {
+            for (int i = 0; i < num_tracks; i++) {
+                const float* m = &z[(i * steps + s) * 4];
+                DETECTBOX    measurement;
+                measurement << m[0], m[1], m[2], m[3];
+                kf.predict_dense(states[i].first, states[i].second);
+                states[i] = kf.update_dense(states[i].first, states[i].second, measurement);
+            }
+            cycles += num_tracks;
+            t1 = std::chrono::steady_clock::now();
+        }
+        dense_rate = cycles / std::chrono::duration<double>(t1 - t0).count();
+    }
+    {
+        std::vector<float> means(num_tracks * 8), covs(num_tracks * 64);
+        for (int i = 0; i < num_tracks; i++) {
+            kf.initiate(&z[i * steps * 4], &means[i * 8], &covs[i * 64]);
+        }
+        long cycles = 0;
+        auto t0     = std::chrono::steady_clock::now();
+        auto t1     = t0;
+        for (int s = 0; std::chrono::duration<double>(t1 - t0).count() < seconds; s = (s + 1) % steps) {
+            for (int i = 0; i < num_tracks; i++) {
+                kf.predict(&means[i * 8], &covs[i * 64]);
+                kf.update(&means[i * 8], &covs[i * 64], &z[(i * steps + s) * 4]);
+            }
+            cycles += num_tracks;
+            t1 = std::chrono::steady_clock::now();
+        }
+        fast_rate = cycles / std::chrono::duration<double>(t1 - t0).count();
+    }
+
+    printf("%-10s %12s\n", "path", "Mtracks/s");
+    printf("%-10s %12.2f\n", "dense", dense_rate * 1e-6);
+    printf("%-10s %12.2f   %.2fx\n", "structured", fast_rate * 1e-6, fast_rate / dense_rate);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,865 @@
+/*
+ * Replays a detection stream through every association mode of the tracker and reports
+ * speed, per-stage timing and tracking accuracy (MOTA, IDF1) of each mode relative to
+ * LAPJV, optionally checking them against a saved baseline.
+ *
+ *   bt_replay [--det det.csv [--gt gt.csv] | --bin seq.btrp] [--frame-rate N] [--repeat N]
+ *             [--frames N] [--objects N] [--seed N] [--features] [--save-bin seq.btrp]
+ *             [--save-baseline file | --check file] [--tolerance X] [--perf-tolerance X]
+ *             [--dump prefix] [--streams N] [--workers N] [--soak N [--soak-interval N]]
+ *
+ * CSV rows follow the MOTChallenge layout: frame,id,x,y,w,h,score[,label], frames
+ * counted from 1. Without --gt, the id column of the detection file is used as the
+ * ground-truth identity of each detection (-1 for clutter). Without an input, a synthetic
+ * scene of --objects moving boxes over --frames frames is generated; --features gives
+ * every synthetic object a noisy appearance embedding and adds a run with the appearance
+ * stage enabled.
+ *
+ * The binary format (.btrp, little-endian) holds the same data more compactly:
+ *   "BTRP", u32 version = 1, u32 num_frames, u32 feature_dim (0 or BT_FEATURE_DIM)
+ *   per frame: u32 num_dets, u32 num_gt,
+ *              num_dets x {f32 x, y, w, h, score; i32 label},
+ *              num_dets x feature_dim f32,
+ *              num_gt x {i32 id; f32 x, y, w, h}
+ *
+ * --save-baseline writes the metrics and time per frame of every mode; --check compares
+ * a run against such a file and exits with 1 when MOTA or IDF1 drop by more than
+ * --tolerance (default 0.002) or a mode gets slower by more than --perf-tolerance
+ * (default 0.25, i.e. 25%; negative disables the timing check). --dump writes the
+ * tracker output of every mode as <prefix>_<mode>.csv in MOTChallenge layout.
+ *
+ * With --streams, the stream is also fed to that many streams of a tracker manager and
+ * each stream's output is checked against the single-threaded LAPJV run.
+ *
+ * Global operator new/delete are replaced by counting versions, so every mode also reports
+ * the p50/p99/max update latency from a log-linear histogram and the number of heap
+ * allocations made inside bt_tracker_update*, in total and over the second half of the
+ * stream (which should be zero once the tracker has warmed up).
+ *
+ * --soak N skips the comparison and instead feeds N frames, cycling through the input, to
+ * one LAPJV tracker, so track ids keep growing as in a long-running device. Every
+ * --soak-interval frames (default 100000) it prints the latency percentiles of that
+ * interval, the allocations made by the tracker and the process RSS, and at the end the
+ * drift of the last interval against the first; both should stay flat.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bytetrack_c_api.h"
+#include "bytetrack_manager.h"
+#include "lapjv.h"
+
+static std::atomic<uint64_t> g_allocs(0);
+
+// Every operator new and delete goes through these two. They are kept out of line so that GCC
+// never sees a malloc()/free() inlined into a caller next to a different new/delete form,
+// which it reports as -Wmismatched-new-delete.
+__attribute__((noinline)) static void* counted_alloc(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+__attribute__((noinline)) static void counted_free(void* p) { free(p); }
+
+void* operator new(size_t size) {
+    void* p = counted_alloc(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) {
+    void* p = counted_alloc(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void  operator delete(void* p) noexcept { counted_free(p); }
+void  operator delete[](void* p) noexcept { counted_free(p); }
+void  operator delete(void* p, size_t) noexcept { counted_free(p); }
+void  operator delete[](void* p, size_t) noexcept { counted_free(p); }
+void  operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void  operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+
+
+// Log-linear latency histogram in nanoseconds: exact below 64 ns, then 64 buckets per
+// power of two (under 1.6% relative error), with a fixed footprint.
+struct Histogram {
+    static const int kSub = 64;
+    uint64_t         counts[kSub * 59] = {};
+    uint64_t         total             = 0;
+    int64_t          max_ns            = 0;
+
+    static int index(uint64_t v) {
+        if (v < kSub) return int(v);
+        int e = 63 - __builtin_clzll(v);
+        return (e - 5) * kSub + int((v >> (e - 6)) & (kSub - 1));
+    }
+    static uint64_t value(int i) {
+        if (i < kSub) return i;
+        int e = i / kSub + 5;
+        return uint64_t(kSub + i % kSub) << (e - 6);
+    }
+    void add(int64_t ns) {
+        ns = std::max<int64_t>(ns, 0);
+        counts[index(ns)]++;
+        total++;
+        max_ns = std::max(max_ns, ns);
+    }
+    void clear() { *this = Histogram(); }
+    double percentile_us(double p) const {
+        uint64_t rank = uint64_t(p * total), seen = 0;
+        for (int i = 0; i < kSub * 59; i++) {
+            seen += counts[i];
+            if (seen > rank) return value(i) * 1e-3;
+        }
+        return max_ns * 1e-3;
+    }
+};
+
+struct Box {
+    int   id;
+    float tlwh[4];
+};
+
+struct Frame {
+    std::vector<bt_bbox_t> dets;
+    std::vector<float>     features;  // BT_FEATURE_DIM per detection, empty if none
+    std::vector<Box>       gt;
+};
+
+struct Metrics {
+    int    num_gt;
+    int    num_hyp;
+    int    fp;
+    int    fn;
+    int    idsw;
+    double mota;
+    double idf1;
+};
+
+struct Run {
+    double                        seconds;
+    bt_profile_t                  profile;
+    std::vector<std::vector<Box>> hyps;
+    Histogram                     latency;
+    uint64_t                      allocs;         // inside bt_tracker_update*, whole stream
+    uint64_t                      steady_allocs;  // same, second half of the stream
+};
+
+static float iou(const float* a, const float* b) {
+    float iw = std::min(a[0] + a[2], b[0] + b[2]) - std::max(a[0], b[0]);
+    float ih = std::min(a[1] + a[3], b[1] + b[3]) - std::max(a[1], b[1]);
+    if (iw <= 0 || ih <= 0) return 0.f;
+    float inter = iw * ih;
+    return inter / (a[2] * a[3] + b[2] * b[3] - inter);
+}
+
+// Minimum-cost assignment on a rows x cols matrix padded to a square with pad_cost;
+// returns the column of every row, or -1 for padding.
+static std::vector<int> assign(std::vector<float>& cost, int rows, int cols, float pad_cost, lapjv_workspace_t* ws) {
+    const int          n = std::max(rows, cols);
+    std::vector<float> square(n * n, pad_cost);
+    for (int i = 0; i < rows; i++) {
+        std::copy(&cost[i * cols], &cost[i * cols] + cols, &square[i * n]);
+    }
+    std::vector<int> x(n, -1), y(n, -1), res(rows, -1);
+    if (n == 0 || lapjv_flat(n, square.data(), x.data(), y.data(), ws) != 0) return res;
+    for (int i = 0; i < rows; i++) {
+        if (x[i] >= 0 && x[i] < cols) res[i] = x[i];
+    }
+    return res;
+}
+
+static bool load_csv(const char* path, std::vector<Frame>& frames, bool as_gt, bool ids_as_gt) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        int   frame = 0, id = -1, label = 0;
+        float x, y, w, h, score = 1.f;
+        int   n = sscanf(line, "%d,%d,%f,%f,%f,%f,%f,%d", &frame, &id, &x, &y, &w, &h, &score, &label);
+        if (n < 6 || frame < 1) continue;
+        if ((int)frames.size() < frame) frames.resize(frame);
+        Frame& fr = frames[frame - 1];
+        Box    box{id, {x, y, w, h}};
+        if (as_gt) {
+            fr.gt.push_back(box);
+            continue;
+        }
+        bt_bbox_t det = {{x, y, w, h}, score, label, 0};
+        fr.dets.push_back(det);
+        if (ids_as_gt && id >= 0) fr.gt.push_back(box);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool load_bin(const char* path, std::vector<Frame>& frames) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char     magic[4];
+    uint32_t header[3];
+    bool     ok = fread(magic, 1, 4, f) == 4 && !memcmp(magic, "BTRP", 4) && fread(header, 4, 3, f) == 3 &&
+              header[0] == 1 && (header[2] == 0 || header[2] == BT_FEATURE_DIM);
+    if (ok) frames.assign(header[1], Frame());
+    for (size_t i = 0; ok && i < frames.size(); i++) {
+        Frame&   fr = frames[i];
+        uint32_t counts[2];
+        ok = fread(counts, 4, 2, f) == 2;
+        if (!ok) break;
+        fr.dets.resize(counts[0]);
+        for (auto& det : fr.dets) {
+            ok           = ok && fread(det.tlwh, 4, 4, f) == 4 && fread(&det.prob, 4, 1, f) == 1 &&
+                 fread(&det.label, 4, 1, f) == 1;
+            det.track_id = 0;
+        }
+        fr.features.resize(size_t(counts[0]) * header[2]);
+        ok = ok && fread(fr.features.data(), 4, fr.features.size(), f) == fr.features.size();
+        fr.gt.resize(counts[1]);
+        for (auto& box : fr.gt) {
+            ok = ok && fread(&box.id, 4, 1, f) == 1 && fread(box.tlwh, 4, 4, f) == 4;
+        }
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s is not a valid BTRP v1 file\n", path);
+    return ok;
+}
+
+static bool save_bin(const char* path, const std::vector<Frame>& frames) {
+    FILE* f = fopen(path, "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot create %s\n", path);
+        return false;
+    }
+    uint32_t feature_dim = 0;
+    for (const Frame& fr : frames) {
+        if (!fr.features.empty()) feature_dim = BT_FEATURE_DIM;
+    }
+    const uint32_t header[3] = {1, uint32_t(frames.size()), feature_dim};
+    fwrite("BTRP", 1, 4, f);
+    fwrite(header, 4, 3, f);
+    for (const Frame& fr : frames) {
+        const uint32_t counts[2] = {uint32_t(fr.dets.size()), uint32_t(fr.gt.size())};
+        fwrite(counts, 4, 2, f);
+        for (const auto& det : fr.dets) {
+            fwrite(det.tlwh, 4, 4, f);
+            fwrite(&det.prob, 4, 1, f);
+            fwrite(&det.label, 4, 1, f);
+        }
+        std::vector<float> features(fr.features);
+        features.resize(fr.dets.size() * feature_dim, 0.f);
+        fwrite(features.data(), 4, features.size(), f);
+        for (const auto& box : fr.gt) {
+            fwrite(&box.id, 4, 1, f);
+            fwrite(box.tlwh, 4, 4, f);
+        }
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+static void dump_tracks(const char* prefix, const char* mode, const std::vector<std::vector<Box>>& hyps) {
+    std::string path = std::string(prefix) + "_" + mode + ".csv";
+    FILE*       f    = fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot create %s\n", path.c_str());
+        return;
+    }
+    for (size_t i = 0; i < hyps.size(); i++) {
+        for (const Box& b : hyps[i]) {
+            fprintf(f, "%zu,%d,%.2f,%.2f,%.2f,%.2f,1\n", i + 1, b.id, b.tlwh[0], b.tlwh[1], b.tlwh[2], b.tlwh[3]);
+        }
+    }
+    fclose(f);
+}
+
+struct BaselineEntry {
+    std::string name;
+    double      mota;
+    double      idf1;
+    double      us_per_frame;
+};
+
+static std::vector<BaselineEntry> load_baseline(const char* path) {
+    std::vector<BaselineEntry> entries;
+    FILE*                      f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return entries;
+    }
+    char          name[32];
+    BaselineEntry e;
+    while (fscanf(f, "%31s %lf %lf %lf", name, &e.mota, &e.idf1, &e.us_per_frame) == 4) {
+        e.name = name;
+        entries.push_back(e);
+    }
+    fclose(f);
+    return entries;
+}
+
+// Boxes move with occasional turns and go through multi-frame occlusions on top of
+// independent misses, which is what breaks IoU-only re-association.
+static void synthesize(std::vector<Frame>& frames, int num_frames, int num_objects, unsigned seed, bool features) {
+    srand(seed);
+    auto rnd = []() { return rand() / float(RAND_MAX); };
+
+    struct Object {
+        float x, y, vx, vy, w, h;
+        int   born, die, label, occluded;
+    };
+    std::vector<Object> objects(num_objects * 3);
+    std::vector<float>  identity(objects.size() * BT_FEATURE_DIM);
+    for (auto& v : identity) v = rnd() - .5f;
+    for (auto& o : objects) {
+        o.x        = rnd() * 1280;
+        o.y        = rnd() * 720;
+        o.vx       = (rnd() - .5f) * 8;
+        o.vy       = (rnd() - .5f) * 8;
+        o.w        = 20 + rnd() * 80;
+        o.h        = 30 + rnd() * 120;
+        o.born     = int(rnd() * num_frames * 0.7f);
+        o.die      = o.born + 20 + int(rnd() * num_frames);
+        o.label    = int(rnd() * 3);
+        o.occluded = 0;
+    }
+
+    frames.assign(num_frames, Frame());
+    for (int f = 0; f < num_frames; f++) {
+        for (size_t i = 0; i < objects.size(); i++) {
+            Object& o = objects[i];
+            if (f < o.born || f > o.die) continue;
+            if (f > o.born) {
+                if (rnd() < 0.02f) {
+                    o.vx = (rnd() - .5f) * 8;
+                    o.vy = (rnd() - .5f) * 8;
+                }
+                o.x += o.vx;
+                o.y += o.vy;
+            }
+            Box box = {int(i), {o.x, o.y, o.w, o.h}};
+            frames[f].gt.push_back(box);
+
+            if (o.occluded > 0) {
+                o.occluded--;
+                continue;
+            }
+            if (rnd() < 0.01f) {
+                o.occluded = 5 + int(rnd() * 20);
+                continue;
+            }
+            if (rnd() < 0.08f) continue;  // missed detection
+
+            bt_bbox_t det;
+            det.tlwh[0]  = box.tlwh[0] + (rnd() - .5f) * 4;
+            det.tlwh[1]  = box.tlwh[1] + (rnd() - .5f) * 4;
+            det.tlwh[2]  = box.tlwh[2] + (rnd() - .5f) * 3;
+            det.tlwh[3]  = box.tlwh[3] + (rnd() - .5f) * 3;
+            det.prob     = rnd() < 0.2f ? 0.2f + rnd() * 0.3f : 0.5f + rnd() * 0.5f;
+            det.label    = o.label;
+            det.track_id = 0;
+            frames[f].dets.push_back(det);
+            for (int k = 0; features && k < BT_FEATURE_DIM; k++) {
+                frames[f].features.push_back(identity[i * BT_FEATURE_DIM + k] + (rnd() - .5f) * 0.3f);
+            }
+        }
+    }
+}
+
+static void replay(const std::vector<Frame>& frames, bt_config_t config, int repeat, Run& run) {
+    run.seconds = 1e30;
+    std::unique_ptr<Histogram> latency(new Histogram());
+    for (int r = 0; r < repeat; r++) {
+        bt_handler_t tracker = bt_tracker_create(&config);
+        std::vector<std::vector<Box>> hyps(frames.size());
+        double                        seconds = 0;
+        uint64_t                      allocs = 0, steady_allocs = 0;
+        std::vector<bt_bbox_t>        tracks(config.max_tracks);
+        latency->clear();
+        for (size_t f = 0; f < frames.size(); f++) {
+            size_t   num_tracks = 0;
+            uint64_t allocs0    = g_allocs.load(std::memory_order_relaxed);
+            auto     t0         = std::chrono::steady_clock::now();
+            bt_tracker_update_with_features(tracker,
+                                            frames[f].dets.data(),
+                                            frames[f].features.empty() ? nullptr : frames[f].features.data(),
+                                            frames[f].dets.size(),
+                                            tracks.data(),
+                                            tracks.size(),
+                                            &num_tracks);
+            auto     elapsed = std::chrono::steady_clock::now() - t0;
+            uint64_t n       = g_allocs.load(std::memory_order_relaxed) - allocs0;
+            seconds += std::chrono::duration<double>(elapsed).count();
+            latency->add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            allocs += n;
+            if (f >= frames.size() / 2) steady_allocs += n;
+            for (size_t i = 0; i < num_tracks; i++) {
+                const bt_bbox_t& t = tracks[i];
+                hyps[f].push_back({t.track_id, {t.tlwh[0], t.tlwh[1], t.tlwh[2], t.tlwh[3]}});
+            }
+        }
+        bt_profile_t profile = {};
+        bt_tracker_get_profile(tracker, &profile, false);
+        bt_tracker_destroy(tracker);
+        if (seconds < run.seconds) {
+            run.seconds       = seconds;
+            run.profile       = profile;
+            run.latency       = *latency;
+            run.allocs        = allocs;
+            run.steady_allocs = steady_allocs;
+            run.hyps.swap(hyps);
+        }
+    }
+}
+
+// CLEAR-MOT accounting at IoU 0.5, keeping last frame's correspondences when they still
+// overlap, and IDF1 from the best one-to-one mapping of ground-truth to track identities.
+static Metrics evaluate(const std::vector<Frame>& frames, const std::vector<std::vector<Box>>& hyps) {
+    const float         thresh = 0.5f;
+    Metrics             m      = {};
+    lapjv_workspace_t   ws     = {};
+    std::map<int, int>  last;
+    std::map<std::pair<int, int>, int> overlap;
+
+    for (size_t f = 0; f < frames.size(); f++) {
+        const std::vector<Box>& gt = frames[f].gt;
+        const std::vector<Box>& hy = hyps[f];
+        m.num_gt += gt.size();
+        m.num_hyp += hy.size();
+
+        for (const Box& g : gt) {
+            for (const Box& h : hy) {
+                if (iou(g.tlwh, h.tlwh) >= thresh) overlap[std::make_pair(g.id, h.id)]++;
+            }
+        }
+
+        std::vector<int> gt_match(gt.size(), -1), hy_used(hy.size(), 0);
+        for (size_t i = 0; i < gt.size(); i++) {
+            auto it = last.find(gt[i].id);
+            if (it == last.end()) continue;
+            for (size_t j = 0; j < hy.size(); j++) {
+                if (!hy_used[j] && hy[j].id == it->second && iou(gt[i].tlwh, hy[j].tlwh) >= thresh) {
+                    gt_match[i] = j;
+                    hy_used[j]  = 1;
+                    break;
+                }
+            }
+        }
+
+        std::vector<int> rows, cols;
+        for (size_t i = 0; i < gt.size(); i++) {
+            if (gt_match[i] < 0) rows.push_back(i);
+        }
+        for (size_t j = 0; j < hy.size(); j++) {
+            if (!hy_used[j]) cols.push_back(j);
+        }
+        std::vector<float> cost(rows.size() * cols.size(), 1.f);
+        for (size_t r = 0; r < rows.size(); r++) {
+            for (size_t c = 0; c < cols.size(); c++) {
+                float v = iou(gt[rows[r]].tlwh, hy[cols[c]].tlwh);
+                if (v >= thresh) cost[r * cols.size() + c] = 1.f - v;
+            }
+        }
+        std::vector<int> res = assign(cost, rows.size(), cols.size(), 1.f, &ws);
+        for (size_t r = 0; r < rows.size(); r++) {
+            if (res[r] >= 0 && cost[r * cols.size() + res[r]] < 1.f) gt_match[rows[r]] = cols[res[r]];
+        }
+
+        int matched = 0;
+        for (size_t i = 0; i < gt.size(); i++) {
+            if (gt_match[i] < 0) continue;
+            matched++;
+            int  id = hy[gt_match[i]].id;
+            auto it = last.find(gt[i].id);
+            if (it != last.end() && it->second != id) m.idsw++;
+            last[gt[i].id] = id;
+        }
+        m.fn += gt.size() - matched;
+        m.fp += hy.size() - matched;
+    }
+
+    std::map<int, int> gt_index, hy_index;
+    for (const auto& kv : overlap) {
+        gt_index.insert(std::make_pair(kv.first.first, (int)gt_index.size()));
+        hy_index.insert(std::make_pair(kv.first.second, (int)hy_index.size()));
+    }
+    int max_count = 0;
+    for (const auto& kv : overlap) max_count = std::max(max_count, kv.second);
+    std::vector<float> cost(gt_index.size() * hy_index.size(), float(max_count));
+    for (const auto& kv : overlap) {
+        cost[gt_index[kv.first.first] * hy_index.size() + hy_index[kv.first.second]] = float(max_count - kv.second);
+    }
+    std::vector<int> res   = assign(cost, gt_index.size(), hy_index.size(), float(max_count), &ws);
+    long             idtp  = 0;
+    for (size_t r = 0; r < res.size(); r++) {
+        if (res[r] >= 0) idtp += max_count - (long)cost[r * hy_index.size() + res[r]];
+    }
+    lapjv_workspace_free(&ws);
+
+    m.mota = m.num_gt ? 1.0 - double(m.fn + m.fp + m.idsw) / m.num_gt : 0.0;
+    m.idf1 = m.num_gt + m.num_hyp ? 2.0 * idtp / (m.num_gt + m.num_hyp) : 0.0;
+    return m;
+}
+
+struct StreamOutput {
+    std::mutex                    mutex;
+    std::vector<std::vector<Box>> hyps;
+    size_t                        frame = 0;
+};
+
+static void on_result(int stream, int64_t timestamp_us, const bt_bbox_t* tracks, size_t num_tracks, void* user_data) {
+    auto&                       out = reinterpret_cast<std::vector<StreamOutput>*>(user_data)->at(stream);
+    std::lock_guard<std::mutex> lock(out.mutex);
+    auto&                       hyps = out.hyps[out.frame++];
+    for (size_t i = 0; i < num_tracks; i++) {
+        hyps.push_back({tracks[i].track_id, {tracks[i].tlwh[0], tracks[i].tlwh[1], tracks[i].tlwh[2], tracks[i].tlwh[3]}});
+    }
+    (void)timestamp_us;
+}
+
+static bool same_tracks(const std::vector<std::vector<Box>>& a, const std::vector<std::vector<Box>>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t f = 0; f < a.size(); f++) {
+        if (a[f].size() != b[f].size()) return false;
+        for (size_t i = 0; i < a[f].size(); i++) {
+            if (a[f][i].id != b[f][i].id || memcmp(a[f][i].tlwh, b[f][i].tlwh, sizeof(a[f][i].tlwh))) return false;
+        }
+    }
+    return true;
+}
+
+static void replay_streams(const std::vector<Frame>&            frames,
+                           const bt_config_t&                   config,
+                           int                                  num_streams,
+                           int                                  num_workers,
+                           const std::vector<std::vector<Box>>& reference) {
+    std::vector<StreamOutput> outputs(num_streams);
+    for (auto& out : outputs) out.hyps.resize(frames.size());
+
+    bt_manager_config_t manager_config = BT_MANAGER_CONFIG_DEFAULT();
+    manager_config.num_streams         = num_streams;
+    manager_config.num_workers         = num_workers;
+    manager_config.queue_depth         = 8;
+    manager_config.result_cb           = on_result;
+    manager_config.user_data           = &outputs;
+    std::vector<bt_config_t> configs(num_streams, config);
+    bt_manager_handler_t     manager = bt_manager_create(&manager_config, configs.data());
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames.size(); f++) {
+        for (int s = 0; s < num_streams; s++) {
+            // a full queue means the workers are behind, wait for them rather than drop
+            while (bt_manager_submit(manager, s, int64_t(f), frames[f].dets.data(), frames[f].dets.size()) ==
+                   BT_ERR_BUFFER_TOO_SMALL) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    bt_manager_flush(manager);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("\n%d streams, %s workers: %.1f frames/s aggregate\n", num_streams,
+           num_workers > 0 ? std::to_string(num_workers).c_str() : "auto", frames.size() * num_streams / seconds);
+    printf("%-6s %8s %8s %8s %10s %10s %10s %10s %6s\n", "stream", "updates", "rejected", "dropped", "lat_avg",
+           "lat_max", "upd_avg", "upd_max", "match");
+    for (int s = 0; s < num_streams; s++) {
+        bt_stream_stats_t stats;
+        bt_manager_get_stats(manager, s, &stats);
+        printf("%-6d %8u %8u %8u %8lldus %8lldus %8lldus %8lldus %6s\n", s, stats.updates, stats.rejected, stats.dropped,
+
+               (long long)stats.latency_avg_us, (long long)stats.latency_max_us, (long long)stats.update_avg_us,
+               (long long)stats.update_max_us, same_tracks(outputs[s].hyps, reference) ? "yes" : "NO");
+    }
+    bt_manager_destroy(manager);
+}
+
+// resident set size from /proc/self/statm, 0 where that is not available
+static double rss_mb() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) return 0;
+    long pages = 0, resident = 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * double(sysconf(_SC_PAGESIZE)) / (1 << 20);
+}
+
+static void soak(const std::vector<Frame>& frames, const bt_config_t& config, uint64_t num_frames, uint64_t interval) {
+    std::unique_ptr<Histogram> latency(new Histogram());
+    std::vector<bt_bbox_t>     tracks(config.max_tracks);
+    bt_handler_t               tracker = bt_tracker_create(&config);
+    double                     first_p50 = 0, first_p99 = 0, first_rss = 0;
+    double                     last_p50 = 0, last_p99 = 0, last_rss = 0;
+    uint64_t                   allocs = 0;
+    double                     seconds = 0;
+
+    printf("soak: %llu frames, report every %llu\n", (unsigned long long)num_frames, (unsigned long long)interval);
+    printf("%12s %10s %10s %10s %10s %10s %10s\n", "frames", "us/frame", "p50", "p99", "max", "allocs", "RSS MB");
+    for (uint64_t n = 0; n < num_frames; n++) {
+        const Frame& fr         = frames[n % frames.size()];
+        size_t       num_tracks = 0;
+        uint64_t     allocs0    = g_allocs.load(std::memory_order_relaxed);
+        auto         t0         = std::chrono::steady_clock::now();
+        bt_tracker_update_with_features(tracker, fr.dets.data(), fr.features.empty() ? nullptr : fr.features.data(),
+                                        fr.dets.size(), tracks.data(), tracks.size(), &num_tracks);
+        auto elapsed = std::chrono::steady_clock::now() - t0;
+        allocs += g_allocs.load(std::memory_order_relaxed) - allocs0;
+        seconds += std::chrono::duration<double>(elapsed).count();
+        latency->add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+        if ((n + 1) % interval == 0 || n + 1 == num_frames) {
+            last_p50 = latency->percentile_us(0.5);
+            last_p99 = latency->percentile_us(0.99);
+            last_rss = rss_mb();
+            if (n < interval) {
+                first_p50 = last_p50;
+                first_p99 = last_p99;
+                first_rss = last_rss;
+            }
+            printf("%12llu %10.2f %10.2f %10.2f %10.2f %10llu %10.1f\n", (unsigned long long)(n + 1),
+                   seconds * 1e6 / latency->total, last_p50, last_p99, latency->max_ns * 1e-3,
+                   (unsigned long long)allocs, last_rss);
+            fflush(stdout);
+            latency->clear();
+            allocs  = 0;
+            seconds = 0;
+        }
+    }
+    bt_tracker_destroy(tracker);
+    printf("drift last vs first interval: p50 %+.1f%%, p99 %+.1f%%, RSS %+.2f MB\n",
+           first_p50 > 0 ? (last_p50 / first_p50 - 1) * 100 : 0.0, first_p99 > 0 ? (last_p99 / first_p99 - 1) * 100 : 0.0,
+           last_rss - first_rss);
+}
+
+int main(int argc, char** argv) {
+    const char* det_path   = nullptr;
+    const char* gt_path    = nullptr;
+    const char* bin_path   = nullptr;
+    const char* save_path  = nullptr;
+    const char* base_path  = nullptr;
+    const char* check_path = nullptr;
+    const char* dump       = nullptr;
+    double      tolerance  = 0.002;
+    double      perf_tol   = 0.25;
+    int         frame_rate = 30;
+    int         repeat     = 3;
+    int         num_frames = 600;
+    int         num_objs   = 40;
+    int         streams    = 0;
+    int         workers    = 0;
+    uint64_t    soak_n     = 0;
+    uint64_t    soak_every = 100000;
+    bool        features   = false;
+    unsigned    seed       = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "--features")) {
+            features = true;
+            continue;
+        }
+        const char* next = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (next == nullptr) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return 1;
+        }
+        if (!strcmp(arg, "--det"))
+            det_path = next;
+        else if (!strcmp(arg, "--gt"))
+            gt_path = next;
+        else if (!strcmp(arg, "--bin"))
+            bin_path = next;
+        else if (!strcmp(arg, "--save-bin"))
+            save_path = next;
+        else if (!strcmp(arg, "--save-baseline"))
+            base_path = next;
+        else if (!strcmp(arg, "--check"))
+            check_path = next;
+        else if (!strcmp(arg, "--tolerance"))
+            tolerance = atof(next);
+        else if (!strcmp(arg, "--perf-tolerance"))
+            perf_tol = atof(next);
+        else if (!strcmp(arg, "--dump"))
+            dump = next;
+        else if (!strcmp(arg, "--frame-rate"))
+            frame_rate = atoi(next);
+        else if (!strcmp(arg, "--repeat"))
+            repeat = std::max(1, atoi(next));
+        else if (!strcmp(arg, "--frames"))
+            num_frames = atoi(next);
+        else if (!strcmp(arg, "--objects"))
+            num_objs = atoi(next);
+        else if (!strcmp(arg, "--streams"))
+            streams = atoi(next);
+        else if (!strcmp(arg, "--workers"))
+            workers = atoi(next);
+        else if (!strcmp(arg, "--soak"))
+            soak_n = strtoull(next, nullptr, 10);
+        else if (!strcmp(arg, "--soak-interval"))
+            soak_every = std::max<uint64_t>(1, strtoull(next, nullptr, 10));
+        else if (!strcmp(arg, "--seed"))
+            seed = strtoul(next, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 1;
+        }
+        i++;
+    }
+
+    std::vector<Frame> frames;
+    if (bin_path != nullptr) {
+        if (!load_bin(bin_path, frames)) return 1;
+        for (const Frame& f : frames) {
+            if (!f.features.empty()) features = true;
+        }
+    } else if (det_path != nullptr) {
+        if (!load_csv(det_path, frames, false, gt_path == nullptr)) return 1;
+        if (gt_path != nullptr && !load_csv(gt_path, frames, true, false)) return 1;
+    } else {
+        synthesize(frames, num_frames, num_objs, seed, features);
+    }
+
+    if (save_path != nullptr && !save_bin(save_path, frames)) return 1;
+
+    size_t max_dets = 0, total_dets = 0;
+    for (const Frame& f : frames) {
+        max_dets = std::max(max_dets, f.dets.size());
+        total_dets += f.dets.size();
+    }
+    printf("%zu frames, %zu detections (max %zu per frame)\n\n", frames.size(), total_dets, max_dets);
+
+    if (soak_n > 0) {
+        if (frames.empty()) return 1;
+        bt_config_t config  = BT_CONFIG_DEFAULT();
+        config.frame_rate   = frame_rate;
+        config.track_buffer = 30;
+        config.max_tracks   = 512;
+        config.max_objects  = std::max<int>(max_dets, BT_DEFAULT_MAX_OBJECTS);
+        soak(frames, config, soak_n, soak_every);
+        return 0;
+    }
+
+    const struct {
+        bt_assign_mode_t mode;
+        int              feature_budget;
+        const char*      name;
+    } modes[] = {
+      {BT_ASSIGN_LAPJV, 0, "lapjv"},
+      {BT_ASSIGN_GREEDY, 0, "greedy"},
+      {BT_ASSIGN_AUTO, 0, "auto"},
+      {BT_ASSIGN_LAPJV, 8, "lapjv+app"},
+    };
+
+    printf("%-10s %8s %10s %8s %8s %8s %8s %8s %6s\n", "mode", "us/frame", "fps", "speedup", "MOTA", "dMOTA", "IDF1",
+           "dIDF1", "IDSW");
+    double                        base_seconds = 0;
+    Metrics                       base         = {};
+    bt_config_t                   base_config  = {};
+    std::vector<std::vector<Box>> base_hyps;
+    std::vector<BaselineEntry>    results;
+    std::vector<bt_profile_t>     profiles;
+    std::vector<std::unique_ptr<Run>> runs;
+    for (const auto& m : modes) {
+        if (m.feature_budget > 0 && !features) continue;
+
+        bt_config_t config    = BT_CONFIG_DEFAULT();
+        config.frame_rate     = frame_rate;
+        config.track_buffer   = 30;
+        config.max_tracks     = 512;
+        config.max_objects    = std::max<int>(max_dets, BT_DEFAULT_MAX_OBJECTS);
+        config.assign_mode    = m.mode;
+        config.feature_budget = m.feature_budget;
+
+        runs.emplace_back(new Run());
+        Run& run = *runs.back();
+        replay(frames, config, repeat, run);
+        Metrics met = evaluate(frames, run.hyps);
+        if (m.mode == BT_ASSIGN_LAPJV && m.feature_budget == 0) {
+            base_seconds = run.seconds;
+            base         = met;
+            base_config  = config;
+            base_hyps    = run.hyps;
+        }
+        printf("%-10s %8.2f %10.1f %7.2fx %8.4f %+8.4f %8.4f %+8.4f %6d\n", m.name, run.seconds * 1e6 / frames.size(),
+               frames.size() / run.seconds, base_seconds / run.seconds, met.mota, met.mota - base.mota, met.idf1,
+               met.idf1 - base.idf1, met.idsw);
+
+        results.push_back({m.name, met.mota, met.idf1, run.seconds * 1e6 / frames.size()});
+        profiles.push_back(run.profile);
+        if (dump != nullptr) dump_tracks(dump, m.name, run.hyps);
+    }
+
+    if (!profiles.empty() && profiles[0].frames != 0) {
+        printf("\n%-10s %10s %10s %10s %10s   (us/frame)\n", "stage", "predict", "iou", "assign", "bookkeep");
+        for (size_t i = 0; i < profiles.size(); i++) {
+            const bt_profile_t& p    = profiles[i];
+            const double        norm = 1e-3 / std::max<uint32_t>(1, p.frames);
+            const int64_t       rest = p.total_ns - p.predict_ns - p.iou_ns - p.assign_ns;
+            printf("%-10s %10.2f %10.2f %10.2f %10.2f\n", results[i].name.c_str(), p.predict_ns * norm, p.iou_ns * norm,
+                   p.assign_ns * norm, rest * norm);
+        }
+    }
+
+    printf("\n%-10s %10s %10s %10s %10s %10s   (update latency in us, heap allocations)\n", "mode", "p50", "p99",
+           "max", "allocs", "steady");
+    for (size_t i = 0; i < runs.size(); i++) {
+        const Run& r = *runs[i];
+        printf("%-10s %10.2f %10.2f %10.2f %10llu %10llu\n", results[i].name.c_str(), r.latency.percentile_us(0.5),
+               r.latency.percentile_us(0.99), r.latency.max_ns * 1e-3, (unsigned long long)r.allocs,
+               (unsigned long long)r.steady_allocs);
+    }
+
+    if (base_path != nullptr) {
+        FILE* f = fopen(base_path, "w");
+        if (f == nullptr) {
+            fprintf(stderr, "cannot create %s\n", base_path);
+            return 1;
+        }
+        for (const auto& r : results) {
+            fprintf(f, "%s %.6f %.6f %.3f\n", r.name.c_str(), r.mota, r.idf1, r.us_per_frame);
+        }
+        fclose(f);
+    }
+
+    int failures = 0;
+    if (check_path != nullptr) {
+        std::vector<BaselineEntry> baseline = load_baseline(check_path);
+        if (baseline.empty()) return 1;
+        printf("\n");
+        for (const auto& r : results) {
+            auto it = std::find_if(baseline.begin(), baseline.end(), [&](const BaselineEntry& b) { return b.name == r.name; });
+            if (it == baseline.end()) continue;
+            bool accuracy = r.mota >= it->mota - tolerance && r.idf1 >= it->idf1 - tolerance;
+            bool speed    = perf_tol < 0 || r.us_per_frame <= it->us_per_frame * (1 + perf_tol);
+            printf("%-10s MOTA %+.4f IDF1 %+.4f time %+6.1f%%  %s\n", r.name.c_str(), r.mota - it->mota,
+                   r.idf1 - it->idf1, (r.us_per_frame / it->us_per_frame - 1) * 100,
+                   accuracy && speed ? "ok" : (accuracy ? "SLOWER" : "REGRESSED"));
+            failures += !(accuracy && speed);
+        }
+    }
+
+    if (streams > 0) {
+        replay_streams(frames, base_config, streams, workers, base_hyps);
+    }
+    return failures ? 1 : 0;
+}
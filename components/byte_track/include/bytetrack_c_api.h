@@ -28,11 +28,83 @@ bt_handler_t bt_tracker_create(const bt_config_t* config);
  * @param tracks Output array of tracks
  * @param num_tracks Number of tracks in the output array
  * @return Error code
- * @note The caller is responsible for freeing the memory of the output tracks array
+ * @note If *tracks is NULL the array is allocated and the caller is responsible for freeing it,
+ *       otherwise up to *num_tracks tracks are written into it and *num_tracks is set to the count written
 */
 bt_error_t bt_tracker_update(
   bt_handler_t tracker, const bt_bbox_t* objects, size_t num_objects, bt_bbox_t** tracks, size_t* num_tracks);
 
+/**
+ * @brief Update the tracker and write the active tracks into a caller-owned buffer
+ * @param tracker BYTETrack handler
+ * @param objects Array of objects to update the tracker with
+ * @param num_objects Number of objects in the array
+ * @param tracks Caller-owned array of at least capacity entries, may be NULL if capacity is 0
+ * @param capacity Number of entries tracks can hold
+ * @param num_tracks Optional, set to the number of active tracks, which can exceed capacity
+ * @return BT_ERR_OK, or BT_ERR_BUFFER_TOO_SMALL if only the first capacity tracks were written
+ * @note Never allocates, a capacity of bt_config_t::max_tracks is always enough
+*/
+bt_error_t bt_tracker_update_into(bt_handler_t     tracker,
+                                  const bt_bbox_t* objects,
+                                  size_t           num_objects,
+                                  bt_bbox_t*       tracks,
+                                  size_t           capacity,
+                                  size_t*          num_tracks);
+
+/**
+ * @brief Update the tracker with objects and their appearance embeddings
+ * @param tracker BYTETrack handler
+ * @param objects Array of objects to update the tracker with
+ * @param features num_objects x BT_FEATURE_DIM row-major embeddings, one per object, or NULL
+ * @param num_objects Number of objects in the array
+ * @param tracks Caller-owned array of at least capacity entries, may be NULL if capacity is 0
+ * @param capacity Number of entries tracks can hold
+ * @param num_tracks Optional, set to the number of active tracks, which can exceed capacity
+ * @return BT_ERR_OK, or BT_ERR_BUFFER_TOO_SMALL if only the first capacity tracks were written
+ * @note Embeddings are only used when bt_config_t::feature_budget is non-zero. Tracks and
+ *       detections left unmatched by IoU are then matched on cosine distance to each track's
+ *       recent embeddings, gated by the Mahalanobis distance of the Kalman prediction.
+*/
+bt_error_t bt_tracker_update_with_features(bt_handler_t     tracker,
+                                           const bt_bbox_t* objects,
+                                           const float*     features,
+                                           size_t           num_objects,
+                                           bt_bbox_t*       tracks,
+                                           size_t           capacity,
+                                           size_t*          num_tracks);
+
+/**
+ * @brief Visit the active tracks of the last update without copying them
+ * @param tracker BYTETrack handler
+ * @param visitor Called once per active track in output order, returns false to stop
+ * @param user_data Passed through to the visitor
+ * @return Error code
+ * @note The views point into the tracker and are only valid until its next update
+*/
+bt_error_t bt_tracker_foreach(bt_handler_t tracker, bt_track_visitor_t visitor, void* user_data);
+
+/**
+ * @brief Get the per-stage update timing of a tracker
+ * @param tracker BYTETrack handler
+ * @param profile Output timing, everything not covered by a stage is bookkeeping
+ * @param reset Clear the counters after reading them
+ * @return BT_ERR_OK, or BT_ERR_FAIL if the component was built without BYTETRACK_PROFILE
+*/
+bt_error_t bt_tracker_get_profile(bt_handler_t tracker, bt_profile_t* profile, bool reset);
+
+/**
+ * @brief Get the number of new detections that were not tracked because the track pool was full
+ * @param tracker BYTETrack handler
+ * @param dropped Output count since creation or the last reset
+ * @param reset Clear the counter after reading it
+ * @return Error code
+ * @note The pool holds bt_config_t::max_tracks tracked and lost tracks. A dropped detection is
+ *       not lost for good, it starts a track in a later frame once a slot is free.
+*/
+bt_error_t bt_tracker_get_dropped(bt_handler_t tracker, uint32_t* dropped, bool reset);
+
+
 /**
  * @brief Destroy the BYTETrack handler
  * @param tracker BYTETrack handler
@@ -0,0 +1,65 @@
+#ifndef BYTETRACK_MANAGER_H
+#define BYTETRACK_MANAGER_H
+
+/**
+ * @file bytetrack_manager.h
+ * @brief BYTETrack multi-stream manager, one tracker per stream updated by a shared worker pool
+ * @version 1.0.0
+*/
+
+#include "bytetracl_c_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create a tracker manager and its worker threads
+ * @param config Manager configuration
+ * @param stream_configs Array of num_streams tracker configurations, or NULL for BT_CONFIG_DEFAULT() on every stream
+ * @return Manager handler, NULL on failure
+ * @note On ESP-IDF the workers are pinned round-robin to the available cores
+*/
+bt_manager_handler_t bt_manager_create(const bt_manager_config_t* config, const bt_config_t* stream_configs);
+
+/**
+ * @brief Queue a batch of detections for a stream
+ * @param manager Manager handler
+ * @param stream Stream index
+ * @param timestamp_us Capture time of the batch, passed back to the result callback
+ * @param objects Array of objects, copied into the stream queue
+ * @param num_objects Number of objects, at most the stream's bt_config_t::max_objects
+ * @return BT_ERR_OK, or BT_ERR_BUFFER_TOO_SMALL if the stream queue is full
+ * @note Batches of one stream are processed in submission order, never concurrently
+*/
+bt_error_t bt_manager_submit(
+  bt_manager_handler_t manager, int stream, int64_t timestamp_us, const bt_bbox_t* objects, size_t num_objects);
+
+/**
+ * @brief Wait until every queued batch has been processed
+ * @param manager Manager handler
+ * @return Error code
+*/
+bt_error_t bt_manager_flush(bt_manager_handler_t manager);
+
+/**
+ * @brief Get the counters and latency statistics of a stream
+ * @param manager Manager handler
+ * @param stream Stream index
+ * @param stats Output statistics
+ * @return Error code
+*/
+bt_error_t bt_manager_get_stats(bt_manager_handler_t manager, int stream, bt_stream_stats_t* stats);
+
+/**
+ * @brief Stop the workers and destroy the manager and its trackers, queued batches are discarded
+ * @param manager Manager handler
+ * @return Error code
+*/
+bt_error_t bt_manager_destroy(bt_manager_handler_t manager);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
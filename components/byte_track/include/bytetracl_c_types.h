@@ -8,11 +8,26 @@
 */
 
 #include <float.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
-#define BT_CONFIG_DEFAULT() \
-    { .frame_rate = 10, .track_buffer = 15, .track_thresh = 0.5, .high_thresh = 0.6, .match_thresh = 0.8, }
+#define BT_DEFAULT_MAX_TRACKS  64
+#define BT_DEFAULT_MAX_OBJECTS 64
+#define BT_FEATURE_DIM         128
+
+#define BT_MANAGER_CONFIG_DEFAULT()                                                                              \
+    {                                                                                                            \
+        .num_streams = 1, .num_workers = 0, .queue_depth = 4, .worker_stack_size = 8192, .worker_priority = 5,   \
+        .result_cb = NULL, .user_data = NULL,                                                                    \
+    }
+
+#define BT_CONFIG_DEFAULT()                                                                                      \
+    {                                                                                                            \
+        .frame_rate = 10, .track_buffer = 15, .track_thresh = 0.5, .high_thresh = 0.6, .match_thresh = 0.8,      \
+        .max_tracks = BT_DEFAULT_MAX_TRACKS, .max_objects = BT_DEFAULT_MAX_OBJECTS,                              \
+        .assign_mode = BT_ASSIGN_LAPJV, .feature_budget = 0, .appearance_thresh = 0.25,                          \
+    }
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,24 +40,96 @@ typedef struct bt_bbox_t {
     int   track_id;
 } bt_bbox_t;
 
+typedef enum {
+    BT_ASSIGN_LAPJV  = 0, /*!< Optimal assignment with LAPJV */
+    BT_ASSIGN_GREEDY = 1, /*!< Greedy lowest-cost-first IoU matching */
+    BT_ASSIGN_AUTO   = 2, /*!< Greedy when it is provably optimal for the frame, LAPJV otherwise */
+} bt_assign_mode_t;
+
 typedef struct bt_config_t {
-    int   frame_rate;
-    int   track_buffer;
-    float track_thresh;
-    float high_thresh;
-    float match_thresh;
+    int              frame_rate;
+    int              track_buffer;
+    float            track_thresh;
+    float            high_thresh;
+    float            match_thresh;
+    int              max_tracks;        /*!< Capacity of the preallocated track pool (tracked + lost), 0 for default.
+                                             New detections that find it full are not tracked and are counted,
+                                             see bt_tracker_get_dropped() */
+    int              max_objects;       /*!< Expected detections per frame, used to size scratch buffers, 0 for default */
+    bt_assign_mode_t assign_mode;       /*!< Association solver, LAPJV by default */
+    int              feature_budget;    /*!< Embeddings kept per track for appearance matching, 0 disables it */
+    float            appearance_thresh; /*!< Max cosine distance of an appearance match */
 } bt_config_t;
 
 typedef enum {
-    BT_ERR_OK              = 0,
-    BT_ERR_FAIL            = -1,
-    BT_ERR_INVALID_TRACKER = -2,
-    BT_ERR_INVALID_OBJECTS = -3,
-    BT_ERR_MEM_ALLOC_FAIL  = -5,
+    BT_ERR_OK               = 0,
+    BT_ERR_FAIL             = -1,
+    BT_ERR_INVALID_TRACKER  = -2,
+    BT_ERR_INVALID_OBJECTS  = -3,
+    BT_ERR_BUFFER_TOO_SMALL = -4,
+    BT_ERR_MEM_ALLOC_FAIL   = -5,
 } bt_error_t;
 
 typedef void* bt_handler_t;
 
+/**
+ * @brief Read-only view of an active track, valid until the next update of its tracker
+ */
+typedef struct bt_track_view_t {
+    const float* tlwh;
+    float        prob;
+    int          label;
+    int          track_id;
+} bt_track_view_t;
+
+/**
+ * @brief Track visitor, return false to stop the iteration
+ */
+typedef bool (*bt_track_visitor_t)(const bt_track_view_t* track, void* user_data);
+
+/**
+ * @brief Accumulated update time per stage, only collected when built with BYTETRACK_PROFILE
+ */
+typedef struct bt_profile_t {
+    uint32_t frames;     /*!< Updates since the last reset */
+    int64_t  total_ns;   /*!< Whole update */
+    int64_t  predict_ns; /*!< Batched Kalman predict */
+    int64_t  iou_ns;     /*!< IoU and appearance cost construction */
+    int64_t  assign_ns;  /*!< Linear assignment */
+} bt_profile_t;
+
+typedef void* bt_manager_handler_t;
+
+/**
+ * @brief Called from a worker thread with the tracks of one processed batch, valid only during the call
+ */
+typedef void (*bt_result_cb_t)(
+  int stream, int64_t timestamp_us, const bt_bbox_t* tracks, size_t num_tracks, void* user_data);
+
+typedef struct bt_manager_config_t {
+    int            num_streams;       /*!< Number of independent trackers */
+    int            num_workers;       /*!< Worker threads, 0 for one per core */
+    int            queue_depth;       /*!< Batches buffered per stream */
+    int            worker_stack_size; /*!< Worker stack size in bytes (ESP-IDF only) */
+    int            worker_priority;   /*!< Worker task priority (ESP-IDF only) */
+    bt_result_cb_t result_cb;         /*!< Result callback, may be NULL */
+    void*          user_data;         /*!< Passed through to result_cb */
+} bt_manager_config_t;
+
+typedef struct bt_stream_stats_t {
+    uint32_t updates;        /*!< Batches processed */
+    uint32_t rejected;       /*!< Batches refused because the stream queue was full */
+    uint32_t pending;        /*!< Batches queued or in progress */
+    uint32_t dropped;        /*!< New detections not tracked because the track pool was full */
+
+    int64_t  last_timestamp_us;
+    int64_t  latency_last_us; /*!< Submit to result callback return */
+    int64_t  latency_avg_us;
+    int64_t  latency_max_us;
+    int64_t  update_avg_us;   /*!< Time spent in the tracker update itself */
+    int64_t  update_max_us;
+} bt_stream_stats_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,7 @@
 
 #include "BYTETracker.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <utility>
 #include <vector>
@@ -17,206 +18,341 @@ BYTETracker::BYTETracker(int frame_rate, int track_buffer) {
     track_thresh = 0.5;
     high_thresh  = 0.6;
     match_thresh = 0.8;
+    assign_mode  = BT_ASSIGN_LAPJV;
 
-    frame_id      = 0;
-    max_time_lost = int(frame_rate / 30.0 * track_buffer);
+    feature_budget    = 0;
+    appearance_thresh = 0.25;
+
+    init(frame_rate, track_buffer, BT_DEFAULT_MAX_TRACKS, BT_DEFAULT_MAX_OBJECTS);
 }
 
 BYTETracker::BYTETracker(const bt_config_t* config) {
     track_thresh = config->track_thresh;
     high_thresh  = config->high_thresh;
     match_thresh = config->match_thresh;
+    assign_mode  = config->assign_mode;
+
+    feature_budget    = config->feature_budget > 0 ? config->feature_budget : 0;
+    appearance_thresh = config->appearance_thresh;
 
-    frame_id      = 0;
-    max_time_lost = int(config->frame_rate / 30.0 * config->track_buffer);
+    init(config->frame_rate, config->track_buffer, config->max_tracks, config->max_objects);
 }
 
-BYTETracker::~BYTETracker() {}
+BYTETracker::~BYTETracker() { lapjv_workspace_free(&lap_ws); }
 
-vector<STrack> BYTETracker::update(const bt_bbox_t* objects, size_t num_objects) {
-    ////////////////// Step 1: Get detections //////////////////
-    this->frame_id += 1;
+void BYTETracker::init(int frame_rate, int track_buffer, int max_tracks, int max_objects) {
+    frame_id           = 0;
+    track_id_count     = 0;
+    dropped_detections = 0;
+    profile            = bt_profile_t();
 
-    vector<STrack> activated_stracks;
-    vector<STrack> refind_stracks;
-    vector<STrack> removed_stracks;
-    vector<STrack> lost_stracks;
-    vector<STrack> detections;
-    vector<STrack> detections_low;
+    max_time_lost  = int(frame_rate / 30.0 * track_buffer);
 
-    vector<STrack> detections_cp;
-    vector<STrack> tracked_stracks_swap;
-    vector<STrack> resa, resb;
-    vector<STrack> output_stracks;
+    if (max_tracks <= 0) max_tracks = BT_DEFAULT_MAX_TRACKS;
+    if (max_objects <= 0) max_objects = BT_DEFAULT_MAX_OBJECTS;
 
-    vector<STrack*> unconfirmed;
-    vector<STrack*> tracked_stracks;
-    vector<STrack*> strack_pool;
-    vector<STrack*> r_tracked_stracks;
+    pool.resize(max_tracks);
+    states.resize(max_tracks);
+    slot_used.assign(max_tracks, 0);
+    slot_removed.assign(max_tracks, 0);
+    slot_mark.assign(max_tracks, 0);
+    free_slots.reserve(max_tracks);
+    for (int i = max_tracks - 1; i >= 0; --i) {
+        free_slots.push_back(i);
+    }
 
-    for (size_t i = 0; i < num_objects; ++i) {
-        vector<float> tlwh_;
-        tlwh_.resize(4);
+    for (auto* list : {&tracked_stracks,
+                       &lost_stracks,
+                       &output_stracks,
+                       &unconfirmed,
+                       &strack_pool,
+                       &r_tracked_stracks,
+                       &activated_stracks,
+                       &refind_stracks,
+                       &lost_now,
+                       &removed_now,
+                       &list_swap}) {
+        list->reserve(max_tracks);
+    }
+
+    detections.resize(max_objects);
+
+    has_features = false;
+    if (feature_budget > 0) {
+        gallery.setZero(max_tracks * feature_budget, BT_FEATURE_DIM);
+        det_features.setZero(max_objects, BT_FEATURE_DIM);
+        gallery_count.assign(max_tracks, 0);
+        gallery_head.assign(max_tracks, 0);
+    }
+    for (auto* list : {&det_high, &det_low, &det_rest}) {
+        list->reserve(max_objects);
+    }
+
+    const int max_dim = max_tracks > max_objects ? max_tracks : max_objects;
+    for (auto* list :
+         {&matches_a, &matches_b, &u_track, &u_detection, &u_unconfirmed, &u_app_track, &u_app_detection}) {
+        list->reserve(max_dim);
+    }
+
+    cost_rows = 0;
+    cost_cols = 0;
+    sp_start.reserve(max_dim + 1);
+    sp_entries.reserve(4 * max_dim);
+    sp_pairs.reserve(4 * max_dim);
+    sweep.reserve(max_tracks + max_objects);
+    for (auto* list : {&active_a, &active_b, &gate_row, &gate_col, &match_row, &match_col}) {
+        list->reserve(max_dim);
+    }
+    cost.reserve(max_dim * max_dim);
+    lap_x.reserve(max_dim);
+    lap_y.reserve(max_dim);
+    lap_ws = lapjv_workspace_t();
+    lapjv_workspace_reserve(&lap_ws, max_dim);
+}
+
+int BYTETracker::alloc_slot() {
+    if (free_slots.empty()) {
+        return -1;
+    }
+    int slot = free_slots.back();
+    free_slots.pop_back();
+    slot_used[slot]    = 1;
+    slot_removed[slot] = 0;
+    return slot;
+}
+
+void BYTETracker::release_unused_slots() {
+    std::fill(slot_mark.begin(), slot_mark.end(), 0);
+    for (int slot : tracked_stracks) slot_mark[slot] = 1;
+    for (int slot : lost_stracks) slot_mark[slot] = 1;
+
+    for (int slot = 0; slot < (int)pool.size(); ++slot) {
+        if (slot_used[slot] && !slot_mark[slot]) {
+            slot_used[slot] = 0;
+            free_slots.push_back(slot);
+        }
+    }
+}
+
+const vector<int>& BYTETracker::update(const bt_bbox_t* objects, size_t num_objects, const float* features) {
+    BT_PROFILE_SCOPE(profile.total_ns);
+    profile.frames++;
+
+    ////////////////// Step 1: Get detections //////////////////
+    this->frame_id += 1;
 
-        tlwh_[0] = objects[i].tlwh[0];
-        tlwh_[1] = objects[i].tlwh[1];
-        tlwh_[2] = objects[i].tlwh[2];
-        tlwh_[3] = objects[i].tlwh[3];
+    activated_stracks.clear();
+    refind_stracks.clear();
+    removed_now.clear();
+    lost_now.clear();
+    det_high.clear();
+    det_low.clear();
+    det_rest.clear();
+    list_swap.clear();
+    output_stracks.clear();
+    unconfirmed.clear();
+    strack_pool.clear();
+    r_tracked_stracks.clear();
+
+    if (detections.size() < num_objects) {
+        detections.resize(num_objects);
+    }
 
+    has_features = features != nullptr && feature_budget > 0;
+    if (has_features) {
+        if ((size_t)det_features.rows() < num_objects) {
+            det_features.resize(num_objects, BT_FEATURE_DIM);
+        }
+        for (size_t i = 0; i < num_objects; ++i) {
+            Eigen::Map<const FEATURE> feature(features + i * BT_FEATURE_DIM);
+            float                     norm = feature.norm();
+            if (norm > 0.f) {
+                det_features.row(i) = feature / norm;
+            } else {
+                det_features.row(i).setZero();
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num_objects; ++i) {
         float score = objects[i].prob;
+        detections[i].reset(objects[i].tlwh, score, objects[i].label);
         if (score >= track_thresh) {
-            detections.emplace_back(move(tlwh_), score, objects[i].label);
+            det_high.push_back(i);
         } else {
-            detections_low.emplace_back(move(tlwh_), score, objects[i].label);
+            det_low.push_back(i);
         }
     }
 
     // Add newly detected tracklets to tracked_stracks
-    for (size_t i = 0; i < this->tracked_stracks.size(); ++i) {
-        if (!this->tracked_stracks[i].is_activated)
-            unconfirmed.push_back(&this->tracked_stracks[i]);
+    for (int slot : this->tracked_stracks) {
+        if (!pool[slot].is_activated)
+            unconfirmed.push_back(slot);
         else
-            tracked_stracks.push_back(&this->tracked_stracks[i]);
+            strack_pool.push_back(slot);
     }
 
     ////////////////// Step 2: First association, with IoU //////////////////
-    strack_pool = joint_stracks(tracked_stracks, this->lost_stracks);
-    STrack::multi_predict(strack_pool, this->kalman_filter);
-
-    vector<vector<float> > dists;
-    int                    dist_size = 0, dist_size_size = 0;
-    dists = iou_distance(strack_pool, detections, dist_size, dist_size_size);
-
-    vector<vector<int> > matches;
-    vector<int>          u_track, u_detection;
-    linear_assignment(dists, dist_size, dist_size_size, match_thresh, matches, u_track, u_detection);
-
-    for (int i = 0; i < matches.size(); ++i) {
-        STrack* track = strack_pool[matches[i][0]];
-        STrack* det   = &detections[matches[i][1]];
-        if (track->state == TrackState::Tracked) {
-            track->update(*det, this->frame_id);
-            activated_stracks.push_back(*track);
+    // tracked and lost lists are disjoint, so joining them is a concatenation
+    strack_pool.insert(strack_pool.end(), this->lost_stracks.begin(), this->lost_stracks.end());
+    {
+        BT_PROFILE_SCOPE(profile.predict_ns);
+        STrack::multi_predict(pool.data(), strack_pool.data(), strack_pool.size(), this->kalman_filter, this->states);
+    }
+
+    iou_distance(strack_pool, pool.data(), det_high, detections.data());
+    linear_assignment(strack_pool.size(), det_high.size(), match_thresh, matches_a, matches_b, u_track, u_detection);
+
+    for (size_t i = 0; i < matches_a.size(); ++i) {
+        int     slot  = strack_pool[matches_a[i]];
+        STrack& track = pool[slot];
+        STrack& det   = detections[det_high[matches_b[i]]];
+        if (track.state == TrackState::Tracked) {
+            track.update(this->kalman_filter, this->states, slot, det, this->frame_id);
+            activated_stracks.push_back(slot);
         } else {
-            track->re_activate(*det, this->frame_id, false);
-            refind_stracks.push_back(*track);
+            track.re_activate(this->kalman_filter, this->states, slot, det, this->frame_id);
+            refind_stracks.push_back(slot);
         }
+        add_feature(slot, det_high[matches_b[i]]);
+    }
+
+    // tracks and high score detections left over by IoU get a second chance on appearance
+    if (has_features) {
+        appearance_association();
     }
 
     ////////////////// Step 3: Second association, using low score dets //////////////////
-    for (int i = 0; i < u_detection.size(); ++i) {
-        detections_cp.push_back(move(detections[u_detection[i]]));
+    for (int idx : u_detection) {
+        det_rest.push_back(det_high[idx]);
     }
-    detections.clear();
-    detections.assign(detections_low.begin(), detections_low.end());
 
-    for (int i = 0; i < u_track.size(); ++i) {
-        auto idx = u_track[i];
-        auto st  = strack_pool[idx];
-        if (st->state == TrackState::Tracked) {
-            r_tracked_stracks.push_back(st);
+    for (int idx : u_track) {
+        int slot = strack_pool[idx];
+        if (pool[slot].state == TrackState::Tracked) {
+            r_tracked_stracks.push_back(slot);
         }
     }
 
-    dists.clear();
-    dists = iou_distance(r_tracked_stracks, detections, dist_size, dist_size_size);
+    iou_distance(r_tracked_stracks, pool.data(), det_low, detections.data());
+    linear_assignment(r_tracked_stracks.size(), det_low.size(), 0.5, matches_a, matches_b, u_track, u_detection);
 
-    matches.clear();
-    u_track.clear();
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.5, matches, u_track, u_detection);
-
-    for (int i = 0; i < matches.size(); ++i) {
-        STrack* track = r_tracked_stracks[matches[i][0]];
-        STrack* det   = &detections[matches[i][1]];
-        if (track->state == TrackState::Tracked) {
-            track->update(*det, this->frame_id);
-            activated_stracks.push_back(*track);
+    for (size_t i = 0; i < matches_a.size(); ++i) {
+        int     slot  = r_tracked_stracks[matches_a[i]];
+        STrack& track = pool[slot];
+        STrack& det   = detections[det_low[matches_b[i]]];
+        if (track.state == TrackState::Tracked) {
+            track.update(this->kalman_filter, this->states, slot, det, this->frame_id);
+            activated_stracks.push_back(slot);
         } else {
-            track->re_activate(*det, this->frame_id, false);
-            refind_stracks.push_back(*track);
+            track.re_activate(this->kalman_filter, this->states, slot, det, this->frame_id);
+            refind_stracks.push_back(slot);
         }
+        add_feature(slot, det_low[matches_b[i]]);
     }
 
-    for (int i = 0; i < u_track.size(); ++i) {
-        STrack* track = r_tracked_stracks[u_track[i]];
-        if (track->state != TrackState::Lost) {
-            track->mark_lost();
-            lost_stracks.push_back(*track);
+    for (int idx : u_track) {
+        int     slot  = r_tracked_stracks[idx];
+        STrack& track = pool[slot];
+        if (track.state != TrackState::Lost) {
+            track.mark_lost();
+            lost_now.push_back(slot);
         }
     }
 
     // Deal with unconfirmed tracks, usually tracks with only one beginning frame
-    detections.clear();
-    detections.assign(detections_cp.begin(), detections_cp.end());
-
-    dists.clear();
-    dists = iou_distance(unconfirmed, detections, dist_size, dist_size_size);
-
-    matches.clear();
-    vector<int> u_unconfirmed;
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.7, matches, u_unconfirmed, u_detection);
-
-    for (int i = 0; i < matches.size(); ++i) {
-        unconfirmed[matches[i][0]]->update(detections[matches[i][1]], this->frame_id);
-        activated_stracks.push_back(*unconfirmed[matches[i][0]]);
+    iou_distance(unconfirmed, pool.data(), det_rest, detections.data());
+    linear_assignment(unconfirmed.size(), det_rest.size(), 0.7, matches_a, matches_b, u_unconfirmed, u_detection);
+
+    for (size_t i = 0; i < matches_a.size(); ++i) {
+        int slot = unconfirmed[matches_a[i]];
+        pool[slot].update(this->kalman_filter, this->states, slot, detections[det_rest[matches_b[i]]], this->frame_id);
+        add_feature(slot, det_rest[matches_b[i]]);
+        activated_stracks.push_back(slot);
     }
 
-    for (int i = 0; i < u_unconfirmed.size(); ++i) {
-        STrack* track = unconfirmed[u_unconfirmed[i]];
-        track->mark_removed();
-        removed_stracks.push_back(*track);
+    for (int idx : u_unconfirmed) {
+        int slot = unconfirmed[idx];
+        pool[slot].mark_removed();
+        removed_now.push_back(slot);
     }
 
     ////////////////// Step 4: Init new stracks //////////////////
-    for (int i = 0; i < u_detection.size(); ++i) {
-        STrack* track = &detections[u_detection[i]];
-        if (track->score < this->high_thresh) continue;
-        track->activate(this->kalman_filter, this->frame_id);
-        activated_stracks.push_back(*track);
+    for (int idx : u_detection) {
+        const STrack& det = detections[det_rest[idx]];
+        if (det.score < this->high_thresh) continue;
+        int slot = alloc_slot();
+        if (slot < 0) {
+            // pool exhausted, the detection is not tracked this frame
+            this->dropped_detections++;
+            continue;
+        }
+        pool[slot] = det;
+        pool[slot].activate(this->kalman_filter, this->states, slot, this->frame_id, ++this->track_id_count);
+        if (feature_budget > 0) {
+            gallery_count[slot] = 0;
+            gallery_head[slot]  = 0;
+        }
+        add_feature(slot, det_rest[idx]);
+        activated_stracks.push_back(slot);
     }
 
     ////////////////// Step 5: Update state //////////////////
-    for (int i = 0; i < this->lost_stracks.size(); ++i) {
-        if (this->frame_id - this->lost_stracks[i].end_frame() > this->max_time_lost) {
-            this->lost_stracks[i].mark_removed();
-            removed_stracks.push_back(this->lost_stracks[i]);
+    for (int slot : this->lost_stracks) {
+        if (this->frame_id - pool[slot].end_frame() > this->max_time_lost) {
+            pool[slot].mark_removed();
+            removed_now.push_back(slot);
         }
     }
 
-    for (int i = 0; i < this->tracked_stracks.size(); ++i) {
-        if (this->tracked_stracks[i].state == TrackState::Tracked) {
-            tracked_stracks_swap.push_back(this->tracked_stracks[i]);
+    std::fill(slot_mark.begin(), slot_mark.end(), 0);
+    for (int slot : this->tracked_stracks) {
+        if (pool[slot].state == TrackState::Tracked) {
+            list_swap.push_back(slot);
+            slot_mark[slot] = 1;
         }
     }
-    this->tracked_stracks.clear();
-    this->tracked_stracks.assign(tracked_stracks_swap.begin(), tracked_stracks_swap.end());
-
-    this->tracked_stracks = joint_stracks(this->tracked_stracks, activated_stracks);
-    this->tracked_stracks = joint_stracks(this->tracked_stracks, refind_stracks);
-
-    this->lost_stracks = sub_stracks(this->lost_stracks, this->tracked_stracks);
-    for (int i = 0; i < lost_stracks.size(); ++i) {
-        this->lost_stracks.push_back(lost_stracks[i]);
+    for (int slot : activated_stracks) {
+        if (!slot_mark[slot]) {
+            list_swap.push_back(slot);
+            slot_mark[slot] = 1;
+        }
+    }
+    for (int slot : refind_stracks) {
+        if (!slot_mark[slot]) {
+            list_swap.push_back(slot);
+            slot_mark[slot] = 1;
+        }
     }
+    this->tracked_stracks.swap(list_swap);
 
-    this->lost_stracks = sub_stracks(this->lost_stracks, this->removed_stracks);
-    for (int i = 0; i < removed_stracks.size(); ++i) {
-        this->removed_stracks.push_back(removed_stracks[i]);
+    // lost = (lost - tracked) + newly lost - removed, ordered by track id
+    list_swap.clear();
+    for (int slot : this->lost_stracks) {
+        if (!slot_mark[slot]) list_swap.push_back(slot);
+    }
+    list_swap.insert(list_swap.end(), lost_now.begin(), lost_now.end());
+    this->lost_stracks.clear();
+    for (int slot : list_swap) {
+        if (!slot_removed[slot]) {
+            this->lost_stracks.push_back(slot);
+        }
     }
+    std::sort(this->lost_stracks.begin(), this->lost_stracks.end(), [this](int a, int b) {
+        return pool[a].track_id < pool[b].track_id;
+    });
 
-    remove_duplicate_stracks(resa, resb, this->tracked_stracks, this->lost_stracks);
+    for (int slot : removed_now) {
+        slot_removed[slot] = 1;
+    }
 
-    this->tracked_stracks.clear();
-    this->tracked_stracks.assign(resa.begin(), resa.end());
-    this->lost_stracks.clear();
-    this->lost_stracks.assign(resb.begin(), resb.end());
+    remove_duplicate_stracks();
+    release_unused_slots();
 
-    for (int i = 0; i < this->tracked_stracks.size(); ++i) {
-        if (this->tracked_stracks[i].is_activated) {
-            output_stracks.push_back(this->tracked_stracks[i]);
+    for (int slot : this->tracked_stracks) {
+        if (pool[slot].is_activated) {
+            output_stracks.push_back(slot);
         }
     }
     return output_stracks;
-}
\ No newline at end of file
+}
@@ -14,7 +14,35 @@
 
 #include "STrack.h"
 #include "bytetracl_c_types.h"
+#include "lapjv.h"
 
+#ifdef BYTETRACK_PROFILE
+    #include <chrono>
+
+// Adds the wall time of the enclosing scope to a nanosecond counter.
+class ProfileScope {
+   public:
+    explicit ProfileScope(int64_t& counter) : counter(counter), start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        counter += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+   private:
+    int64_t&                              counter;
+    std::chrono::steady_clock::time_point start;
+};
+
+    #define BT_PROFILE_SCOPE(counter) ProfileScope profile_scope_(counter)
+#else
+    #define BT_PROFILE_SCOPE(counter)
+#endif
+
+/*
+ * Tracks live in a pool that is allocated once, sized from bt_config_t::max_tracks.
+ * Every track list (tracked, lost and the per-frame association lists) holds slot
+ * indices into that pool, and every scratch buffer is a member that keeps its capacity
+ * across frames, so a steady-state update() does not touch the heap.
+ */
 class BYTETracker {
    public:
     struct Object {
@@ -28,39 +56,47 @@ class BYTETracker {
     BYTETracker(const bt_config_t* config);
     ~BYTETracker();
 
-    std::vector<STrack> update(const bt_bbox_t* objects, size_t num_objects);
+    BYTETracker(const BYTETracker&)            = delete;
+    BYTETracker& operator=(const BYTETracker&) = delete;
+
+    // features, if given, holds BT_FEATURE_DIM floats per object for the appearance stage
+    const std::vector<int>& update(const bt_bbox_t* objects, size_t num_objects, const float* features = nullptr);
+
+    const STrack&           track(int slot) const { return pool[slot]; }
+    const std::vector<int>& active_tracks() const { return output_stracks; }
+
+    const bt_profile_t& get_profile() const { return profile; }
+    void                reset_profile() { profile = bt_profile_t(); }
+
+    // new detections that found the pool full, they are retried as new tracks in later frames
+    uint32_t get_dropped() const { return dropped_detections; }
+    void     reset_dropped() { dropped_detections = 0; }
 
    private:
-    std::vector<STrack*> joint_stracks(std::vector<STrack*>& tlista, std::vector<STrack>& tlistb);
-    std::vector<STrack>  joint_stracks(std::vector<STrack>& tlista, std::vector<STrack>& tlistb);
-
-    std::vector<STrack> sub_stracks(std::vector<STrack>& tlista, std::vector<STrack>& tlistb);
-    void                remove_duplicate_stracks(std::vector<STrack>& resa,
-                                                 std::vector<STrack>& resb,
-                                                 std::vector<STrack>& stracksa,
-                                                 std::vector<STrack>& stracksb);
-
-    void                             linear_assignment(std::vector<std::vector<float> >& cost_matrix,
-                                                       int                               cost_matrix_size,
-                                                       int                               cost_matrix_size_size,
-                                                       float                             thresh,
-                                                       std::vector<std::vector<int> >&   matches,
-                                                       std::vector<int>&                 unmatched_a,
-                                                       std::vector<int>&                 unmatched_b);
-    std::vector<std::vector<float> > iou_distance(std::vector<STrack*>& atracks,
-                                                  std::vector<STrack>&  btracks,
-                                                  int&                  dist_size,
-                                                  int&                  dist_size_size);
-    std::vector<std::vector<float> > iou_distance(std::vector<STrack>& atracks, std::vector<STrack>& btracks);
-    std::vector<std::vector<float> > ious(std::vector<std::vector<float> >& atlbrs,
-                                          std::vector<std::vector<float> >& btlbrs);
-
-    double lapjv(const std::vector<std::vector<float> >& cost,
-                 std::vector<int>&                       rowsol,
-                 std::vector<int>&                       colsol,
-                 bool                                    extend_cost = false,
-                 float                                   cost_limit  = LONG_MAX,
-                 bool                                    return_cost = true);
+    void init(int frame_rate, int track_buffer, int max_tracks, int max_objects);
+
+    int  alloc_slot();
+    void release_unused_slots();
+
+    void remove_duplicate_stracks();
+
+    void appearance_association();
+    void add_feature(int slot, int det);
+
+    void linear_assignment(int                     cost_matrix_size,
+                           int                     cost_matrix_size_size,
+                           float                   thresh,
+                           std::vector<int>&       matches_a,
+                           std::vector<int>&       matches_b,
+                           std::vector<int>&       unmatched_a,
+                           std::vector<int>&       unmatched_b);
+    void lapjv_assignment(float thresh, int n_rows, int n_cols);
+    void greedy_assignment(float thresh);
+    bool argmin_assignment(float thresh);
+    void iou_distance(const std::vector<int>& atracks,
+                      const STrack*           apool,
+                      const std::vector<int>& btracks,
+                      const STrack*           bpool);
 
    private:
     float track_thresh;
@@ -68,9 +104,67 @@ class BYTETracker {
     float match_thresh;
     int   frame_id;
     int   max_time_lost;
+    int   track_id_count;  // per tracker, so trackers on different threads never share state
+
+    uint32_t dropped_detections;
+
+
+    bt_assign_mode_t assign_mode;
+    bt_profile_t     profile;
+
+    std::vector<STrack>  pool;
+    std::vector<uint8_t> slot_used;
+    std::vector<int>     free_slots;
+
+    // Set once a slot's track has been reported removed in an earlier frame. The
+    // original removed_stracks history was only consulted for tracks still present
+    // in the lost list, so a per-slot flag gives the same answer in O(1) and fixed memory.
+    std::vector<uint8_t> slot_removed;
+
+    std::vector<int> tracked_stracks;
+    std::vector<int> lost_stracks;
+    std::vector<int> output_stracks;
+
+    // per-frame scratch, indices into pool or detections
+    std::vector<STrack>  detections;
+    std::vector<int>     det_high, det_low, det_rest;
+    std::vector<int>     unconfirmed, strack_pool, r_tracked_stracks;
+    std::vector<int>     activated_stracks, refind_stracks, lost_now, removed_now;
+    std::vector<int>     matches_a, matches_b, u_track, u_detection, u_unconfirmed;
+    std::vector<int>     u_app_track, u_app_detection;
+    std::vector<int>     list_swap;
+    std::vector<uint8_t> slot_mark;
+
+    // Sparse cost from iou_distance(): the entries of row r are sp_entries[sp_start[r]]
+    // up to sp_entries[sp_start[r + 1]], and any pair not listed does not overlap (cost 1).
+    struct CostEntry {
+        int   row;
+        int   col;
+        float cost;
+    };
+    int                    cost_rows;
+    int                    cost_cols;
+    std::vector<int>       sp_start;
+    std::vector<CostEntry> sp_entries, sp_pairs;
+    std::vector<int>       sweep, active_a, active_b;
+
+    // association scratch, cost is the dense sub-problem handed to lapjv
+    std::vector<int>     gate_row, gate_col, match_row, match_col;
+    std::vector<float>   cost;
+    std::vector<int>     lap_x, lap_y;
+    lapjv_workspace_t    lap_ws;
+
+    // Appearance stage, enabled by feature_budget > 0. Each slot keeps its last
+    // feature_budget L2-normalized embeddings as a ring in rows [slot * feature_budget, ...)
+    // of gallery, and det_features holds this frame's normalized detection embeddings.
+    int              feature_budget;
+    float            appearance_thresh;
+    bool             has_features;
+    FEATURESS        gallery;
+    FEATURESS        det_features;
+    std::vector<int> gallery_count, gallery_head;
 
-    std::vector<STrack>       tracked_stracks;
-    std::vector<STrack>       lost_stracks;
-    std::vector<STrack>       removed_stracks;
+    // Kalman means and covariances of every pool slot, predicted as one batch per frame
     byte_kalman::KalmanFilter kalman_filter;
-};
\ No newline at end of file
+    byte_kalman::KalmanStates states;
+};
@@ -7,19 +7,29 @@
 
 #include "STrack.h"
 
+#include <algorithm>
+
 using namespace std;
 
-STrack::STrack(vector<float> tlwh_, float score, int label) {
-    _tlwh.resize(4);
-    _tlwh.assign(tlwh_.begin(), tlwh_.end());
+STrack::STrack() {
+    const float tlwh_[4] = {0.f, 0.f, 0.f, 0.f};
+    reset(tlwh_, 0.f, -1);
+}
+
+STrack::STrack(const float* tlwh_, float score, int label) { reset(tlwh_, score, label); }
+
+STrack::~STrack() {}
+
+void STrack::reset(const float* tlwh_, float score, int label) {
+    _tlwh[0] = tlwh_[0];
+    _tlwh[1] = tlwh_[1];
+    _tlwh[2] = tlwh_[2];
+    _tlwh[3] = tlwh_[3];
 
     is_activated = false;
     track_id     = 0;
     state        = TrackState::New;
 
-    tlwh.resize(4);
-    tlbr.resize(4);
-
     static_tlwh();
     static_tlbr();
 
@@ -28,36 +38,27 @@ STrack::STrack(vector<float> tlwh_, float score, int label) {
     this->score  = score;
     start_frame  = 0;
 
-	this->label = label;
+    this->label = label;
 }
 
-STrack::~STrack() {}
+void STrack::activate(const byte_kalman::KalmanFilter& kalman_filter,
+                      byte_kalman::KalmanStates&       states,
+                      int                              slot,
+                      int                              frame_id,
+                      int                              track_id) {
+    this->track_id = track_id;
 
-void STrack::activate(byte_kalman::KalmanFilter& kalman_filter, int frame_id) {
-    this->kalman_filter = kalman_filter;
-    this->track_id      = this->next_id();
-
-    vector<float> _tlwh_tmp(4);
-    _tlwh_tmp[0]       = this->_tlwh[0];
-    _tlwh_tmp[1]       = this->_tlwh[1];
-    _tlwh_tmp[2]       = this->_tlwh[2];
-    _tlwh_tmp[3]       = this->_tlwh[3];
-
-    vector<float> xyah = tlwh_to_xyah(_tlwh_tmp);
-    DETECTBOX     xyah_box;
-    xyah_box[0]      = xyah[0];
-    xyah_box[1]      = xyah[1];
-    xyah_box[2]      = xyah[2];
-    xyah_box[3]      = xyah[3];
-    auto mc          = this->kalman_filter.initiate(xyah_box);
-    this->mean       = mc.first;
-    this->covariance = mc.second;
+    float     mean[8], covariance[64];
+    DETECTBOX xyah_box = tlwh_to_xyah(this->_tlwh);
+    kalman_filter.initiate(xyah_box.data(), mean, covariance);
+    states.scatter(slot, mean, covariance);
 
-    static_tlwh();
+    static_tlwh(mean);
     static_tlbr();
 
     this->tracklet_len = 0;
     this->state        = TrackState::Tracked;
+
     if (frame_id == 1) {
         this->is_activated = true;
     }
@@ -65,54 +66,53 @@ void STrack::activate(byte_kalman::KalmanFilter& kalman_filter, int frame_id) {
     this->start_frame = frame_id;
 }
 
-void STrack::re_activate(STrack& new_track, int frame_id, bool new_id) {
-    vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
-    DETECTBOX     xyah_box;
-    xyah_box[0]      = xyah[0];
-    xyah_box[1]      = xyah[1];
-    xyah_box[2]      = xyah[2];
-    xyah_box[3]      = xyah[3];
-    auto mc          = this->kalman_filter.update(this->mean, this->covariance, xyah_box);
-    this->mean       = mc.first;
-    this->covariance = mc.second;
-
-    static_tlwh();
+void STrack::correct(const byte_kalman::KalmanFilter& kalman_filter,
+                     byte_kalman::KalmanStates&       states,
+                     int                              slot,
+                     const STrack&                    new_track) {
+    float     mean[8], covariance[64];
+    DETECTBOX xyah_box = tlwh_to_xyah(new_track.tlwh);
+    states.gather(slot, mean, covariance);
+    kalman_filter.update(mean, covariance, xyah_box.data());
+    states.scatter(slot, mean, covariance);
+
+    this->state = TrackState::Tracked;
+    static_tlwh(mean);
     static_tlbr();
+}
+
+void STrack::re_activate(const byte_kalman::KalmanFilter& kalman_filter,
+                         byte_kalman::KalmanStates&       states,
+                         int                              slot,
+                         const STrack&                    new_track,
+                         int                              frame_id,
+                         int                              new_track_id) {
+    correct(kalman_filter, states, slot, new_track);
 
     this->tracklet_len = 0;
-    this->state        = TrackState::Tracked;
     this->is_activated = true;
     this->frame_id     = frame_id;
     this->score        = new_track.score;
-    if (new_id) this->track_id = next_id();
+    if (new_track_id) this->track_id = new_track_id;
 }
 
-void STrack::update(STrack& new_track, int frame_id) {
+void STrack::update(const byte_kalman::KalmanFilter& kalman_filter,
+                    byte_kalman::KalmanStates&       states,
+                    int                              slot,
+                    const STrack&                    new_track,
+                    int                              frame_id) {
     this->frame_id = frame_id;
     this->tracklet_len++;
 
-    vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
-    DETECTBOX     xyah_box;
-    xyah_box[0] = xyah[0];
-    xyah_box[1] = xyah[1];
-    xyah_box[2] = xyah[2];
-    xyah_box[3] = xyah[3];
+    correct(kalman_filter, states, slot, new_track);
 
-    auto mc          = this->kalman_filter.update(this->mean, this->covariance, xyah_box);
-    this->mean       = mc.first;
-    this->covariance = mc.second;
-
-    static_tlwh();
-    static_tlbr();
-
-    this->state        = TrackState::Tracked;
     this->is_activated = true;
 
     this->score = new_track.score;
 }
 
-void STrack::static_tlwh() {
-    if (this->state == TrackState::New) {
+void STrack::static_tlwh(const float* mean) {
+    if (this->state == TrackState::New || mean == nullptr) {
         tlwh[0] = _tlwh[0];
         tlwh[1] = _tlwh[1];
         tlwh[2] = _tlwh[2];
@@ -131,43 +131,54 @@ void STrack::static_tlwh() {
 }
 
 void STrack::static_tlbr() {
-    tlbr.clear();
-    tlbr.assign(tlwh.begin(), tlwh.end());
-    tlbr[2] += tlbr[0];
-    tlbr[3] += tlbr[1];
+    tlbr[0] = tlwh[0];
+    tlbr[1] = tlwh[1];
+    tlbr[2] = tlwh[0] + tlwh[2];
+    tlbr[3] = tlwh[1] + tlwh[3];
 }
 
-vector<float> STrack::tlwh_to_xyah(vector<float> tlwh_tmp) {
-    tlwh_tmp[0] += tlwh_tmp[2] / 2;
-    tlwh_tmp[1] += tlwh_tmp[3] / 2;
-    tlwh_tmp[2] /= tlwh_tmp[3];
-    return tlwh_tmp;
+DETECTBOX STrack::tlwh_to_xyah(const float* tlwh_tmp) const {
+    DETECTBOX xyah;
+    xyah[0] = tlwh_tmp[0] + tlwh_tmp[2] / 2;
+    xyah[1] = tlwh_tmp[1] + tlwh_tmp[3] / 2;
+    xyah[2] = tlwh_tmp[2] / tlwh_tmp[3];
+    xyah[3] = tlwh_tmp[3];
+    return xyah;
 }
 
-vector<float> STrack::to_xyah() { return tlwh_to_xyah(tlwh); }
+DETECTBOX STrack::to_xyah() const { return tlwh_to_xyah(tlwh); }
 
-vector<float> STrack::tlbr_to_tlwh(vector<float>& tlbr) {
+void STrack::tlbr_to_tlwh(float* tlbr) {
     tlbr[2] -= tlbr[0];
     tlbr[3] -= tlbr[1];
-    return tlbr;
 }
 
 void STrack::mark_lost() { state = TrackState::Lost; }
 
 void STrack::mark_removed() { state = TrackState::Removed; }
 
-int STrack::next_id() {
-    static int _count = 0;
-    return ++_count;
-}
+int STrack::end_frame() const { return this->frame_id; }
+
+void STrack::multi_predict(STrack*                          stracks,
+                           const int*                       indices,
+                           size_t                           num_indices,
+                           const byte_kalman::KalmanFilter& kalman_filter,
+                           byte_kalman::KalmanStates&       states) {
+    float* mask = states.mask();
+    float* vh   = states.mean(7);
+    std::fill(mask, mask + states.capacity(), 0.f);
+    for (size_t i = 0; i < num_indices; ++i) {
+        int slot   = indices[i];
+        mask[slot] = 1.f;
+        vh[slot]   = !(stracks[slot].state ^ TrackState::Tracked);
+    }
 
-int STrack::end_frame() { return this->frame_id; }
+    kalman_filter.multi_predict(states);
 
-void STrack::multi_predict(vector<STrack*>& stracks, byte_kalman::KalmanFilter& kalman_filter) {
-    for (int i = 0; i < stracks.size(); ++i) {
-        stracks[i]->mean[7] = !(stracks[i]->state ^ TrackState::Tracked);
-        kalman_filter.predict(stracks[i]->mean, stracks[i]->covariance);
-        stracks[i]->static_tlwh();
-        stracks[i]->static_tlbr();
+    for (size_t i = 0; i < num_indices; ++i) {
+        int         slot    = indices[i];
+        const float mean[4] = {states.mean(0)[slot], states.mean(1)[slot], states.mean(2)[slot], states.mean(3)[slot]};
+        stracks[slot].static_tlwh(mean);
+        stracks[slot].static_tlbr();
     }
-}
\ No newline at end of file
+}
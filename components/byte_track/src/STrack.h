@@ -18,43 +18,64 @@ enum TrackState { New = 0, Tracked, Lost, Removed };
 
 class STrack {
    public:
-    STrack(std::vector<float> tlwh_, float score, int label);
+    STrack();
+    STrack(const float* tlwh_, float score, int label);
     ~STrack();
 
-    std::vector<float> static tlbr_to_tlwh(std::vector<float>& tlbr);
-    void static multi_predict(std::vector<STrack*>& stracks, byte_kalman::KalmanFilter& kalman_filter);
-    void               static_tlwh();
-    void               static_tlbr();
-    std::vector<float> tlwh_to_xyah(std::vector<float> tlwh_tmp);
-    std::vector<float> to_xyah();
-    void               mark_lost();
-    void               mark_removed();
-    int                next_id();
-    int                end_frame();
-
-    void activate(byte_kalman::KalmanFilter& kalman_filter, int frame_id);
-    void re_activate(STrack& new_track, int frame_id, bool new_id = false);
-    void update(STrack& new_track, int frame_id);
+    void static tlbr_to_tlwh(float* tlbr);
+    void static multi_predict(STrack*                          stracks,
+                              const int*                       indices,
+                              size_t                           num_indices,
+                              const byte_kalman::KalmanFilter& kalman_filter,
+                              byte_kalman::KalmanStates&       states);
+    void        reset(const float* tlwh_, float score, int label);
+    void        static_tlwh(const float* mean = nullptr);
+    void        static_tlbr();
+    DETECTBOX   tlwh_to_xyah(const float* tlwh_tmp) const;
+    DETECTBOX   to_xyah() const;
+    void        mark_lost();
+    void        mark_removed();
+    int         end_frame() const;
+
+    // The Kalman state of a track lives in the tracker's KalmanStates store at index slot.
+    // Track ids are handed out by the owning tracker, a new_track_id of 0 keeps the current one.
+    void activate(const byte_kalman::KalmanFilter& kalman_filter,
+                  byte_kalman::KalmanStates&       states,
+                  int                              slot,
+                  int                              frame_id,
+                  int                              track_id);
+    void re_activate(const byte_kalman::KalmanFilter& kalman_filter,
+                     byte_kalman::KalmanStates&       states,
+                     int                              slot,
+                     const STrack&                    new_track,
+                     int                              frame_id,
+                     int                              new_track_id = 0);
+    void update(const byte_kalman::KalmanFilter& kalman_filter,
+                byte_kalman::KalmanStates&       states,
+                int                              slot,
+                const STrack&                    new_track,
+                int                              frame_id);
 
    public:
     bool is_activated;
     int  track_id;
     int  state;
 
-    std::vector<float> _tlwh;
-    std::vector<float> tlwh;
-    std::vector<float> tlbr;
+    float _tlwh[4];
+    float tlwh[4];
+    float tlbr[4];
 
     int frame_id;
     int tracklet_len;
     int start_frame;
 
-    KAL_MEAN mean;
-    KAL_COVA covariance;
-    float    score;
+    float score;
 
     int label;
 
    private:
-    byte_kalman::KalmanFilter kalman_filter;
-};
\ No newline at end of file
+    void correct(const byte_kalman::KalmanFilter& kalman_filter,
+                 byte_kalman::KalmanStates&       states,
+                 int                              slot,
+                 const STrack&                    new_track);
+};
@@ -1,5 +1,6 @@
 #include "bytetrack_c_api.h"
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "BYTETracker.h"
@@ -13,6 +14,15 @@ bt_handler_t bt_tracker_create(const bt_config_t* config) {
     return reinterpret_cast<bt_handler_t>(tracker);
 }
 
+static void copy_track(const STrack& track, bt_bbox_t& out) {
+    for (size_t j = 0; j < 4; ++j) {
+        out.tlwh[j] = track.tlwh[j];
+    }
+    out.prob     = track.score;
+    out.label    = track.label;
+    out.track_id = track.track_id;
+}
+
 bt_error_t bt_tracker_update(
   bt_handler_t tracker, const bt_bbox_t* objects, size_t num_objects, bt_bbox_t** tracks, size_t* num_tracks) {
     if (tracker == nullptr) {
@@ -23,9 +33,8 @@ bt_error_t bt_tracker_update(
         return BT_ERR_INVALID_OBJECTS;
     }
 
-    auto tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
-    auto tracks_vec  = tracker_ptr->update(objects, num_objects);
-    tracks_vec.shrink_to_fit();
+    auto  tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    auto& tracks_vec  = tracker_ptr->update(objects, num_objects);
 
     if (num_tracks == nullptr) {
         return BT_ERR_OK;
@@ -36,10 +45,10 @@ bt_error_t bt_tracker_update(
         return BT_ERR_OK;
     }
 
-    void* tracks_ptr = nullptr;
-    if (*tracks == nullptr) {
-        tracks_ptr = calloc(tracks_vec.size(), sizeof(bt_bbox_t));
-        if (tracks_ptr == nullptr) {
+    bt_bbox_t* tracks_ptr = *tracks;
+    if (tracks_ptr == nullptr) {
+        tracks_ptr = reinterpret_cast<bt_bbox_t*>(calloc(tracks_vec.size(), sizeof(bt_bbox_t)));
+        if (tracks_ptr == nullptr && !tracks_vec.empty()) {
             return BT_ERR_MEM_ALLOC_FAIL;
         }
 
@@ -48,23 +57,125 @@ bt_error_t bt_tracker_update(
 
     const auto size = std::min(tracks_vec.size(), *num_tracks);
     for (size_t i = 0; i < size; ++i) {
-        auto& track     = tracks_vec[i];
-        auto& track_ptr = reinterpret_cast<bt_bbox_t*>(tracks_ptr)[i];
+        copy_track(tracker_ptr->track(tracks_vec[i]), tracks_ptr[i]);
+    }
+    *num_tracks = size;
+
+    *tracks = tracks_ptr;
+
+    return BT_ERR_OK;
+}
+
+static bt_error_t write_tracks(const BYTETracker*      tracker,
+                               const std::vector<int>& tracks_vec,
+                               bt_bbox_t*              tracks,
+                               size_t                  capacity,
+                               size_t*                 num_tracks) {
+    const auto size = std::min(tracks_vec.size(), capacity);
+    for (size_t i = 0; i < size; ++i) {
+        copy_track(tracker->track(tracks_vec[i]), tracks[i]);
+    }
+
+    if (num_tracks != nullptr) {
+        *num_tracks = tracks_vec.size();
+    }
+
+    return tracks_vec.size() > capacity ? BT_ERR_BUFFER_TOO_SMALL : BT_ERR_OK;
+}
+
+bt_error_t bt_tracker_update_into(bt_handler_t     tracker,
+                                  const bt_bbox_t* objects,
+                                  size_t           num_objects,
+                                  bt_bbox_t*       tracks,
+                                  size_t           capacity,
+                                  size_t*          num_tracks) {
+    return bt_tracker_update_with_features(tracker, objects, nullptr, num_objects, tracks, capacity, num_tracks);
+}
+
+bt_error_t bt_tracker_update_with_features(bt_handler_t     tracker,
+                                           const bt_bbox_t* objects,
+                                           const float*     features,
+                                           size_t           num_objects,
+                                           bt_bbox_t*       tracks,
+                                           size_t           capacity,
+                                           size_t*          num_tracks) {
+    if (tracker == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if ((objects == nullptr && num_objects != 0) || (tracks == nullptr && capacity != 0)) {
+        return BT_ERR_INVALID_OBJECTS;
+    }
+
+    auto  tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    auto& tracks_vec  = tracker_ptr->update(objects, num_objects, features);
+
+    return write_tracks(tracker_ptr, tracks_vec, tracks, capacity, num_tracks);
+}
+
+bt_error_t bt_tracker_foreach(bt_handler_t tracker, bt_track_visitor_t visitor, void* user_data) {
+    if (tracker == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if (visitor == nullptr) {
+        return BT_ERR_FAIL;
+    }
 
-        for (size_t j = 0; j < 4; ++j) {
-            track_ptr.tlwh[j] = track.tlwh[j];
+    auto tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    for (int slot : tracker_ptr->active_tracks()) {
+        const STrack&    track = tracker_ptr->track(slot);
+        bt_track_view_t view  = {track.tlwh, track.score, track.label, track.track_id};
+        if (!visitor(&view, user_data)) {
+            break;
         }
-        track_ptr.prob     = track.score;
-        track_ptr.label    = track.label;
-        track_ptr.track_id = track.track_id;
     }
 
-    *tracks = reinterpret_cast<bt_bbox_t*>(tracks_ptr);
+    return BT_ERR_OK;
+}
+
+bt_error_t bt_tracker_get_profile(bt_handler_t tracker, bt_profile_t* profile, bool reset) {
+    if (tracker == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if (profile == nullptr) {
+        return BT_ERR_FAIL;
+    }
+
+    auto tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    *profile         = tracker_ptr->get_profile();
+    if (reset) {
+        tracker_ptr->reset_profile();
+    }
+
+#ifdef BYTETRACK_PROFILE
+    return BT_ERR_OK;
+#else
+    return BT_ERR_FAIL;
+#endif
+}
+
+bt_error_t bt_tracker_get_dropped(bt_handler_t tracker, uint32_t* dropped, bool reset) {
+    if (tracker == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if (dropped == nullptr) {
+        return BT_ERR_FAIL;
+    }
+
+    auto tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    *dropped         = tracker_ptr->get_dropped();
+    if (reset) {
+        tracker_ptr->reset_dropped();
+    }
 
     return BT_ERR_OK;
 }
 
 bt_error_t bt_tracker_destroy(bt_handler_t tracker) {
+
     if (tracker == nullptr) {
         return BT_ERR_INVALID_TRACKER;
     }
@@ -0,0 +1,314 @@
+#include "bytetrack_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BYTETracker.h"
+
+#ifdef ESP_PLATFORM
+    #include "esp_pthread.h"
+    #include "freertos/FreeRTOS.h"
+#endif
+
+namespace {
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Batch {
+    int64_t timestamp_us;
+    int64_t submit_us;
+    size_t  num_objects;
+};
+
+/*
+ * Every stream owns its tracker and a ring of queue_depth batches whose detections are
+ * copied into a slab allocated up front, so submit and update do not allocate. A stream
+ * is handed to at most one worker at a time, which keeps its updates in order.
+ */
+struct Stream {
+    BYTETracker*           tracker = nullptr;
+    int                    max_objects;
+    std::vector<bt_bbox_t> slab;
+    std::vector<Batch>     ring;
+    size_t                 head  = 0;
+    size_t                 count = 0;
+    bool                   busy  = false;
+    std::vector<bt_bbox_t> tracks;
+    bt_stream_stats_t      stats;
+    int64_t                latency_sum_us = 0;
+    int64_t                update_sum_us  = 0;
+};
+
+class TrackerManager {
+   public:
+    TrackerManager(const bt_manager_config_t* config, const bt_config_t* stream_configs);
+    ~TrackerManager();
+
+    bt_error_t submit(int stream, int64_t timestamp_us, const bt_bbox_t* objects, size_t num_objects);
+    void       flush();
+    bt_error_t get_stats(int stream, bt_stream_stats_t* stats);
+
+    int num_streams() const { return (int)streams.size(); }
+
+   private:
+    void worker();
+    int  pick() const;
+    bool idle() const;
+
+    std::vector<Stream>      streams;
+    std::vector<std::thread> workers;
+    std::mutex               mutex;
+    std::condition_variable  work_cv;
+    std::condition_variable  idle_cv;
+    bool                     stopping = false;
+    bt_result_cb_t           result_cb;
+    void*                    user_data;
+};
+
+TrackerManager::TrackerManager(const bt_manager_config_t* config, const bt_config_t* stream_configs)
+    : streams(config->num_streams), result_cb(config->result_cb), user_data(config->user_data) {
+    const int queue_depth = std::max(1, config->queue_depth);
+
+    for (int i = 0; i < config->num_streams; ++i) {
+        bt_config_t stream_config = BT_CONFIG_DEFAULT();
+        if (stream_configs != nullptr) {
+            stream_config = stream_configs[i];
+        }
+        if (stream_config.max_tracks <= 0) stream_config.max_tracks = BT_DEFAULT_MAX_TRACKS;
+        if (stream_config.max_objects <= 0) stream_config.max_objects = BT_DEFAULT_MAX_OBJECTS;
+
+        Stream& stream     = streams[i];
+        stream.tracker     = new BYTETracker(&stream_config);
+        stream.max_objects = stream_config.max_objects;
+        stream.slab.resize(queue_depth * stream_config.max_objects);
+        stream.ring.resize(queue_depth);
+        stream.tracks.resize(stream_config.max_tracks);
+        memset(&stream.stats, 0, sizeof(stream.stats));
+    }
+
+    int num_workers = config->num_workers;
+#ifdef ESP_PLATFORM
+    const int num_cores = portNUM_PROCESSORS;
+#else
+    const int num_cores = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    if (num_workers <= 0) num_workers = num_cores;
+    num_workers = std::min(num_workers, config->num_streams);
+
+    for (int i = 0; i < num_workers; ++i) {
+#ifdef ESP_PLATFORM
+        esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+        cfg.stack_size        = config->worker_stack_size;
+        cfg.prio              = config->worker_priority;
+        cfg.pin_to_core       = i % num_cores;
+        cfg.thread_name       = "bt_worker";
+        esp_pthread_set_cfg(&cfg);
+#endif
+        workers.emplace_back(&TrackerManager::worker, this);
+    }
+#ifdef ESP_PLATFORM
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&cfg);
+#endif
+}
+
+TrackerManager::~TrackerManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& stream : streams) {
+        delete stream.tracker;
+    }
+}
+
+bt_error_t TrackerManager::submit(int stream_id, int64_t timestamp_us, const bt_bbox_t* objects, size_t num_objects) {
+    Stream& stream = streams[stream_id];
+    if ((objects == nullptr && num_objects != 0) || num_objects > (size_t)stream.max_objects) {
+        return BT_ERR_INVALID_OBJECTS;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stream.count == stream.ring.size()) {
+            stream.stats.rejected++;
+            return BT_ERR_BUFFER_TOO_SMALL;
+        }
+
+        // the tail slot is not visible to the workers until count is bumped
+        const size_t tail  = (stream.head + stream.count) % stream.ring.size();
+        Batch&       batch = stream.ring[tail];
+        batch.timestamp_us = timestamp_us;
+        batch.submit_us    = now_us();
+        batch.num_objects  = num_objects;
+        if (num_objects != 0) {
+            memcpy(&stream.slab[tail * stream.max_objects], objects, num_objects * sizeof(bt_bbox_t));
+        }
+        stream.count++;
+    }
+    work_cv.notify_one();
+
+    return BT_ERR_OK;
+}
+
+// Oldest queued batch among the streams that no worker is holding.
+int TrackerManager::pick() const {
+    int     best    = -1;
+    int64_t best_us = 0;
+    for (int i = 0; i < (int)streams.size(); ++i) {
+        const Stream& stream = streams[i];
+        if (stream.busy || stream.count == 0) continue;
+        const int64_t submit_us = stream.ring[stream.head].submit_us;
+        if (best < 0 || submit_us < best_us) {
+            best    = i;
+            best_us = submit_us;
+        }
+    }
+    return best;
+}
+
+bool TrackerManager::idle() const {
+    for (const auto& stream : streams) {
+        if (stream.busy || stream.count != 0) return false;
+    }
+    return true;
+}
+
+void TrackerManager::worker() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        int stream_id = -1;
+        work_cv.wait(lock, [&] { return stopping || (stream_id = pick()) >= 0; });
+        if (stopping) break;
+
+        Stream&      stream = streams[stream_id];
+        const Batch  batch  = stream.ring[stream.head];
+        const size_t slot   = stream.head;
+        stream.busy         = true;
+        lock.unlock();
+
+        const int64_t start_us   = now_us();
+        auto&         output     = stream.tracker->update(&stream.slab[slot * stream.max_objects], batch.num_objects);
+        const int64_t update_us  = now_us() - start_us;
+        const size_t  num_tracks = std::min(output.size(), stream.tracks.size());
+        for (size_t i = 0; i < num_tracks; ++i) {
+            const STrack& track = stream.tracker->track(output[i]);
+            bt_bbox_t&    out   = stream.tracks[i];
+            memcpy(out.tlwh, track.tlwh, sizeof(out.tlwh));
+            out.prob     = track.score;
+            out.label    = track.label;
+            out.track_id = track.track_id;
+        }
+        if (result_cb != nullptr) {
+            result_cb(stream_id, batch.timestamp_us, stream.tracks.data(), num_tracks, user_data);
+        }
+        const int64_t latency_us = now_us() - batch.submit_us;
+
+        lock.lock();
+        stream.head  = (stream.head + 1) % stream.ring.size();
+        stream.count = stream.count - 1;
+        stream.busy  = false;
+
+        bt_stream_stats_t& stats = stream.stats;
+        stats.updates++;
+        stats.last_timestamp_us = batch.timestamp_us;
+        stats.latency_last_us   = latency_us;
+        stats.latency_max_us    = std::max(stats.latency_max_us, latency_us);
+        stats.update_max_us     = std::max(stats.update_max_us, update_us);
+        stats.dropped           = stream.tracker->get_dropped();
+
+        stream.latency_sum_us += latency_us;
+        stream.update_sum_us += update_us;
+
+        // this stream may have more work for another worker
+        work_cv.notify_one();
+        if (idle()) idle_cv.notify_all();
+    }
+}
+
+void TrackerManager::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this] { return idle(); });
+}
+
+bt_error_t TrackerManager::get_stats(int stream_id, bt_stream_stats_t* stats) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Stream&               stream = streams[stream_id];
+    *stats                             = stream.stats;
+    stats->pending                     = stream.count;
+    if (stream.stats.updates != 0) {
+        stats->latency_avg_us = stream.latency_sum_us / stream.stats.updates;
+        stats->update_avg_us  = stream.update_sum_us / stream.stats.updates;
+    }
+    return BT_ERR_OK;
+}
+
+}  // namespace
+
+bt_manager_handler_t bt_manager_create(const bt_manager_config_t* config, const bt_config_t* stream_configs) {
+    if (config == nullptr || config->num_streams <= 0) {
+        return nullptr;
+    }
+
+    auto* manager = new TrackerManager(config, stream_configs);
+    return reinterpret_cast<bt_manager_handler_t>(manager);
+}
+
+bt_error_t bt_manager_submit(
+  bt_manager_handler_t manager, int stream, int64_t timestamp_us, const bt_bbox_t* objects, size_t num_objects) {
+    if (manager == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    auto manager_ptr = reinterpret_cast<TrackerManager*>(manager);
+    if (stream < 0 || stream >= manager_ptr->num_streams()) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    return manager_ptr->submit(stream, timestamp_us, objects, num_objects);
+}
+
+bt_error_t bt_manager_flush(bt_manager_handler_t manager) {
+    if (manager == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    reinterpret_cast<TrackerManager*>(manager)->flush();
+
+    return BT_ERR_OK;
+}
+
+bt_error_t bt_manager_get_stats(bt_manager_handler_t manager, int stream, bt_stream_stats_t* stats) {
+    if (manager == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    auto manager_ptr = reinterpret_cast<TrackerManager*>(manager);
+    if (stream < 0 || stream >= manager_ptr->num_streams() || stats == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    return manager_ptr->get_stats(stream, stats);
+}
+
+bt_error_t bt_manager_destroy(bt_manager_handler_t manager) {
+    if (manager == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    delete reinterpret_cast<TrackerManager*>(manager);
+
+    return BT_ERR_OK;
+}
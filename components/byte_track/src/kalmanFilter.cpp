@@ -7,6 +7,7 @@
 #include "kalmanFilter.h"
 
 #include <cassert>
+#include <cmath>
 #include <cstdio>
 #include <utility>
 
@@ -14,6 +15,36 @@
 
 namespace byte_kalman {
 
+void KalmanStates::resize(int capacity) {
+    _capacity = capacity;
+    _mean.assign(8 * capacity, 0.f);
+    _cov.assign(36 * capacity, 0.f);
+    _mask.assign(capacity, 0.f);
+    _scratch.assign(2 * capacity, 0.f);
+}
+
+void KalmanStates::gather(int slot, float* mean, float* covariance) const {
+    for (int k = 0; k < 8; k++) {
+        mean[k] = _mean[k * _capacity + slot];
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int j = i; j < 8; j++) {
+            covariance[i * 8 + j] = covariance[j * 8 + i] = _cov[index(i, j) * _capacity + slot];
+        }
+    }
+}
+
+void KalmanStates::scatter(int slot, const float* mean, const float* covariance) {
+    for (int k = 0; k < 8; k++) {
+        _mean[k * _capacity + slot] = mean[k];
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int j = i; j < 8; j++) {
+            _cov[index(i, j) * _capacity + slot] = covariance[i * 8 + j];
+        }
+    }
+}
+
 const double KalmanFilter::chi2inv95[10] = {0, 3.8415, 5.9915, 7.8147, 9.4877, 11.070, 12.592, 14.067, 15.507, 16.919};
 
 KalmanFilter::KalmanFilter() {
@@ -59,7 +90,224 @@ KAL_DATA KalmanFilter::initiate(const DETECTBOX& measurement) {
     return std::make_pair(mean, var);
 }
 
-void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance) {
+void KalmanFilter::initiate(const float* measurement, float* mean, float* covariance) const {
+    const float h    = measurement[3];
+    const float std[8] = {2 * _std_weight_position * h,
+                          2 * _std_weight_position * h,
+                          1e-2f,
+                          2 * _std_weight_position * h,
+                          10 * _std_weight_velocity * h,
+                          10 * _std_weight_velocity * h,
+                          1e-5f,
+                          10 * _std_weight_velocity * h};
+
+    for (int i = 0; i < 4; i++) {
+        mean[i]     = measurement[i];
+        mean[i + 4] = 0.f;
+    }
+    for (int i = 0; i < 64; i++) {
+        covariance[i] = 0.f;
+    }
+    for (int i = 0; i < 8; i++) {
+        covariance[i * 8 + i] = std[i] * std[i];
+    }
+}
+
+void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance) { predict(mean.data(), covariance.data()); }
+
+KAL_DATA
+KalmanFilter::update(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement) {
+    KAL_DATA res(mean, covariance);
+    update(res.first.data(), res.second.data(), measurement.data());
+    return res;
+}
+
+void KalmanFilter::predict(float* mean, float* covariance) const {
+    const float h      = mean[3];
+    const float std_p  = _std_weight_position * h;
+    const float std_v  = _std_weight_velocity * h;
+    const float q[8]   = {std_p * std_p,
+                          std_p * std_p,
+                          1e-2f * 1e-2f,
+                          std_p * std_p,
+                          std_v * std_v,
+                          std_v * std_v,
+                          1e-5f * 1e-5f,
+                          std_v * std_v};
+    float*      P      = covariance;
+
+    for (int i = 0; i < 4; i++) {
+        mean[i] += mean[i + 4];
+    }
+
+    // F P F^T with F = [I I; 0 I]: A' = A + B + C + D, B' = B + D, D' = D (C = B^T)
+    for (int i = 0; i < 4; i++) {
+        for (int j = i; j < 4; j++) {
+            P[i * 8 + j] += P[i * 8 + j + 4] + P[(i + 4) * 8 + j] + P[(i + 4) * 8 + j + 4];
+            P[j * 8 + i] = P[i * 8 + j];
+        }
+        for (int j = 4; j < 8; j++) {
+            P[i * 8 + j] += P[(i + 4) * 8 + j];
+            P[j * 8 + i] = P[i * 8 + j];
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        P[i * 8 + i] += q[i];
+    }
+}
+
+void KalmanFilter::multi_predict(KalmanStates& states) const {
+    const int          n    = states.capacity();
+    const float* const mask = states.mask();
+    float* const       qp   = states.scratch(0);
+    float* const       qv   = states.scratch(1);
+
+    // process noise from the height before prediction, zero for masked-out slots
+    const float* h = states.mean(3);
+    for (int s = 0; s < n; s++) {
+        const float std_p = _std_weight_position * h[s];
+        const float std_v = _std_weight_velocity * h[s];
+        qp[s]             = mask[s] * (std_p * std_p);
+        qv[s]             = mask[s] * (std_v * std_v);
+    }
+
+    // A' = A + B + C + D, reading B before it is updated below
+    for (int i = 0; i < 4; i++) {
+        for (int j = i; j < 4; j++) {
+            float* __restrict a       = states.cov(i, j);
+            const float* __restrict b = states.cov(i, j + 4);
+            const float* __restrict c = states.cov(i + 4, j);
+            const float* __restrict d = states.cov(i + 4, j + 4);
+            for (int s = 0; s < n; s++) {
+                a[s] += mask[s] * (b[s] + c[s] + d[s]);
+            }
+        }
+    }
+
+    // B' = B + D
+    for (int i = 0; i < 4; i++) {
+        for (int j = 4; j < 8; j++) {
+            float* __restrict b       = states.cov(i, j);
+            const float* __restrict d = states.cov(i + 4, j);
+            for (int s = 0; s < n; s++) {
+                b[s] += mask[s] * d[s];
+            }
+        }
+    }
+
+    for (int i = 0; i < 8; i++) {
+        float* __restrict p = states.cov(i, i);
+        if (i == 2 || i == 6) {
+            const float q = i == 2 ? 1e-2f * 1e-2f : 1e-5f * 1e-5f;
+            for (int s = 0; s < n; s++) {
+                p[s] += mask[s] * q;
+            }
+        } else {
+            const float* __restrict q = i < 4 ? qp : qv;
+            for (int s = 0; s < n; s++) {
+                p[s] += q[s];
+            }
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        float* __restrict m       = states.mean(k);
+        const float* __restrict v = states.mean(k + 4);
+        for (int s = 0; s < n; s++) {
+            m[s] += mask[s] * v[s];
+        }
+    }
+}
+
+// S = H P H^T + R is the top-left 4x4 block of P plus R, factor it as L L^T
+void KalmanFilter::innovation_cholesky(const float* mean, const float* covariance, float L[4][4]) const {
+    const float h     = mean[3];
+    const float std_p = _std_weight_position * h;
+    const float r[4]  = {std_p * std_p, std_p * std_p, 1e-1f * 1e-1f, std_p * std_p};
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j <= i; j++) {
+            float sum = covariance[i * 8 + j] + (i == j ? r[i] : 0.f);
+            for (int k = 0; k < j; k++) {
+                sum -= L[i][k] * L[j][k];
+            }
+            if (i == j) {
+                L[i][i] = std::sqrt(sum);
+            } else {
+                L[i][j] = sum / L[j][j];
+            }
+        }
+        for (int j = i + 1; j < 4; j++) {
+            L[i][j] = 0.f;
+        }
+    }
+}
+
+float KalmanFilter::gating_distance(const float* mean, const float* covariance, const float* measurement) const {
+    float L[4][4];
+    innovation_cholesky(mean, covariance, L);
+
+    // squared Mahalanobis distance d^T S^-1 d = |L^-1 d|^2
+    float z[4], dist = 0.f;
+    for (int i = 0; i < 4; i++) {
+        float sum = measurement[i] - mean[i];
+        for (int k = 0; k < i; k++) {
+            sum -= L[i][k] * z[k];
+        }
+        z[i] = sum / L[i][i];
+        dist += z[i] * z[i];
+    }
+    return dist;
+}
+
+void KalmanFilter::update(float* mean, float* covariance, const float* measurement) const {
+    float* P = covariance;
+    float  L[4][4];
+    innovation_cholesky(mean, covariance, L);
+
+    // W = L^-1 (P H^T)^T, where P H^T is the first four columns of P
+    float W[4][8];
+    for (int c = 0; c < 8; c++) {
+        for (int i = 0; i < 4; i++) {
+            float sum = P[c * 8 + i];
+            for (int k = 0; k < i; k++) {
+                sum -= L[i][k] * W[k][c];
+            }
+            W[i][c] = sum / L[i][i];
+        }
+    }
+
+    // K^T = L^-T W
+    float Kt[4][8];
+    for (int c = 0; c < 8; c++) {
+        for (int i = 3; i >= 0; i--) {
+            float sum = W[i][c];
+            for (int k = i + 1; k < 4; k++) {
+                sum -= L[k][i] * Kt[k][c];
+            }
+            Kt[i][c] = sum / L[i][i];
+        }
+    }
+
+    float innovation[4];
+    for (int k = 0; k < 4; k++) {
+        innovation[k] = measurement[k] - mean[k];
+    }
+    for (int i = 0; i < 8; i++) {
+        mean[i] += Kt[0][i] * innovation[0] + Kt[1][i] * innovation[1] + Kt[2][i] * innovation[2] +
+                   Kt[3][i] * innovation[3];
+    }
+
+    // P - K S K^T = P - W^T W
+    for (int i = 0; i < 8; i++) {
+        for (int j = i; j < 8; j++) {
+            P[i * 8 + j] -= W[0][i] * W[0][j] + W[1][i] * W[1][j] + W[2][i] * W[2][j] + W[3][i] * W[3][j];
+            P[j * 8 + i] = P[i * 8 + j];
+        }
+    }
+}
+
+void KalmanFilter::predict_dense(KAL_MEAN& mean, KAL_COVA& covariance) {
     //revise the data;
     DETECTBOX std_pos;
     std_pos << _std_weight_position * mean(3), _std_weight_position * mean(3), 1e-2, _std_weight_position * mean(3);
@@ -90,7 +338,7 @@ KAL_HDATA KalmanFilter::project(const KAL_MEAN& mean, const KAL_COVA& covariance
 }
 
 KAL_DATA
-KalmanFilter::update(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement) {
+KalmanFilter::update_dense(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement) {
     KAL_HDATA pa             = project(mean, covariance);
     KAL_HMEAN projected_mean = pa.first;
     KAL_HCOVA projected_cov  = pa.second;
@@ -7,9 +7,47 @@
 
 #pragma once
 
+#include <vector>
+
 #include "dataType.h"
 
 namespace byte_kalman {
+
+// Structure-of-arrays Kalman state for a fixed number of track slots. Means are stored
+// component-major (mean(k)[slot]) and covariances keep only the 36 upper-triangle
+// entries, also component-major, so a batch predict is a handful of contiguous
+// per-component loops that the compiler can vectorize.
+class KalmanStates {
+   public:
+    void resize(int capacity);
+    int  capacity() const { return _capacity; }
+
+    void gather(int slot, float* mean, float* covariance) const;
+    void scatter(int slot, const float* mean, const float* covariance);
+
+    float*       mean(int k) { return &_mean[k * _capacity]; }
+    const float* mean(int k) const { return &_mean[k * _capacity]; }
+    float*       cov(int i, int j) { return &_cov[index(i, j) * _capacity]; }
+    float*       mask() { return _mask.data(); }
+    float*       scratch(int k) { return &_scratch[k * _capacity]; }
+
+    static int index(int i, int j) {
+        if (i > j) {
+            int t = i;
+            i     = j;
+            j     = t;
+        }
+        return i * 8 - i * (i - 1) / 2 + (j - i);
+    }
+
+   private:
+    int                _capacity = 0;
+    std::vector<float> _mean;
+    std::vector<float> _cov;
+    std::vector<float> _mask;
+    std::vector<float> _scratch;
+};
+
 class KalmanFilter {
    public:
     static const double chi2inv95[10];
@@ -21,7 +59,27 @@ class KalmanFilter {
     KAL_HDATA project(const KAL_MEAN& mean, const KAL_COVA& covariance);
     KAL_DATA  update(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement);
 
+    // Structure-aware kernels on row-major float[8] / float[64] state, used by the tracker.
+    // The motion matrix is [I dt*I; 0 I] and the update matrix selects the first four
+    // states, so both steps reduce to block additions and a 4x4 Cholesky solve.
+    void initiate(const float* measurement, float* mean, float* covariance) const;
+    void predict(float* mean, float* covariance) const;
+    void update(float* mean, float* covariance, const float* measurement) const;
+
+    // Squared Mahalanobis distance of an xyah measurement from the projected state, to be
+    // compared against chi2inv95[4].
+    float gating_distance(const float* mean, const float* covariance, const float* measurement) const;
+
+    // Predicts every slot of states whose mask() entry is 1, leaving the others untouched.
+    void multi_predict(KalmanStates& states) const;
+
+    // Reference implementations using dense Eigen products, kept for accuracy checks.
+    void     predict_dense(KAL_MEAN& mean, KAL_COVA& covariance);
+    KAL_DATA update_dense(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement);
+
    private:
+    void innovation_cholesky(const float* mean, const float* covariance, float L[4][4]) const;
+
     Eigen::Matrix<float, 8, 8, Eigen::RowMajor> _motion_mat;
     Eigen::Matrix<float, 4, 8, Eigen::RowMajor> _update_mat;
 
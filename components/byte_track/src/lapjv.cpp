@@ -6,9 +6,8 @@
 
 /** Column-reduction and reduction transfer for a dense cost matrix.
  */
-int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
-    int_t    n_free_rows;
-    boolean* unique;
+int_t _ccrrt_dense(const uint_t n, const float* cost, int_t* free_rows, int_t* x, int_t* y, cost_t* v, boolean* unique) {
+    int_t n_free_rows;
 
     for (uint_t i = 0; i < n; i++) {
         x[i] = -1;
@@ -17,7 +16,7 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
     }
     for (uint_t i = 0; i < n; i++) {
         for (uint_t j = 0; j < n; j++) {
-            const cost_t c = cost[i][j];
+            const cost_t c = cost[i * n + j];
             if (c < v[j]) {
                 v[j] = c;
                 y[j] = i;
@@ -27,7 +26,6 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
     }
     PRINT_COST_ARRAY(v, n);
     PRINT_INDEX_ARRAY(y, n);
-    NEW(unique, boolean, n);
     memset(unique, TRUE, n);
     {
         int_t j = n;
@@ -53,7 +51,7 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
                 if (j2 == (uint_t)j) {
                     continue;
                 }
-                const cost_t c = cost[i][j2] - v[j2];
+                const cost_t c = cost[i * n + j2] - v[j2];
                 if (c < min) {
                     min = c;
                 }
@@ -62,14 +60,13 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
             v[j] -= min;
         }
     }
-    FREE(unique);
     return n_free_rows;
 }
 
 /** Augmenting row reduction for a dense cost matrix.
  */
 int_t _carr_dense(
-  const uint_t n, cost_t* cost[], const uint_t n_free_rows, int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
+  const uint_t n, const float* cost, const uint_t n_free_rows, int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
     uint_t current       = 0;
     int_t  new_free_rows = 0;
     uint_t rr_cnt        = 0;
@@ -87,12 +84,12 @@ int_t _carr_dense(
         PRINTF("current = %d rr_cnt = %d\n", current, rr_cnt);
         const int_t free_i = free_rows[current++];
         j1                 = 0;
-        v1                 = cost[free_i][0] - v[0];
+        v1                 = cost[free_i * n] - v[0];
         j2                 = -1;
         v2                 = LARGE;
         for (uint_t j = 1; j < n; j++) {
             PRINTF("%d = %f %d = %f\n", j1, v1, j2, v2);
-            const cost_t c = cost[free_i][j] - v[j];
+            const cost_t c = cost[free_i * n + j] - v[j];
             if (c < v2) {
                 if (c >= v1) {
                     v2 = c;
@@ -157,7 +154,7 @@ uint_t _find_dense(const uint_t n, uint_t lo, cost_t* d, int_t* cols, int_t* y)
 // Scan all columns in TODO starting from arbitrary column in SCAN
 // and try to decrease d of the TODO columns using the SCAN column.
 int_t _scan_dense(
-  const uint_t n, cost_t* cost[], uint_t* plo, uint_t* phi, cost_t* d, int_t* cols, int_t* pred, int_t* y, cost_t* v) {
+  const uint_t n, const float* cost, uint_t* plo, uint_t* phi, cost_t* d, int_t* cols, int_t* pred, int_t* y, cost_t* v) {
     uint_t lo = *plo;
     uint_t hi = *phi;
     cost_t h, cred_ij;
@@ -166,12 +163,12 @@ int_t _scan_dense(
         int_t        j    = cols[lo++];
         const int_t  i    = y[j];
         const cost_t mind = d[j];
-        h                 = cost[i][j] - v[j] - mind;
+        h                 = cost[i * n + j] - v[j] - mind;
         PRINTF("i=%d j=%d h=%f\n", i, j, h);
         // For all columns in TODO
         for (uint_t k = hi; k < n; k++) {
             j       = cols[k];
-            cred_ij = cost[i][j] - v[j] - h;
+            cred_ij = cost[i * n + j] - v[j] - h;
             if (cred_ij < d[j]) {
                 d[j]    = cred_ij;
                 pred[j] = i;
@@ -196,20 +193,16 @@ int_t _scan_dense(
  *
  * \return The closest free column index.
  */
-int_t find_path_dense(const uint_t n, cost_t* cost[], const int_t start_i, int_t* y, cost_t* v, int_t* pred) {
-    uint_t  lo = 0, hi = 0;
-    int_t   final_j = -1;
-    uint_t  n_ready = 0;
-    int_t*  cols;
-    cost_t* d;
-
-    NEW(cols, int_t, n);
-    NEW(d, cost_t, n);
+int_t find_path_dense(
+  const uint_t n, const float* cost, const int_t start_i, int_t* y, cost_t* v, int_t* pred, int_t* cols, cost_t* d) {
+    uint_t lo = 0, hi = 0;
+    int_t  final_j = -1;
+    uint_t n_ready = 0;
 
     for (uint_t i = 0; i < n; i++) {
         cols[i] = i;
         pred[i] = start_i;
-        d[i]    = cost[start_i][i] - v[i];
+        d[i]    = cost[start_i * n + i] - v[i];
     }
     PRINT_COST_ARRAY(d, n);
     while (final_j == -1) {
@@ -246,32 +239,31 @@ int_t find_path_dense(const uint_t n, cost_t* cost[], const int_t start_i, int_t
         }
     }
 
-    FREE(cols);
-    FREE(d);
-
     return final_j;
 }
 
 /** Augment for a dense cost matrix.
  */
-int_t _ca_dense(
-  const uint_t n, cost_t* cost[], const uint_t n_free_rows, int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
-    int_t* pred;
-
-    NEW(pred, int_t, n);
-
+int_t _ca_dense(const uint_t       n,
+                const float*       cost,
+                const uint_t       n_free_rows,
+                int_t*             free_rows,
+                int_t*             x,
+                int_t*             y,
+                cost_t*            v,
+                lapjv_workspace_t* ws) {
     for (int_t* pfree_i = free_rows; pfree_i < free_rows + n_free_rows; pfree_i++) {
         int_t  i = -1, j;
         uint_t k = 0;
 
         PRINTF("looking at free_i=%d\n", *pfree_i);
-        j = find_path_dense(n, cost, *pfree_i, y, v, pred);
+        j = find_path_dense(n, cost, *pfree_i, y, v, ws->pred, ws->cols, ws->d);
         ASSERT(j >= 0);
         ASSERT(j < n);
         while (i != *pfree_i) {
             PRINTF("augment %d\n", j);
-            PRINT_INDEX_ARRAY(pred, n);
-            i = pred[j];
+            PRINT_INDEX_ARRAY(ws->pred, n);
+            i = ws->pred[j];
             PRINTF("y[%d]=%d -> %d\n", j, y[j], i);
             y[j] = i;
             PRINT_INDEX_ARRAY(x, n);
@@ -282,30 +274,51 @@ int_t _ca_dense(
             }
         }
     }
-    FREE(pred);
     return 0;
 }
 
-/** Solve dense sparse LAP.
+int lapjv_workspace_reserve(lapjv_workspace_t* ws, const uint_t n) {
+    if (n <= ws->capacity) {
+        return 0;
+    }
+    lapjv_workspace_free(ws);
+    NEW(ws->free_rows, int_t, n);
+    NEW(ws->cols, int_t, n);
+    NEW(ws->pred, int_t, n);
+    NEW(ws->v, cost_t, n);
+    NEW(ws->d, cost_t, n);
+    NEW(ws->unique, boolean, n);
+    ws->capacity = n;
+    return 0;
+}
+
+void lapjv_workspace_free(lapjv_workspace_t* ws) {
+    FREE(ws->free_rows);
+    FREE(ws->cols);
+    FREE(ws->pred);
+    FREE(ws->v);
+    FREE(ws->d);
+    FREE(ws->unique);
+    ws->capacity = 0;
+}
+
+/** Solve a dense square LAP on a flat row-major n x n cost buffer.
  */
-int lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y) {
-    int     ret;
-    int_t*  free_rows;
-    cost_t* v;
+int lapjv_flat(const uint_t n, const float* cost, int_t* x, int_t* y, lapjv_workspace_t* ws) {
+    int ret;
 
-    NEW(free_rows, int_t, n);
-    NEW(v, cost_t, n);
-    ret   = _ccrrt_dense(n, cost, free_rows, x, y, v);
+    if (lapjv_workspace_reserve(ws, n) != 0) {
+        return -1;
+    }
+    ret   = _ccrrt_dense(n, cost, ws->free_rows, x, y, ws->v, ws->unique);
     int i = 0;
     while (ret > 0 && i < 2) {
-        ret = _carr_dense(n, cost, ret, free_rows, x, y, v);
+        ret = _carr_dense(n, cost, ret, ws->free_rows, x, y, ws->v);
         i++;
     }
     if (ret > 0) {
-        ret = _ca_dense(n, cost, ret, free_rows, x, y, v);
+        ret = _ca_dense(n, cost, ret, ws->free_rows, x, y, ws->v, ws);
     }
-    FREE(v);
-    FREE(free_rows);
-    
+
     return ret;
-}
\ No newline at end of file
+}
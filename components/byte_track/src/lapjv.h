@@ -67,6 +67,21 @@ typedef double       cost_t;
 typedef char         boolean;
 typedef enum fp_t { FP_1 = 1, FP_2 = 2, FP_DYNAMIC = 3 } fp_t;
 
-extern int_t lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y);
+/** Scratch arrays of the solver, grown on demand and reused across calls.
+ */
+typedef struct lapjv_workspace_t {
+    uint_t   capacity;
+    int_t*   free_rows;
+    int_t*   cols;
+    int_t*   pred;
+    cost_t*  v;
+    cost_t*  d;
+    boolean* unique;
+} lapjv_workspace_t;
+
+extern int  lapjv_workspace_reserve(lapjv_workspace_t* ws, const uint_t n);
+extern void lapjv_workspace_free(lapjv_workspace_t* ws);
+
+extern int lapjv_flat(const uint_t n, const float* cost, int_t* x, int_t* y, lapjv_workspace_t* ws);
 
 #endif  // LAPJV_H
\ No newline at end of file
@@ -5,14 +5,12 @@
  * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
 */
 
-#include <cassert>
+#include <algorithm>
 #include <cfloat>
 #include <cstdbool>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
-#include <map>
-#include <new>
 #include <vector>
 
 #include "BYTETracker.h"
@@ -20,369 +18,299 @@
 
 using namespace std;
 
-vector<STrack*> BYTETracker::joint_stracks(vector<STrack*>& tlista, vector<STrack>& tlistb) {
-    map<int, int>   exists;
-    vector<STrack*> res;
-    for (int i = 0; i < tlista.size(); i++) {
-        exists.insert(pair<int, int>(tlista[i]->track_id, 1));
-        res.push_back(tlista[i]);
-    }
-    for (int i = 0; i < tlistb.size(); i++) {
-        int tid = tlistb[i].track_id;
-        if (!exists[tid] || exists.count(tid) == 0) {
-            exists[tid] = 1;
-            res.push_back(&tlistb[i]);
-        }
-    }
-    return res;
-}
-
-vector<STrack> BYTETracker::joint_stracks(vector<STrack>& tlista, vector<STrack>& tlistb) {
-    map<int, int>  exists;
-    vector<STrack> res;
-    for (int i = 0; i < tlista.size(); i++) {
-        exists.insert(pair<int, int>(tlista[i].track_id, 1));
-        res.push_back(tlista[i]);
-    }
-    for (int i = 0; i < tlistb.size(); i++) {
-        int tid = tlistb[i].track_id;
-        if (!exists[tid] || exists.count(tid) == 0) {
-            exists[tid] = 1;
-            res.push_back(tlistb[i]);
-        }
-    }
-    return res;
+static inline float bbox_iou(const float* atlbr, const float* btlbr) {
+    float iw = min(atlbr[2], btlbr[2]) - max(atlbr[0], btlbr[0]) + 1;
+    if (iw <= 0) return 0.0;
+    float ih = min(atlbr[3], btlbr[3]) - max(atlbr[1], btlbr[1]) + 1;
+    if (ih <= 0) return 0.0;
+    float box_area = (btlbr[2] - btlbr[0] + 1) * (btlbr[3] - btlbr[1] + 1);
+    float ua       = (atlbr[2] - atlbr[0] + 1) * (atlbr[3] - atlbr[1] + 1) + box_area - iw * ih;
+    return iw * ih / ua;
 }
 
-vector<STrack> BYTETracker::sub_stracks(vector<STrack>& tlista, vector<STrack>& tlistb) {
-    map<int, STrack> stracks;
-    for (int i = 0; i < tlista.size(); i++) {
-        stracks.insert(pair<int, STrack>(tlista[i].track_id, tlista[i]));
-    }
-    for (int i = 0; i < tlistb.size(); i++) {
-        int tid = tlistb[i].track_id;
-        if (stracks.count(tid) != 0) {
-            stracks.erase(tid);
+void BYTETracker::remove_duplicate_stracks() {
+    iou_distance(tracked_stracks, pool.data(), lost_stracks, pool.data());
+
+    // bit 0: duplicate in tracked_stracks, bit 1: duplicate in lost_stracks
+    std::fill(slot_mark.begin(), slot_mark.end(), 0);
+    for (const CostEntry& e : sp_entries) {
+        if (e.cost < 0.15) {
+            const STrack& p     = pool[tracked_stracks[e.row]];
+            const STrack& q     = pool[lost_stracks[e.col]];
+            int           timep = p.frame_id - p.start_frame;
+            int           timeq = q.frame_id - q.start_frame;
+            if (timep > timeq)
+                slot_mark[lost_stracks[e.col]] |= 2;
+            else
+                slot_mark[tracked_stracks[e.row]] |= 1;
         }
     }
 
-    vector<STrack>                  res;
-    std::map<int, STrack>::iterator it;
-    for (it = stracks.begin(); it != stracks.end(); ++it) {
-        res.push_back(it->second);
-    }
-
-    return res;
+    auto is_dupa = [this](int slot) { return (slot_mark[slot] & 1) != 0; };
+    auto is_dupb = [this](int slot) { return (slot_mark[slot] & 2) != 0; };
+    tracked_stracks.erase(std::remove_if(tracked_stracks.begin(), tracked_stracks.end(), is_dupa),
+                          tracked_stracks.end());
+    lost_stracks.erase(std::remove_if(lost_stracks.begin(), lost_stracks.end(), is_dupb), lost_stracks.end());
 }
 
-void BYTETracker::remove_duplicate_stracks(vector<STrack>& resa,
-                                           vector<STrack>& resb,
-                                           vector<STrack>& stracksa,
-                                           vector<STrack>& stracksb) {
-    vector<vector<float> >  pdist = iou_distance(stracksa, stracksb);
-    vector<pair<int, int> > pairs;
-    for (int i = 0; i < pdist.size(); i++) {
-        for (int j = 0; j < pdist[i].size(); j++) {
-            if (pdist[i][j] < 0.15) {
-                pairs.push_back(pair<int, int>(i, j));
-            }
+void BYTETracker::linear_assignment(int          cost_matrix_size,
+                                    int          cost_matrix_size_size,
+                                    float        thresh,
+                                    vector<int>& matches_a,
+                                    vector<int>& matches_b,
+                                    vector<int>& unmatched_a,
+                                    vector<int>& unmatched_b) {
+    BT_PROFILE_SCOPE(profile.assign_ns);
+
+    matches_a.clear();
+    matches_b.clear();
+    unmatched_a.clear();
+    unmatched_b.clear();
+    match_row.assign(cost_matrix_size, -1);
+    match_col.assign(cost_matrix_size_size, -1);
+
+    // A row or column without any entry below thresh always ends up unmatched, so only
+    // the rows and columns that can match are handed to the solver.
+    gate_row.assign(cost_matrix_size, -1);
+    gate_col.assign(cost_matrix_size_size, -1);
+    for (const CostEntry& e : sp_entries) {
+        if (e.cost < thresh) {
+            gate_row[e.row] = 0;
+            gate_col[e.col] = 0;
         }
     }
-
-    vector<int> dupa, dupb;
-    for (int i = 0; i < pairs.size(); i++) {
-        int timep = stracksa[pairs[i].first].frame_id - stracksa[pairs[i].first].start_frame;
-        int timeq = stracksb[pairs[i].second].frame_id - stracksb[pairs[i].second].start_frame;
-        if (timep > timeq)
-            dupb.push_back(pairs[i].second);
-        else
-            dupa.push_back(pairs[i].first);
+    int n_rows = 0, n_cols = 0;
+    for (int& r : gate_row) {
+        if (r == 0) r = n_rows++;
     }
-
-    for (int i = 0; i < stracksa.size(); i++) {
-        vector<int>::iterator iter = find(dupa.begin(), dupa.end(), i);
-        if (iter == dupa.end()) {
-            resa.push_back(stracksa[i]);
-        }
+    for (int& c : gate_col) {
+        if (c == 0) c = n_cols++;
     }
 
-    for (int i = 0; i < stracksb.size(); i++) {
-        vector<int>::iterator iter = find(dupb.begin(), dupb.end(), i);
-        if (iter == dupb.end()) {
-            resb.push_back(stracksb[i]);
-        }
-    }
-}
-
-void BYTETracker::linear_assignment(vector<vector<float> >& cost_matrix,
-                                    int                     cost_matrix_size,
-                                    int                     cost_matrix_size_size,
-                                    float                   thresh,
-                                    vector<vector<int> >&   matches,
-                                    vector<int>&            unmatched_a,
-                                    vector<int>&            unmatched_b) {
-    if (cost_matrix.size() == 0) {
-        for (int i = 0; i < cost_matrix_size; i++) {
-            unmatched_a.push_back(i);
-        }
-        for (int i = 0; i < cost_matrix_size_size; i++) {
-            unmatched_b.push_back(i);
+    if (n_rows * n_cols != 0) {
+        switch (assign_mode) {
+        case BT_ASSIGN_GREEDY:
+            greedy_assignment(thresh);
+            break;
+        case BT_ASSIGN_AUTO:
+            // a single candidate column is exactly what greedy solves, and distinct
+            // per-row minima are optimal as they stand
+            if (n_cols == 1) {
+                greedy_assignment(thresh);
+            } else if (!argmin_assignment(thresh)) {
+                lapjv_assignment(thresh, n_rows, n_cols);
+            }
+            break;
+        default:
+            lapjv_assignment(thresh, n_rows, n_cols);
+            break;
         }
-        return;
     }
 
-    vector<int> rowsol;
-    vector<int> colsol;
-
-    lapjv(cost_matrix, rowsol, colsol, true, thresh);
-
-    auto rowsol_size = rowsol.size();
-    for (int i = 0; i < rowsol_size; i++) {
-        if (rowsol[i] >= 0) {
-            matches.emplace_back(vector<int>{i, rowsol[i]});
+    for (int i = 0; i < cost_matrix_size; i++) {
+        if (match_row[i] >= 0) {
+            matches_a.push_back(i);
+            matches_b.push_back(match_row[i]);
         } else {
             unmatched_a.push_back(i);
         }
     }
 
-    auto colsol_size = colsol.size();
-    for (int i = 0; i < colsol_size; i++) {
-        if (colsol[i] < 0) {
-            unmatched_b.push_back(i);
+    for (int j = 0; j < cost_matrix_size_size; j++) {
+        if (match_col[j] < 0) {
+            unmatched_b.push_back(j);
         }
     }
 }
 
-vector<vector<float> > BYTETracker::ious(vector<vector<float> >& atlbrs, vector<vector<float> >& btlbrs) {
-    vector<vector<float> > ious;
-    if (atlbrs.size() * btlbrs.size() == 0) return ious;
-
-    ious.resize(atlbrs.size());
-    auto ious_size = ious.size();
-    for (int i = 0; i < ious_size; i++) {
-        ious[i].resize(btlbrs.size());
+void BYTETracker::lapjv_assignment(float thresh, int n_rows, int n_cols) {
+    // Square problem of size max(n_rows, n_cols), every cost clamped to thresh. Matching
+    // a pair at cost c then saves thresh - c over leaving both sides unmatched, which is
+    // what the original (n_rows + n_cols) extension with cost_limit / 2 encoded, and the
+    // padding row or column entries add the same constant to every assignment.
+    const int n = n_rows > n_cols ? n_rows : n_cols;
+    cost.assign(n * n, thresh);
+    for (const CostEntry& e : sp_entries) {
+        int r = gate_row[e.row], c = gate_col[e.col];
+        if (r >= 0 && c >= 0 && e.cost < thresh) cost[r * n + c] = e.cost;
     }
 
-    //bbox_ious
-    auto btlbrs_size = btlbrs.size();
-    auto atlbrs_size = atlbrs.size();
-    for (int k = 0; k < btlbrs_size; k++) {
-        float box_area = (btlbrs[k][2] - btlbrs[k][0] + 1) * (btlbrs[k][3] - btlbrs[k][1] + 1);
-        for (int n = 0; n < atlbrs_size; n++) {
-            float iw = min(atlbrs[n][2], btlbrs[k][2]) - max(atlbrs[n][0], btlbrs[k][0]) + 1;
-            if (iw > 0) {
-                float ih = min(atlbrs[n][3], btlbrs[k][3]) - max(atlbrs[n][1], btlbrs[k][1]) + 1;
-                if (ih > 0) {
-                    float ua =
-                      (atlbrs[n][2] - atlbrs[n][0] + 1) * (atlbrs[n][3] - atlbrs[n][1] + 1) + box_area - iw * ih;
-                    ious[n][k] = iw * ih / ua;
-                } else {
-                    ious[n][k] = 0.0;
-                }
-            } else {
-                ious[n][k] = 0.0;
-            }
-        }
+    lap_x.resize(n);
+    lap_y.resize(n);
+    if (lapjv_flat(n, cost.data(), lap_x.data(), lap_y.data(), &lap_ws) != 0) {
+        puts("lapjv_flat failed");
+        return;
     }
 
-    return ious;
-}
-
-vector<vector<float> > BYTETracker::iou_distance(vector<STrack*>& atracks,
-                                                 vector<STrack>&  btracks,
-                                                 int&             dist_size,
-                                                 int&             dist_size_size) {
-    vector<vector<float> > cost_matrix;
-    if (atracks.size() * btracks.size() == 0) {
-        dist_size      = atracks.size();
-        dist_size_size = btracks.size();
-        return cost_matrix;
+    // map solver rows and columns back to the caller's indices
+    int k = 0;
+    for (int j = 0; j < (int)gate_col.size(); j++) {
+        if (gate_col[j] >= 0) gate_col[k++] = j;
     }
-
-    auto atracks_size = atracks.size();
-    auto btracks_size = btracks.size();
-
-    vector<vector<float> > atlbrs, btlbrs;
-    atlbrs.resize(atracks_size);
-    btlbrs.resize(btracks_size);
-    for (int i = 0; i < atracks_size; i++) {
-        atlbrs[i] = atracks[i]->tlbr;
+    for (int i = 0; i < (int)gate_row.size(); i++) {
+        int r = gate_row[i];
+        if (r < 0) continue;
+        int c = lap_x[r];
+        if (c < 0 || c >= n_cols || cost[r * n + c] >= thresh) continue;
+        match_row[i]           = gate_col[c];
+        match_col[gate_col[c]] = i;
     }
-    for (int i = 0; i < btracks_size; i++) {
-        btlbrs[i] = btracks[i].tlbr;
-    }
-
-    dist_size      = atracks.size();
-    dist_size_size = btracks.size();
-
-    vector<vector<float> > _ious{ious(atlbrs, btlbrs)};
-    auto                   _ious_size = _ious.size();
-    cost_matrix.resize(_ious_size);
-
-    for (int i = 0; i < _ious_size; i++) {
-        vector<float> _iou;
-        auto          _ious_i_size = _ious[i].size();
-        _iou.resize(_ious_i_size);
-        for (int j = 0; j < _ious_i_size; j++) {
-            _iou[j] = 1 - _ious[i][j];
-        }
-        cost_matrix[i] = move(_iou);
-    }
-
-    return cost_matrix;
 }
 
-vector<vector<float> > BYTETracker::iou_distance(vector<STrack>& atracks, vector<STrack>& btracks) {
-    auto atracks_size = atracks.size();
-    auto btracks_size = btracks.size();
-
-    static vector<vector<float> > atlbrs, btlbrs;
-
-    atlbrs.resize(atracks_size);
-    btlbrs.resize(btracks_size);
-    for (int i = 0; i < atracks_size; i++) {
-        atlbrs[i] = atracks[i].tlbr;
+void BYTETracker::greedy_assignment(float thresh) {
+    sp_pairs.clear();
+    for (const CostEntry& e : sp_entries) {
+        if (e.cost < thresh) sp_pairs.push_back(e);
     }
-    for (int i = 0; i < btracks_size; i++) {
-        btlbrs[i] = btracks[i].tlbr;
-    }
-
-    vector<vector<float> > _ious{ious(atlbrs, btlbrs)};
-    auto                   _ious_size = _ious.size();
-    vector<vector<float> > cost_matrix;
-    cost_matrix.resize(_ious_size);
-
-    for (int i = 0; i < _ious_size; i++) {
-        vector<float> _iou;
-        auto          _ious_i_size = _ious[i].size();
-        _iou.resize(_ious_i_size);
-        for (int j = 0; j < _ious_i_size; j++) {
-            _iou[j] = 1 - _ious[i][j];
+    std::sort(sp_pairs.begin(), sp_pairs.end(), [](const CostEntry& l, const CostEntry& r) {
+        if (l.cost != r.cost) return l.cost < r.cost;
+        return l.row != r.row ? l.row < r.row : l.col < r.col;
+    });
+
+    for (const CostEntry& p : sp_pairs) {
+        if (match_row[p.row] < 0 && match_col[p.col] < 0) {
+            match_row[p.row] = p.col;
+            match_col[p.col] = p.row;
         }
-        cost_matrix[i] = move(_iou);
     }
-
-    return cost_matrix;
 }
 
-double BYTETracker::lapjv(const vector<vector<float> >& cost,
-                          vector<int>&                  rowsol,
-                          vector<int>&                  colsol,
-                          bool                          extend_cost,
-                          float                         cost_limit,
-                          bool                          return_cost) {
-    vector<vector<float> > cost_c;
-    cost_c.assign(cost.begin(), cost.end());
-
-    vector<vector<float> > cost_c_extended;
-
-    int n_rows = cost.size();
-    int n_cols = cost[0].size();
-    rowsol.resize(n_rows);
-    colsol.resize(n_cols);
-
-    int n = 0;
-    if (n_rows == n_cols) {
-        n = n_rows;
-    } else {
-        if (!extend_cost) {
-            assert(0 && "set extend_cost=True");
-        }
-    }
-
-    if (extend_cost || cost_limit < LONG_MAX) {
-        n = n_rows + n_cols;
-        cost_c_extended.resize(n);
-        for (int i = 0; i < n; i++) cost_c_extended[i].resize(n);
-
-        if (cost_limit < LONG_MAX) {
-            for (int i = 0; i < n; i++) {
-                for (int j = 0; j < cost_c_extended[i].size(); j++) {
-                    cost_c_extended[i][j] = cost_limit / 2.0;
-                }
-            }
-        } else {
-            float cost_max = -1.0;
-            for (int i = 0; i < cost_c.size(); i++) {
-                for (int j = 0; j < cost_c[i].size(); j++) {
-                    if (cost_c[i][j] > cost_max) cost_max = cost_c[i][j];
-                }
-            }
-            for (int i = 0; i < n; i++) {
-                for (int j = 0; j < cost_c_extended[i].size(); j++) {
-                    cost_c_extended[i][j] = cost_max + 1;
-                }
+bool BYTETracker::argmin_assignment(float thresh) {
+    const int rows = (int)match_row.size();
+    for (int i = 0; i < rows; i++) {
+        int   best      = -1;
+        float best_cost = thresh;
+        for (int k = sp_start[i]; k < sp_start[i + 1]; k++) {
+            if (sp_entries[k].cost < best_cost) {
+                best      = sp_entries[k].col;
+                best_cost = sp_entries[k].cost;
             }
         }
-
-        for (int i = n_rows; i < n; i++) {
-            for (int j = n_cols; j < cost_c_extended[i].size(); j++) {
-                cost_c_extended[i][j] = 0;
-            }
-        }
-        for (int i = 0; i < n_rows; i++) {
-            for (int j = 0; j < n_cols; j++) {
-                cost_c_extended[i][j] = cost_c[i][j];
-            }
+        if (best < 0) continue;
+        if (match_col[best] >= 0) {
+            std::fill(match_row.begin(), match_row.end(), -1);
+            std::fill(match_col.begin(), match_col.end(), -1);
+            return false;
         }
-
-        cost_c.clear();
-        cost_c.swap(cost_c_extended);
+        match_row[i]    = best;
+        match_col[best] = i;
     }
+    return true;
+}
 
-    double** cost_ptr;
-    cost_ptr = new double*[sizeof(double*) * n];
-    for (int i = 0; i < n; i++) cost_ptr[i] = new double[sizeof(double) * n];
-
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            cost_ptr[i][j] = cost_c[i][j];
+void BYTETracker::iou_distance(const vector<int>& atracks,
+                               const STrack*      apool,
+                               const vector<int>& btracks,
+                               const STrack*      bpool) {
+    BT_PROFILE_SCOPE(profile.iou_ns);
+
+    cost_rows = atracks.size();
+    cost_cols = btracks.size();
+    sp_start.assign(cost_rows + 1, 0);
+    sp_entries.clear();
+    if (cost_rows * cost_cols == 0) return;
+
+    // Sort-and-sweep on the left edge: rows are encoded as i, columns as ~k. A box
+    // leaves the active list of its side once a later box starts to the right of it,
+    // so only pairs whose x ranges overlap are scored.
+    auto tlbr_of = [&](int e) { return e >= 0 ? apool[atracks[e]].tlbr : bpool[btracks[~e]].tlbr; };
+    sweep.clear();
+    for (int i = 0; i < cost_rows; i++) sweep.push_back(i);
+    for (int k = 0; k < cost_cols; k++) sweep.push_back(~k);
+    std::sort(sweep.begin(), sweep.end(), [&](int l, int r) {
+        float xl = tlbr_of(l)[0], xr = tlbr_of(r)[0];
+        return xl < xr || (xl == xr && l < r);
+    });
+
+    sp_pairs.clear();
+    active_a.clear();
+    active_b.clear();
+    for (int e : sweep) {
+        const float* tlbr  = tlbr_of(e);
+        vector<int>& other = e >= 0 ? active_b : active_a;
+        size_t       keep  = 0;
+        for (size_t i = 0; i < other.size(); i++) {
+            int          o     = other[i];
+            const float* otlbr = tlbr_of(o);
+            if (otlbr[2] - tlbr[0] + 1 <= 0) continue;
+            other[keep++] = o;
+
+            int   row = e >= 0 ? e : o;
+            int   col = e >= 0 ? ~o : ~e;
+            float iou = bbox_iou(apool[atracks[row]].tlbr, bpool[btracks[col]].tlbr);
+            if (iou > 0) sp_pairs.push_back({row, col, 1 - iou});
         }
+        other.resize(keep);
+        (e >= 0 ? active_a : active_b).push_back(e);
     }
 
-    int* x_c = new int[sizeof(int) * n];
-    int* y_c = new int[sizeof(int) * n];
-
-    double opt = 0.0;
-
-    int ret = lapjv_internal(n, cost_ptr, x_c, y_c);
-    if (ret != 0) {
-        puts("lapjv_internal failed");
-        goto ReleaseMemory;
-    }
+    // bucket the pairs by row
+    for (const CostEntry& p : sp_pairs) sp_start[p.row + 1]++;
+    for (int i = 0; i < cost_rows; i++) sp_start[i + 1] += sp_start[i];
+    sp_entries.resize(sp_pairs.size());
+    gate_row.assign(sp_start.begin(), sp_start.end() - 1);
+    for (const CostEntry& p : sp_pairs) sp_entries[gate_row[p.row]++] = p;
+}
 
-    if (n != n_rows) {
-        for (int i = 0; i < n; i++) {
-            if (x_c[i] >= n_cols) x_c[i] = -1;
-            if (y_c[i] >= n_rows) y_c[i] = -1;
-        }
-        for (int i = 0; i < n_rows; i++) {
-            rowsol[i] = x_c[i];
-        }
-        for (int i = 0; i < n_cols; i++) {
-            colsol[i] = y_c[i];
-        }
+void BYTETracker::add_feature(int slot, int det) {
+    if (!has_features) return;
+    gallery.row(slot * feature_budget + gallery_head[slot]) = det_features.row(det);
+    gallery_head[slot] = (gallery_head[slot] + 1) % feature_budget;
+    if (gallery_count[slot] < feature_budget) gallery_count[slot]++;
+}
 
-        if (return_cost) {
-            for (int i = 0; i < rowsol.size(); i++) {
-                if (rowsol[i] != -1) {
-                    opt += cost_ptr[i][rowsol[i]];
+void BYTETracker::appearance_association() {
+    // rows are u_track (indices into strack_pool), columns u_detection (indices into det_high)
+    cost_rows = u_track.size();
+    cost_cols = u_detection.size();
+    sp_start.assign(cost_rows + 1, 0);
+    sp_entries.clear();
+
+    {
+        BT_PROFILE_SCOPE(profile.iou_ns);
+        const float gate = float(byte_kalman::KalmanFilter::chi2inv95[4]);
+        for (int r = 0; r < cost_rows; r++) {
+            const int slot  = strack_pool[u_track[r]];
+            const int count = gallery_count[slot];
+            if (count > 0) {
+                float mean[8], covariance[64];
+                states.gather(slot, mean, covariance);
+                for (int c = 0; c < cost_cols; c++) {
+                    const int det      = det_high[u_detection[c]];
+                    DETECTBOX xyah_box = detections[det].to_xyah();
+                    if (kalman_filter.gating_distance(mean, covariance, xyah_box.data()) > gate) continue;
+
+                    // nearest gallery embedding, every row is unit length so cosine is a dot product
+                    float best = -1.f;
+                    for (int k = 0; k < count; k++) {
+                        best = max(best, gallery.row(slot * feature_budget + k).dot(det_features.row(det)));
+                    }
+                    sp_entries.push_back({r, c, 1.f - best});
                 }
             }
-        }
-    } else if (return_cost) {
-        for (int i = 0; i < rowsol.size(); i++) {
-            opt += cost_ptr[i][rowsol[i]];
+            sp_start[r + 1] = sp_entries.size();
         }
     }
 
-ReleaseMemory:
-    for (int i = 0; i < n; i++) {
-        delete[] cost_ptr[i];
+    linear_assignment(cost_rows, cost_cols, appearance_thresh, matches_a, matches_b, u_app_track, u_app_detection);
+
+    for (size_t i = 0; i < matches_a.size(); ++i) {
+        int     slot  = strack_pool[u_track[matches_a[i]]];
+        int     det   = det_high[u_detection[matches_b[i]]];
+        STrack& track = pool[slot];
+        if (track.state == TrackState::Tracked) {
+            track.update(kalman_filter, states, slot, detections[det], frame_id);
+            activated_stracks.push_back(slot);
+        } else {
+            track.re_activate(kalman_filter, states, slot, detections[det], frame_id);
+            refind_stracks.push_back(slot);
+        }
+        add_feature(slot, det);
     }
-    delete[] cost_ptr;
-    delete[] x_c;
-    delete[] y_c;
 
-    return opt;
+    // the unmatched lists are ascending, so they can be compacted in place
+    for (size_t i = 0; i < u_app_track.size(); ++i) u_track[i] = u_track[u_app_track[i]];
+    u_track.resize(u_app_track.size());
+    for (size_t i = 0; i < u_app_detection.size(); ++i) u_detection[i] = u_detection[u_app_detection[i]];
+    u_detection.resize(u_app_detection.size());
 }
@@ -1271,6 +1271,7 @@ sscma_client_handle_t bsp_sscma_client_init()
         .wait_delay = 2,
         .user_ctx = NULL,
         .io_expander = io_exp_handle,
+        .ready_gpio_num = -1,
         .flags.sync_use_expander = BSP_SSCMA_CLIENT_RST_USE_EXPANDER,
     };
 
@@ -1281,6 +1282,8 @@ sscma_client_handle_t bsp_sscma_client_init()
     sscma_client_config.event_queue_size = CONFIG_SSCMA_EVENT_QUEUE_SIZE;
     sscma_client_config.tx_buffer_size = CONFIG_SSCMA_TX_BUFFER_SIZE;
     sscma_client_config.rx_buffer_size = CONFIG_SSCMA_RX_BUFFER_SIZE;
+    sscma_client_config.reply_pool_blocks = CONFIG_SSCMA_REPLY_POOL_BLOCKS;
+    sscma_client_config.reply_pool_block_size = CONFIG_SSCMA_REPLY_POOL_BLOCK_SIZE;
     sscma_client_config.process_task_stack = CONFIG_SSCMA_PROCESS_TASK_STACK_SIZE;
     sscma_client_config.process_task_affinity = CONFIG_SSCMA_PROCESS_TASK_AFFINITY;
     sscma_client_config.process_task_priority = CONFIG_SSCMA_PROCESS_TASK_PRIORITY;
@@ -1335,6 +1338,7 @@ sscma_client_flasher_handle_t bsp_sscma_flasher_init()
     const sscma_client_flasher_we2_config_t flasher_config = {
         .reset_gpio_num = BSP_SSCMA_CLIENT_RST,
         .io_expander = io_exp_handle,
+        .burst_pages = CONFIG_SSCMA_FLASHER_BURST_PAGES,
         .flags.reset_use_expander = BSP_SSCMA_CLIENT_RST_USE_EXPANDER,
         .flags.reset_high_active = false,
         .user_ctx = NULL,
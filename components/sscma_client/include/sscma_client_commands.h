@@ -6,6 +6,33 @@
 #define RESPONSE_PREFIX_LEN (sizeof(RESPONSE_PREFIX) - 1)
 #define RESPONSE_SUFFIX_LEN (sizeof(RESPONSE_SUFFIX) - 1)
 
+/*
+ * Binary event frame, sent instead of the JSON text once AT+BINARY=1 is accepted. All
+ * fields are little-endian:
+ *   0  magic[4]      A5 5A 'S' 'B'
+ *   4  u8  version
+ *   5  u8  type
+ *   6  i16 code
+ *   8  char name[16], NUL padded
+ *   24 u16 width, u16 height, u16 count
+ *   30 u16 num_boxes, num_classes, num_points, num_keypoints
+ *   38 u32 image_len
+ *   42 u32 length    bytes following the header
+ *   46 u16 crc       CRC16 of bytes 0..45
+ * followed by the boxes {u16 x, y, w, h; u8 score, target}, classes {u8 score, target},
+ * points {u16 x, y, z; u8 score, target}, keypoints {box; u8 n; n points} and the raw JPEG.
+ */
+#define BINARY_FRAME_MAGIC      "\xA5\x5A" "SB"
+#define BINARY_FRAME_MAGIC_LEN  4
+#define BINARY_FRAME_VERSION    1
+#define BINARY_FRAME_HEADER_LEN 48
+#define BINARY_FRAME_MAX_LENGTH (1024 * 1024) // largest accepted length field, well above a JPEG frame with results
+
+#define BINARY_FRAME_NAME_LEN   16
+#define BINARY_BOX_LEN          10
+#define BINARY_CLASS_LEN        2
+#define BINARY_POINT_LEN        8
+
 #define CMD_TYPE_RESPONSE 0
 #define CMD_TYPE_EVENT    1
 #define CMD_TYPE_LOG      2
@@ -42,6 +69,7 @@
 #define CMD_AT_ACTION     "ACTION"
 #define CMD_AT_LED        "LED"
 #define CMD_AT_OTA        "OTA"
+#define CMD_AT_BINARY     "BINARY"
 
 #define EVENT_INVOKE     "INVOKE"
 #define EVENT_SAMPLE     "SAMPLE"
@@ -21,10 +21,13 @@ typedef struct
     int reset_gpio_num;                   /* !< GPIO number of reset pin */
     void *user_ctx;                       /*!< User private data */
     esp_io_expander_handle_t io_expander; /*!< IO expander handle */
+    int burst_pages;                      /*!< SPI only, 256-byte pages per burst write (1 to 15), 0 for 1 */
+    int xmodem_window;                    /*!< UART only, XMODEM blocks sent ahead of their ACK (1 to 8), 0 for 1 */
     struct
     {
         unsigned int reset_high_active : 1;  /*!< Reset line is high active */
         unsigned int reset_use_expander : 1; /*!< Reset line use IO expander */
+        unsigned int xmodem_1k : 1;          /*!< UART only, send XMODEM-1K (STX) blocks */
     } flags;
 } sscma_client_flasher_we2_config_t;
 
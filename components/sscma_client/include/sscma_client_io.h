@@ -28,6 +28,9 @@ typedef struct
     size_t trans_queue_depth;             /*!< Size of internal transaction queue */
     void *user_ctx;                       /*!< User private data, passed directly to on_color_trans_done's user_ctx */
     esp_io_expander_handle_t io_expander; /*!< IO expander handle */
+    int ready_gpio_num;                   /*!< GPIO the device asserts when it can take the next transaction, -1 or 0 (unset) to sleep wait_delay instead */
+    size_t max_payload_len;               /*!< Queued mode: payload bytes per write packet, must match the firmware, 0 for 250 */
+    size_t max_read_len;                  /*!< Queued mode: bytes per read request, 0 for 4095 */
     struct
     {
         unsigned int octal_mode : 1;        /*!< transmit with octal mode (8 data lines), this mode is used to simulate Intel 8080 timing */
@@ -36,6 +39,9 @@ typedef struct
         unsigned int cs_high_active : 1;    /*!< CS line is high active */
         unsigned int sync_high_active : 1;  /*!< SYNC line is high active */
         unsigned int sync_use_expander : 1; /*!< SYNC line use IO expander */
+        unsigned int ready_high_active : 1; /*!< READY line is high active */
+        unsigned int queued_trans : 1;      /*!< Send each packet as one DMA transaction from two alternating buffers, overlapping the copy of one with the transfer of the other */
+
     } flags;
 } sscma_client_io_spi_config_t;
 
@@ -99,6 +105,58 @@ typedef struct
  */
 esp_err_t sscma_client_new_io_uart_bus(sscma_client_uart_bus_handle_t bus, const sscma_client_io_uart_config_t *io_config, sscma_client_io_handle_t *ret_io);
 
+/**
+ * @brief Client IO configuration structure, for the loopback interface
+ *
+ */
+typedef struct
+{
+    size_t rx_buffer_size; /*!< Bytes that can be injected before the client reads them */
+    size_t tx_buffer_size; /*!< Bytes the client can write before they are fetched */
+    void *user_ctx;        /*!< User private data, passed directly to user_ctx */
+} sscma_client_io_loopback_config_t;
+
+/**
+ * @brief Create SSCMA client IO handle backed by memory instead of a bus
+ *
+ * Stands in for a device in tests: bytes injected with sscma_client_io_loopback_inject()
+ * are read by the client, and bytes it writes are returned by sscma_client_io_loopback_fetch().
+ *
+ * @param[in] io_config IO configuration, for the loopback interface
+ * @param[out] ret_io Returned IO handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_client_new_io_loopback(const sscma_client_io_loopback_config_t *io_config, sscma_client_io_handle_t *ret_io);
+
+/**
+ * @brief Queue bytes for the client to read, as if sent by the device
+ *
+ * @param[in] io Loopback IO handle
+ * @param[in] data Data to be injected
+ * @param[in] size Size of data
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if io is not a loopback IO
+ *          - ESP_ERR_NO_MEM        if the rx buffer cannot hold size more bytes
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_client_io_loopback_inject(sscma_client_io_handle_t io, const void *data, size_t size);
+
+/**
+ * @brief Take the bytes the client has written, as if received by the device
+ *
+ * @param[in] io Loopback IO handle
+ * @param[out] data Buffer for the written bytes
+ * @param[in] size Size of data
+ * @param[out] ret_len Number of bytes returned
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if io is not a loopback IO
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_client_io_loopback_fetch(sscma_client_io_handle_t io, void *data, size_t size, size_t *ret_len);
+
 /**
  * @brief Destory SSCMA client IO handle
  *
@@ -152,6 +210,30 @@ esp_err_t sscma_client_io_available(sscma_client_io_handle_t io, size_t *len);
  */
 esp_err_t sscma_client_io_flush(sscma_client_io_handle_t io);
 
+/**
+ * @brief Register a callback invoked when new data becomes available
+ *
+ * @param[in] io IO handle
+ * @param[in] cb Callback, may run in ISR context, NULL to unregister
+ * @param[in] arg Argument passed to the callback
+ * @return
+ *          - ESP_ERR_NOT_SUPPORTED if the transport has no data-ready signal
+ *          - ESP_OK
+ */
+esp_err_t sscma_client_io_set_rx_notify(sscma_client_io_handle_t io, sscma_client_io_notify_cb_t cb, void *arg);
+
+/**
+ * @brief Get the transfer counters of an IO
+ *
+ * @param[in] io IO handle
+ * @param[out] stats Counters since creation or the last reset
+ * @param[in] reset Clear the counters after reading them
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK
+ */
+esp_err_t sscma_client_io_get_stats(sscma_client_io_handle_t io, sscma_client_io_stats_t *stats, bool reset);
+
 #ifdef __cplusplus
 }
 #endif
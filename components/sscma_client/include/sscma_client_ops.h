@@ -26,6 +26,9 @@ typedef struct
     int monitor_task_affinity;            /* SSCMA monitor task pinned to core (-1 is no
                                              affinity) */
     int event_queue_size;                 /* Event queue size */
+    int request_slots;                    /* Requests that can be pending at once, 0 for 8 */
+    int reply_pool_blocks;                /* Pooled reply buffers, 0 to allocate every reply from the heap */
+    int reply_pool_block_size;            /* Bytes per pooled reply buffer, frame text and parsed payload together */
     void *user_ctx;                       /* User context */
     esp_io_expander_handle_t io_expander; /*!< IO expander handle */
     struct
@@ -39,7 +42,7 @@ typedef struct
 #define SSCMA_CLIENT_CONFIG_DEFAULT()                                                                                                                                                                  \
     {                                                                                                                                                                                                  \
         .reset_gpio_num = -1, .tx_buffer_size = 4096, .rx_buffer_size = 65536, .process_task_priority = 5, .process_task_stack = 4096, .process_task_affinity = -1, .monitor_task_priority = 4,        \
-        .monitor_task_stack = 10240, .monitor_task_affinity = -1, .event_queue_size = 2, .user_ctx = NULL,                                                                                             \
+        .monitor_task_stack = 10240, .monitor_task_affinity = -1, .event_queue_size = 2, .request_slots = 8, .reply_pool_blocks = 0, .reply_pool_block_size = 0, .user_ctx = NULL,                     \
         .flags = {                                                                                                                                                                                     \
             .reset_active_high = false,                                                                                                                                                                \
         },                                                                                                                                                                                             \
@@ -132,6 +135,34 @@ esp_err_t sscma_client_available(sscma_client_handle_t client, size_t *ret_avail
  */
 esp_err_t sscma_client_register_callback(sscma_client_handle_t client, const sscma_client_callback_t *callback, void *user_ctx);
 
+/**
+ * @brief Subscribe to replies, in addition to the registered callbacks
+ *
+ * Every matching subscriber gets the same reply, in the monitor task. Use
+ * sscma_client_reply_ref to keep it past the callback.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] type CMD_TYPE_* to match, -1 for every type
+ * @param[in] name Reply name to match, such as "INVOKE" (also matches "0@INVOKE"), NULL for every name
+ * @param[in] cb Callback
+ * @param[in] user_ctx User context for cb
+ * @param[out] ret_subscriber Subscriber handle
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NO_MEM if all SSCMA_CLIENT_MAX_SUBSCRIBERS slots are taken
+ */
+esp_err_t sscma_client_subscribe(sscma_client_handle_t client, int type, const char *name, sscma_client_reply_cb_t cb, void *user_ctx, sscma_client_subscriber_handle_t *ret_subscriber);
+
+/**
+ * @brief Remove a subscriber, waiting for its callback if it is running
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] subscriber Subscriber handle
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_unsubscribe(sscma_client_handle_t client, sscma_client_subscriber_handle_t subscriber);
+
 /**
  * @brief Clear reply
  *
@@ -140,6 +171,27 @@ esp_err_t sscma_client_register_callback(sscma_client_handle_t client, const ssc
  */
 void sscma_client_reply_clear(sscma_client_reply_t *reply);
 
+/**
+ * @brief Take a reference to a reply delivered to a callback or subscriber
+ *
+ * The reply, its text and payload stay valid until the matching sscma_client_reply_unref,
+ * so it can be handed to another task without copying. Only valid for replies passed to
+ * the on_* callbacks and subscribers: request and batch replies are plain structs owned
+ * by the caller, and passing one here (or to sscma_client_reply_unref) is undefined
+ * behaviour, caught by an assert in debug builds.
+ *
+ * @param[in] reply Reply
+ * @return The same reply
+ */
+const sscma_client_reply_t *sscma_client_reply_ref(const sscma_client_reply_t *reply);
+
+/**
+ * @brief Drop a reference taken with sscma_client_reply_ref, the last one frees the reply
+ *
+ * @param[in] reply Reply
+ */
+void sscma_client_reply_unref(const sscma_client_reply_t *reply);
+
 /**
  * @brief Send request to SCCMA client
  *
@@ -150,6 +202,58 @@ void sscma_client_reply_clear(sscma_client_reply_t *reply);
  */
 esp_err_t sscma_client_request(sscma_client_handle_t client, const char *cmd, sscma_client_reply_t *reply, bool wait, TickType_t timeout);
 
+/**
+ * @brief Send several commands at once, their replies may arrive in any order
+ *
+ * Each command takes a slot of the request table until it is answered.
+ * Completion is reported once, either through cb or through the returned handle.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] cmds Complete AT commands, including the suffix
+ * @param[in] count Number of commands
+ * @param[in] timeout Ticks to wait for all replies, portMAX_DELAY for ever
+ * @param[in] cb Completion callback, NULL to use the handle
+ * @param[in] user_ctx User context for cb
+ * @param[out] ret_batch Batch handle, for sscma_client_batch_wait and sscma_client_batch_del; set to NULL when cb is given
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NO_MEM if the request table has too few free slots
+ */
+esp_err_t sscma_client_batch_submit(
+    sscma_client_handle_t client, const char *const *cmds, size_t count, TickType_t timeout, sscma_client_batch_cb_t cb, void *user_ctx, sscma_client_batch_handle_t *ret_batch);
+
+/**
+ * @brief Wait for a batch submitted without callback
+ *
+ * @param[in] batch Batch handle
+ * @param[in] timeout Ticks to wait
+ * @return
+ *          - ESP_OK if every reply arrived
+ *          - ESP_ERR_TIMEOUT if the batch or this wait timed out
+ */
+esp_err_t sscma_client_batch_wait(sscma_client_batch_handle_t batch, TickType_t timeout);
+
+/**
+ * @brief Get the reply to one command of a finished batch
+ *
+ * @param[in] batch Batch handle
+ * @param[in] index Position of the command in the batch
+ * @param[out] reply Reply, owned by the batch
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NOT_FOUND if the command was not answered
+ */
+esp_err_t sscma_client_batch_get_reply(sscma_client_batch_handle_t batch, size_t index, const sscma_client_reply_t **reply);
+
+/**
+ * @brief Delete a batch submitted without callback, cancelling commands still pending
+ *
+ * @param[in] batch Batch handle
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_batch_del(sscma_client_batch_handle_t batch);
+
 /**
  * @brief Get SCCMA client info
  *
@@ -269,6 +373,26 @@ esp_err_t sscma_client_set_confidence_threshold(sscma_client_handle_t client, in
  */
 esp_err_t sscma_client_get_confidence_threshold(sscma_client_handle_t client, int *threshold);
 
+/**
+ * @brief Set IoU and confidence thresholds in one round trip
+ * @param[in] client SCCMA client handle
+ * @param[in] iou IoU threshold, negative to leave it unchanged
+ * @param[in] confidence confidence threshold, negative to leave it unchanged
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_set_thresholds(sscma_client_handle_t client, int iou, int confidence);
+
+/**
+ * @brief Get IoU and confidence thresholds in one round trip
+ * @param[in] client SCCMA client handle
+ * @param[out] iou IoU threshold
+ * @param[out] confidence confidence threshold
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_get_thresholds(sscma_client_handle_t client, int *iou, int *confidence);
+
 /**
  * @brief Set model info
  * @param[in] client SCCMA client handle
@@ -278,6 +402,140 @@ esp_err_t sscma_client_get_confidence_threshold(sscma_client_handle_t client, in
  */
 esp_err_t sscma_client_set_model_info(sscma_client_handle_t client, const char *model_info);
 
+/**
+ * @brief Measure the transport with request round trips
+ *
+ * Sends AT+INFO?, whose reply carries the stored model info and is the largest reply that
+ * has no side effects, and times each round trip. Run it while no INVOKE is active, events
+ * share the transport and would be counted as well. The transport counters are reset at
+ * the start of the run.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] iterations number of round trips
+ * @param[out] result latency and throughput
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_benchmark(sscma_client_handle_t client, int iterations, sscma_client_benchmark_t *result);
+
+/**
+ * @brief Measure bulk transport throughput with one large read
+ *
+ * Reads len bytes from the transport in a single call, the way a large reply such as an
+ * image is read, and reports bytes per second in result->bulk_*. Round trips only show
+ * per-request latency, this shows what the bus and the transport's read path sustain.
+ * Only for transports the host clocks (SPI, I2C): the bytes read are whatever the device
+ * shifts out, so run it while the device is idle, and a UART read would wait for bytes
+ * that never come. The transport counters in result->io are updated as well.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] len bytes to read, e.g. 65536
+ * @param[in,out] result bulk fields and io counters are filled in, the rest is left as is
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_benchmark_read(sscma_client_handle_t client, size_t len, sscma_client_benchmark_t *result);
+
+/**
+ * @brief Switch INVOKE/SAMPLE events between JSON text and binary frames
+ *
+ * The client accepts both framings at any time, so replies already in flight when the
+ * mode changes are still delivered.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] enable true for binary frames, false for JSON text
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NOT_SUPPORTED if the firmware does not know AT+BINARY
+ */
+esp_err_t sscma_client_set_binary_mode(sscma_client_handle_t client, bool enable);
+
+/**
+ * @brief Get reply pool statistics
+ *
+ * @param[in] client SCCMA client handle
+ * @param[out] stats Statistics
+ * @param[in] reset Whether to restart the counters and high-water marks
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NOT_SUPPORTED if the client has no reply pool
+ */
+esp_err_t sscma_client_get_reply_pool_stats(sscma_client_handle_t client, sscma_client_reply_pool_stats_t *stats, bool reset);
+
+/**
+ * @brief Limit the rate of INVOKE/SAMPLE results taken from the device, latest value wins
+ *
+ * Results that come sooner than 1/rate after the last delivered one, or while the consumer
+ * is still handling it, are dropped in the framing layer before they are parsed or allocated.
+ * Other replies are never dropped.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] rate Results per second at most, 0 to deliver every result
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_set_result_rate(sscma_client_handle_t client, int rate);
+
+/**
+ * @brief Get inference result throttling statistics
+ *
+ * @param[in] client SCCMA client handle
+ * @param[out] stats Statistics
+ * @param[in] reset Whether to restart the counters
+ * @return
+ *          - ESP_OK on success
+ */
+esp_err_t sscma_client_get_result_stats(sscma_client_handle_t client, sscma_client_result_stats_t *stats, bool reset);
+
+/**
+ * @brief Get cJSON hooks that let replies parse into their pool block
+ *
+ * Install the result with cJSON_InitHooks in place of the application's own hooks.
+ * Allocations made while the client parses a pooled reply come from the reply's block and
+ * are released with it; every other allocation is passed to fallback.
+ *
+ * @param[in] fallback Allocator for everything else, NULL for malloc and free
+ * @param[out] ret_hooks Hooks to install
+ */
+void sscma_client_json_hooks(const cJSON_Hooks *fallback, cJSON_Hooks *ret_hooks);
+
+/**
+ * Decode an INVOKE/SAMPLE reply in a single pass without building a JSON tree
+ * @param[in] data reply text
+ * @param[in] len length of data
+ * @param[in,out] event decoded event, result arrays are supplied by the caller
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_RESPONSE if data is not a well-formed reply
+ */
+esp_err_t sscma_utils_decode_event(const char *data, size_t len, sscma_client_event_t *event);
+
+/**
+ * Encode an event as a binary frame, the layout is described in sscma_client_commands.h
+ * @param[in] event event to encode, image must hold raw JPEG bytes
+ * @param[out] buf output buffer, NULL to only compute the length
+ * @param[in] size size of buf
+ * @param[out] ret_len length of the frame
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_SIZE if buf is too small or the frame exceeds BINARY_FRAME_MAX_LENGTH
+ */
+esp_err_t sscma_utils_encode_event(
+const sscma_client_event_t *event, void *buf, size_t size, size_t *ret_len);
+
+/**
+ * Validate a binary frame header
+ * @param[in] header BINARY_FRAME_HEADER_LEN bytes
+ * @param[out] len length of the whole frame
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_RESPONSE if the magic or version does not match
+ *    - ESP_ERR_INVALID_CRC if the header checksum does not match
+ *    - ESP_ERR_INVALID_SIZE if the length field exceeds BINARY_FRAME_MAX_LENGTH
+ */
+esp_err_t sscma_utils_binary_frame_length(const void *header, size_t *len);
+
+
 /**
  * Fetch boxes and classes from sscma client reply
  * @param[in] reply sscma client reply
@@ -383,6 +641,17 @@ esp_err_t sscma_utils_fetch_image_from_reply(const sscma_client_reply_t *reply,
  */
 esp_err_t sscma_utils_copy_image_from_reply(const sscma_client_reply_t *reply, char *image, int max_image_size, int *image_size);
 
+/**
+ * Fetch the decoded JPEG from sscma client reply, copied from a binary frame or base64
+ * decoded from a text one
+ * @param[in] reply sscma client reply
+ * @param[out] jpeg JPEG bytes, to be freed by the caller
+ * @param[out] jpeg_size size of jpeg
+ * @return
+ *    - ESP_OK
+ */
+esp_err_t sscma_utils_fetch_jpeg_from_reply(const sscma_client_reply_t *reply, uint8_t **jpeg, size_t *jpeg_size);
+
 /**
  * Start ota
  * @param[in] client SCCMA client handle
@@ -403,6 +672,17 @@ esp_err_t sscma_client_ota_start(sscma_client_handle_t client, const sscma_clien
  */
 esp_err_t sscma_client_ota_write(sscma_client_handle_t client, const void *data, size_t len);
 
+/**
+ * Verify the data written to ota since the last verify by reading back its CRC
+ * @param[in] client SCCMA client handle
+ * @param[out] crc read-back CRC
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_INVALID_CRC if the read-back CRC differs from the CRC of the data sent
+ *          - ESP_ERR_NOT_SUPPORTED if the flasher cannot read back
+ */
+esp_err_t sscma_client_ota_verify(sscma_client_handle_t client, uint32_t *crc);
+
 /**
  * Finish ota
  * @param[in] client SCCMA client handle
@@ -4,6 +4,7 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 
 #include "cJSON.h"
@@ -16,6 +17,7 @@
 #include "esp_io_expander.h"
 
 #define SSCMA_CLIENT_MODEL_MAX_CLASSES   80
+#define SSCMA_CLIENT_MAX_SUBSCRIBERS     8
 #define SSCMA_CLIENT_MODEL_KEYPOINTS_MAX 80
 
 #ifdef __cplusplus
@@ -25,6 +27,8 @@ extern "C" {
 typedef struct sscma_client_t *sscma_client_handle_t;                 /*!< Type of SCCMA client handle */
 typedef struct sscma_client_io_t *sscma_client_io_handle_t;           /*!< Type of SSCMA client IO handle */
 typedef struct sscma_client_flasher_t *sscma_client_flasher_handle_t; /*!< Type of SCCMA client flasher handle */
+typedef struct sscma_client_batch_t *sscma_client_batch_handle_t;     /*!< Type of SSCMA client batch handle */
+typedef struct sscma_client_subscriber_t *sscma_client_subscriber_handle_t; /*!< Type of SSCMA client subscriber handle */
 
 /**
  * @brief Reply message
@@ -34,16 +38,24 @@ typedef struct
     cJSON *payload;
     char *data;
     size_t len;
+    void *block; /* !< Pool block holding data and payload, NULL if both came from the heap */
 } sscma_client_reply_t;
 
 /**
- * @brief Request message
+ * @brief Pending request, one slot of the client's request table
  */
 typedef struct
 {
-    char cmd[32];
-    QueueHandle_t reply;
-    ListItem_t item;
+    uint32_t hash;              /* !< Hash of cmd, 0 while the slot is free */
+    uint32_t seq;               /* !< Submission order, the oldest of equal commands is answered first */
+    char cmd[32];               /* !< Name the reply is matched on */
+    bool done;                  /* !< Whether reply holds the answer */
+    bool is_break;              /* !< Whether this is AT+BREAK, events are dropped while one is pending */
+    sscma_client_reply_t reply; /* !< Reply, owned by the slot until it is taken */
+    SemaphoreHandle_t ready;    /* !< Given when reply is filled in */
+    StaticSemaphore_t ready_buffer;
+    struct sscma_client_batch_t *batch; /* !< Batch the request belongs to, NULL for a single request */
+    size_t index;                       /* !< Position of the command in its batch */
 } sscma_client_request_t;
 
 /**
@@ -110,6 +122,97 @@ typedef struct
     sscma_client_point_t points[SSCMA_CLIENT_MODEL_KEYPOINTS_MAX];
 } sscma_client_keypoint_t;
 
+/**
+ * @brief INVOKE/SAMPLE event decoded by sscma_utils_decode_event()
+ *
+ * Result arrays are supplied by the caller and filled up to their capacity; leave them
+ * NULL to only count the results. Strings point into the decoded text, they are not
+ * NUL-terminated and may contain JSON escapes.
+ */
+typedef struct
+{
+    int type;                           /*!< Reply type, INT_MIN if absent */
+    int code;                           /*!< Reply code, INT_MIN if absent */
+    const char *name;                   /*!< Reply name */
+    size_t name_len;                    /*!< Length of name */
+    bool has_data;                      /*!< Whether the reply has a data object */
+    int count;                          /*!< data.count, INT_MIN if absent */
+    int width;                          /*!< data.resolution[0], INT_MIN if absent */
+    int height;                         /*!< data.resolution[1], INT_MIN if absent */
+    sscma_client_box_t *boxes;          /*!< [in] Storage for boxes */
+    int max_boxes;                      /*!< [in] Capacity of boxes */
+    int num_boxes;                      /*!< Boxes in the reply, may exceed max_boxes */
+    sscma_client_class_t *classes;      /*!< [in] Storage for classes */
+    int max_classes;                    /*!< [in] Capacity of classes */
+    int num_classes;                    /*!< Classes in the reply, may exceed max_classes */
+    sscma_client_point_t *points;       /*!< [in] Storage for points */
+    int max_points;                     /*!< [in] Capacity of points */
+    int num_points;                     /*!< Points in the reply, may exceed max_points */
+    sscma_client_keypoint_t *keypoints; /*!< [in] Storage for keypoints */
+    int max_keypoints;                  /*!< [in] Capacity of keypoints */
+    int num_keypoints;                  /*!< Keypoints in the reply, may exceed max_keypoints */
+    const char *image;                  /*!< Base64 image, or raw JPEG if image_raw */
+    size_t image_len;                   /*!< Length of image */
+    bool image_raw;                     /*!< Whether the reply was a binary frame */
+} sscma_client_event_t;
+
+/**
+ * @brief Transport benchmark result, see sscma_client_benchmark()
+ */
+typedef struct
+{
+    int iterations;                /*!< Completed request round trips */
+    int64_t latency_min_us;        /*!< Fastest round trip */
+    int64_t latency_avg_us;        /*!< Mean round trip */
+    int64_t latency_max_us;        /*!< Slowest round trip */
+    size_t reply_bytes;            /*!< Reply bytes received */
+    uint32_t throughput;           /*!< Reply bytes per second over the whole run */
+    uint32_t read_throughput;      /*!< Bytes per second while inside the transport read */
+    size_t bulk_bytes;             /*!< Bytes read in one go by sscma_client_benchmark_read() */
+    int64_t bulk_time_us;          /*!< Time taken by that read */
+    uint32_t bulk_throughput;      /*!< Bulk read bytes per second */
+    sscma_client_io_stats_t io;    /*!< Transport counters for the run */
+} sscma_client_benchmark_t;
+
+/**
+ * @brief Inference result throttling statistics
+ */
+typedef struct
+{
+    uint32_t delivered;    /*!< INVOKE/SAMPLE results parsed and delivered */
+    uint32_t dropped_rate; /*!< Results dropped unparsed because they came sooner than the target rate */
+    uint32_t dropped_busy; /*!< Results dropped unparsed because the consumer had not taken the previous one */
+} sscma_client_result_stats_t;
+
+/**
+ * @brief Reply pool statistics
+ */
+typedef struct
+{
+    size_t blocks;            /*!< Blocks in the pool */
+    size_t block_size;        /*!< Bytes per block, frame text and parsed payload together */
+    size_t in_use;            /*!< Blocks held by replies right now */
+    size_t high_water;        /*!< Most blocks held at once */
+    size_t arena_high_water;  /*!< Most bytes of one block used by a reply */
+    uint32_t acquired;        /*!< Replies served from the pool */
+    uint32_t fallbacks;       /*!< Replies allocated from the heap: pool empty or frame too large */
+    uint32_t spills;          /*!< Replies whose payload outgrew its block, the rest went to the heap */
+} sscma_client_reply_pool_stats_t;
+
+/**
+ * @brief Reply pool, fixed blocks each holding one frame and the cJSON nodes parsed from it
+ */
+typedef struct sscma_client_reply_pool_t
+{
+    uint8_t *base;                         /* !< Blocks, contiguous so a pointer is classified by one range check */
+    size_t block_size;                     /* !< Bytes per block */
+    size_t blocks;                         /* !< Number of blocks */
+    uint16_t *free_list;                   /* !< Stack of free block indexes */
+    size_t free_count;                     /* !< Entries on the free stack */
+    portMUX_TYPE lock;                     /* !< Guards free_list and stats */
+    sscma_client_reply_pool_stats_t stats; /* !< Statistics */
+} sscma_client_reply_pool_t;
+
 /**
  * @brief Callback function of SCCMA client
  * @param[in] client SCCMA client handle
@@ -131,6 +234,46 @@ typedef struct
     sscma_client_reply_cb_t on_log;
 } sscma_client_callback_t;
 
+/**
+ * @brief Reply subscriber, one slot of the client's subscriber table
+ */
+struct sscma_client_subscriber_t
+{
+    int type;                   /* !< CMD_TYPE_* to match, -1 for every type */
+    uint32_t hash;              /* !< Hash of name, 0 for every name */
+    char name[32];              /* !< Name to match, the part after '@' in names such as "0@INVOKE" */
+    sscma_client_reply_cb_t cb; /* !< Callback, NULL while the slot is free */
+    void *user_ctx;             /* !< User context for cb */
+};
+
+/**
+ * @brief Callback invoked once every reply of a batch has arrived or the batch has timed out
+ *
+ * Runs in the client's process task. The batch is deleted when the callback returns.
+ */
+typedef void (*sscma_client_batch_cb_t)(sscma_client_handle_t client, sscma_client_batch_handle_t batch, void *user_ctx);
+
+/**
+ * @brief Batch of commands in flight together
+ */
+struct sscma_client_batch_t
+{
+    sscma_client_handle_t client;   /* !< Client the batch was submitted to */
+    size_t count;                   /* !< Number of commands */
+    size_t pending;                 /* !< Commands still unanswered */
+    sscma_client_reply_t *replies;  /* !< Replies in command order, empty where none arrived */
+    TickType_t start;               /* !< Tick the batch was sent at */
+    TickType_t timeout;             /* !< Ticks after start at which unanswered commands are given up */
+    esp_err_t result;               /* !< ESP_OK once all replies arrived, ESP_ERR_TIMEOUT otherwise */
+    bool armed;                     /* !< Whether every command is written, the batch may complete from then on */
+    bool finished;                  /* !< Whether the batch has completed, timed out or been cancelled */
+    bool waited;                    /* !< Whether the completion has been consumed by a waiter */
+    sscma_client_batch_cb_t cb;     /* !< Completion callback, NULL to wait on the handle */
+    void *user_ctx;                 /* !< User context for cb */
+    SemaphoreHandle_t done;         /* !< Given on completion when there is no callback */
+    StaticSemaphore_t done_buffer;
+};
+
 struct sscma_client_t
 {
     sscma_client_io_handle_t io;           /* !< IO handle */
@@ -164,13 +307,47 @@ struct sscma_client_t
 #endif
     } process_task;
     struct
+    {
+        char *data;            /* !< Ring storage */
+        size_t len;            /* !< Ring capacity */
+        size_t head;           /* !< Offset of the oldest unconsumed byte */
+        size_t count;          /* !< Bytes held in the ring */
+        size_t scanned;        /* !< Bytes after head already scanned */
+        bool in_frame;         /* !< Whether head is the prefix of a frame */
+        bool binary;           /* !< Whether the frame at head is a binary frame */
+        size_t frame_len;      /* !< Length of the binary frame at head, 0 until its header arrived */
+        size_t skip;           /* !< Bytes of an oversized binary frame still to drop */
+    } rx_buffer;               /* !< RX ring buffer */
+    struct
     {
         char *data;            /* !< Data buffer */
         size_t len;            /* !< Data length */
         size_t pos;            /* !< Data position */
-    } rx_buffer, tx_buffer;    /* !< RX and TX buffer */
+    } tx_buffer;               /* !< TX buffer */
+    bool rx_notify;            /* !< Whether the IO wakes the process task when data arrives */
+    sscma_client_reply_pool_t *reply_pool; /* !< Reply pool, NULL to allocate every reply from the heap */
+    struct
+    {
+        TickType_t interval;                 /* !< Least ticks between delivered results, 0 delivers all */
+        TickType_t last;                     /* !< Tick of the last delivered result */
+        volatile bool busy;                  /* !< Whether the monitor task is handling a reply */
+        sscma_client_result_stats_t stats;   /* !< Statistics */
+    } throttle;                              /* !< Inference result throttling */
+    struct
+    {
+        struct sscma_client_subscriber_t slots[SSCMA_CLIENT_MAX_SUBSCRIBERS]; /* !< Subscriber table */
+        int count;                                                            /* !< Slots in use */
+        SemaphoreHandle_t lock;                                               /* !< Recursive, held while callbacks run */
+    } subscribers;                                                            /* !< Reply subscribers */
     QueueHandle_t reply_queue; /* !< Queue for reply message */
-    List_t *request_list;      /* !< Request list */
+    struct
+    {
+        sscma_client_request_t *slots; /* !< Fixed table of pending requests */
+        size_t size;                   /* !< Number of slots */
+        uint32_t seq;                  /* !< Next submission number */
+        int breaks;                    /* !< Pending AT+BREAK requests */
+        portMUX_TYPE lock;             /* !< Guards the table, held only for lookups */
+    } requests;                        /* !< Request table */
 };
 
 #ifdef __cplusplus
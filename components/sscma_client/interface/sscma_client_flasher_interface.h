@@ -46,6 +46,16 @@ struct sscma_client_flasher_t
      */
     esp_err_t (*abort)(sscma_client_flasher_t *handle);
 
+    /**
+     * @brief Check what reached the flash since the last verify, optional
+     * @param[in] handle transmitter handle
+     * @param[out] crc read-back CRC of the data programmed since the last verify
+     * @return
+     * - ESP_OK
+     * - ESP_ERR_INVALID_CRC if the read-back CRC differs from the CRC of the data sent
+     */
+    esp_err_t (*verify)(sscma_client_flasher_t *handle, uint32_t *crc);
+
     /**
      * @brief Delete flasher transmitter
      * @param[in] handle transmitter handle
@@ -90,6 +100,17 @@ esp_err_t sscma_client_flasher_finish(sscma_client_flasher_t *handle);
  */
 esp_err_t sscma_client_flasher_abort(sscma_client_flasher_t *handle);
 
+/**
+ * Verify the data programmed since the last verify
+ * @param[in] handle transmitter handle
+ * @param[out] crc read-back CRC
+ * @return
+ * - ESP_OK
+ * - ESP_ERR_INVALID_CRC if the read-back CRC differs from the CRC of the data sent
+ * - ESP_ERR_NOT_SUPPORTED if the flasher cannot read back
+ */
+esp_err_t sscma_client_flasher_verify(sscma_client_flasher_t *handle, uint32_t *crc);
+
 /**
  * Delete flasher transmitter
  * @param[in] handle transmitter handle
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -9,6 +10,26 @@ extern "C" {
 
 typedef struct sscma_client_io_t sscma_client_io_t; /*!< Type of SSCMA client IO */
 
+/**
+ * @brief Callback invoked by the IO when new data becomes available, may run in ISR context
+ */
+typedef void (*sscma_client_io_notify_cb_t)(void *arg);
+
+/**
+ * @brief Transfer counters kept by sscma_client_io_read/write
+ */
+typedef struct
+{
+    uint32_t reads;         /*!< Read calls */
+    uint32_t writes;        /*!< Write calls */
+    uint64_t read_bytes;    /*!< Bytes read */
+    uint64_t write_bytes;   /*!< Bytes written */
+    int64_t read_time_us;   /*!< Time spent in read */
+    int64_t write_time_us;  /*!< Time spent in write */
+    int64_t read_max_us;    /*!< Longest read */
+    int64_t write_max_us;   /*!< Longest write */
+} sscma_client_io_stats_t;
+
 /**
  * @brief SSCMA IO interface
  */
@@ -75,6 +96,23 @@ struct sscma_client_io_t
      *          - ESP_OK
      */
     esp_err_t (*flush)(sscma_client_io_t *io);
+
+    /**
+     * @brief Register a data-ready notification (optional)
+     *
+     * @param[in] io IO handle
+     * @param[in] cb Callback, NULL to unregister
+     * @param[in] arg Argument passed to the callback
+     * @return
+     *          - ESP_ERR_NOT_SUPPORTED if the transport has no data-ready signal
+     *          - ESP_OK
+     */
+    esp_err_t (*set_rx_notify)(sscma_client_io_t *io, sscma_client_io_notify_cb_t cb, void *arg);
+
+    /**
+     * @brief Transfer counters, maintained by the generic IO layer
+     */
+    sscma_client_io_stats_t stats;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,795 @@
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "sdkconfig.h"
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_rom_crc.h"
+
+#include "sscma_client_types.h"
+#include "sscma_client_commands.h"
+#include "sscma_client_ops.h"
+
+static const char *TAG = "sscma_client.decoder";
+
+#define DECODER_MAX_DEPTH 16
+
+/*
+ * Single-pass decoder for the SSCMA reply shape. It walks the frame text in place, stores
+ * the fields it knows about straight into the caller's structures and steps over
+ * everything else, so no DOM is built and the base64 image is only located, never copied.
+ */
+typedef struct
+{
+    const char *p;
+    const char *end;
+} cursor_t;
+
+static inline void skip_ws(cursor_t *c)
+{
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\r' || *c->p == '\n'))
+    {
+        c->p++;
+    }
+}
+
+static inline bool peek(cursor_t *c, char ch)
+{
+    skip_ws(c);
+    return c->p < c->end && *c->p == ch;
+}
+
+static inline bool expect(cursor_t *c, char ch)
+{
+    if (!peek(c, ch))
+    {
+        return false;
+    }
+    c->p++;
+    return true;
+}
+
+static bool parse_string(cursor_t *c, const char **str, size_t *len)
+{
+    if (!expect(c, '"'))
+    {
+        return false;
+    }
+
+    const char *start = c->p;
+    while (c->p < c->end)
+    {
+        const char *quote = memchr(c->p, '"', c->end - c->p);
+        if (quote == NULL)
+        {
+            return false;
+        }
+        // a quote preceded by an odd number of backslashes is escaped
+        size_t slashes = 0;
+        while (quote - slashes > start && quote[-1 - (ptrdiff_t)slashes] == '\\')
+        {
+            slashes++;
+        }
+        c->p = quote + 1;
+        if ((slashes & 1) == 0)
+        {
+            *str = start;
+            *len = quote - start;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_int(cursor_t *c, int *value)
+{
+    int v = 0;
+    bool negative = false;
+
+    skip_ws(c);
+    if (c->p < c->end && *c->p == '-')
+    {
+        negative = true;
+        c->p++;
+    }
+    if (c->p >= c->end || *c->p < '0' || *c->p > '9')
+    {
+        return false;
+    }
+    while (c->p < c->end && *c->p >= '0' && *c->p <= '9')
+    {
+        int digit = *c->p - '0';
+        // saturate instead of overflowing, cJSON clamps out of range numbers the same way
+        v = v > (INT_MAX - digit) / 10 ? INT_MAX : v * 10 + digit;
+        c->p++;
+    }
+    // fraction and exponent are truncated like cJSON's valueint
+    while (c->p < c->end && (*c->p == '.' || *c->p == 'e' || *c->p == 'E' || *c->p == '+' || *c->p == '-' || (*c->p >= '0' && *c->p <= '9')))
+    {
+        c->p++;
+    }
+    *value = negative ? -v : v;
+
+    return true;
+}
+
+static bool skip_value(cursor_t *c, int depth)
+{
+    const char *str;
+    size_t len;
+
+    if (depth > DECODER_MAX_DEPTH)
+    {
+        return false;
+    }
+
+    skip_ws(c);
+    if (c->p >= c->end)
+    {
+        return false;
+    }
+
+    switch (*c->p)
+    {
+    case '"':
+        return parse_string(c, &str, &len);
+    case '{':
+    case '[': {
+        char close = *c->p == '{' ? '}' : ']';
+        c->p++;
+        if (expect(c, close))
+        {
+            return true;
+        }
+        do
+        {
+            if (close == '}' && (!parse_string(c, &str, &len) || !expect(c, ':')))
+            {
+                return false;
+            }
+            if (!skip_value(c, depth + 1))
+            {
+                return false;
+            }
+        }
+        while (expect(c, ','));
+        return expect(c, close);
+    }
+    default:
+        // number, true, false or null
+        while (c->p < c->end && *c->p != ',' && *c->p != '}' && *c->p != ']' && *c->p != ' ' && *c->p != '\r' && *c->p != '\n')
+        {
+            c->p++;
+        }
+        return true;
+    }
+}
+
+/*
+ * Reads a flat array of integers into values[0..max). Missing or non-numeric elements read
+ * as INT_MIN, matching get_int_from_array(), and extra elements are skipped.
+ */
+static bool parse_int_array(cursor_t *c, int *values, int max)
+{
+    int n = 0;
+
+    for (int i = 0; i < max; i++)
+    {
+        values[i] = INT_MIN;
+    }
+    if (!expect(c, '['))
+    {
+        return skip_value(c, 0);
+    }
+    if (expect(c, ']'))
+    {
+        return true;
+    }
+    do
+    {
+        int v;
+        const char *mark = c->p;
+        if (parse_int(c, &v))
+        {
+            if (n < max)
+            {
+                values[n] = v;
+            }
+        }
+        else
+        {
+            c->p = mark;
+            if (!skip_value(c, 1))
+            {
+                return false;
+            }
+        }
+        n++;
+    }
+    while (expect(c, ','));
+    return expect(c, ']');
+}
+
+static inline void store_box(sscma_client_box_t *box, const int *v)
+{
+    box->x = v[0];
+    box->y = v[1];
+    box->w = v[2];
+    box->h = v[3];
+    box->score = v[4];
+    box->target = v[5];
+}
+
+static inline void store_point(sscma_client_point_t *point, const int *v)
+{
+    point->x = v[0];
+    point->y = v[1];
+    point->z = 0;
+    point->score = v[2];
+    point->target = v[3];
+}
+
+// Shared walk over an array of results; element() decodes one item into slot i, or skips it if i >= max.
+typedef bool (*element_fn_t)(cursor_t *c, sscma_client_event_t *event, int i);
+
+static bool parse_results(cursor_t *c, sscma_client_event_t *event, int *num, element_fn_t element)
+{
+    *num = 0;
+    if (!expect(c, '['))
+    {
+        return skip_value(c, 0);
+    }
+    if (expect(c, ']'))
+    {
+        return true;
+    }
+    do
+    {
+        if (!element(c, event, *num))
+        {
+            return false;
+        }
+        (*num)++;
+    }
+    while (expect(c, ','));
+    return expect(c, ']');
+}
+
+static bool box_element(cursor_t *c, sscma_client_event_t *event, int i)
+{
+    int v[6];
+    if (event->boxes == NULL || i >= event->max_boxes)
+    {
+        return skip_value(c, 1);
+    }
+    if (!parse_int_array(c, v, 6))
+    {
+        return false;
+    }
+    store_box(&event->boxes[i], v);
+    return true;
+}
+
+static bool class_element(cursor_t *c, sscma_client_event_t *event, int i)
+{
+    int v[2];
+    if (event->classes == NULL || i >= event->max_classes)
+    {
+        return skip_value(c, 1);
+    }
+    if (!parse_int_array(c, v, 2))
+    {
+        return false;
+    }
+    event->classes[i].score = v[0];
+    event->classes[i].target = v[1];
+    return true;
+}
+
+static bool point_element(cursor_t *c, sscma_client_event_t *event, int i)
+{
+    int v[4];
+    if (event->points == NULL || i >= event->max_points)
+    {
+        return skip_value(c, 1);
+    }
+    if (!parse_int_array(c, v, 4))
+    {
+        return false;
+    }
+    store_point(&event->points[i], v);
+    return true;
+}
+
+// [[x, y, w, h, score, target], [[x, y, score, target], ...]]
+static bool keypoint_element(cursor_t *c, sscma_client_event_t *event, int i)
+{
+    int v[6];
+    int n = 0;
+    sscma_client_keypoint_t *keypoint;
+
+    if (event->keypoints == NULL || i >= event->max_keypoints)
+    {
+        return skip_value(c, 1);
+    }
+    keypoint = &event->keypoints[i];
+    keypoint->points_num = 0;
+
+    if (!expect(c, '[') || !parse_int_array(c, v, 6))
+    {
+        return false;
+    }
+    store_box(&keypoint->box, v);
+    if (expect(c, ','))
+    {
+        if (!expect(c, '['))
+        {
+            return false;
+        }
+        if (!expect(c, ']'))
+        {
+            do
+            {
+                if (n < SSCMA_CLIENT_MODEL_KEYPOINTS_MAX)
+                {
+                    if (!parse_int_array(c, v, 4))
+                    {
+                        return false;
+                    }
+                    store_point(&keypoint->points[n], v);
+                }
+                else if (!skip_value(c, 2))
+                {
+                    return false;
+                }
+                n++;
+            }
+            while (expect(c, ','));
+            if (!expect(c, ']'))
+            {
+                return false;
+            }
+        }
+        keypoint->points_num = n > SSCMA_CLIENT_MODEL_KEYPOINTS_MAX ? SSCMA_CLIENT_MODEL_KEYPOINTS_MAX : n;
+        // tolerate trailing members
+        while (expect(c, ','))
+        {
+            if (!skip_value(c, 2))
+            {
+                return false;
+            }
+        }
+    }
+    return expect(c, ']');
+}
+
+static inline bool key_is(const char *key, size_t len, const char *name)
+{
+    return strlen(name) == len && memcmp(key, name, len) == 0;
+}
+
+static bool parse_data(cursor_t *c, sscma_client_event_t *event)
+{
+    const char *key;
+    size_t len;
+
+    if (!expect(c, '{'))
+    {
+        return skip_value(c, 0);
+    }
+    if (expect(c, '}'))
+    {
+        return true;
+    }
+    do
+    {
+        bool ok;
+        if (!parse_string(c, &key, &len) || !expect(c, ':'))
+        {
+            return false;
+        }
+        if (key_is(key, len, "boxes"))
+        {
+            ok = parse_results(c, event, &event->num_boxes, box_element);
+        }
+        else if (key_is(key, len, "classes"))
+        {
+            ok = parse_results(c, event, &event->num_classes, class_element);
+        }
+        else if (key_is(key, len, "points"))
+        {
+            ok = parse_results(c, event, &event->num_points, point_element);
+        }
+        else if (key_is(key, len, "keypoints"))
+        {
+            ok = parse_results(c, event, &event->num_keypoints, keypoint_element);
+        }
+        else if (key_is(key, len, "image") && peek(c, '"'))
+        {
+            ok = parse_string(c, &event->image, &event->image_len);
+        }
+        else if (key_is(key, len, "resolution"))
+        {
+            int v[2];
+            ok = parse_int_array(c, v, 2);
+            event->width = v[0];
+            event->height = v[1];
+        }
+        else if (key_is(key, len, "count"))
+        {
+            const char *mark = c->p;
+            ok = parse_int(c, &event->count);
+            if (!ok)
+            {
+                c->p = mark;
+                ok = skip_value(c, 1);
+            }
+        }
+        else
+        {
+            ok = skip_value(c, 1);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    while (expect(c, ','));
+    return expect(c, '}');
+}
+
+/*
+ * Binary frames carry the same fields as the text reply in fixed-size little-endian
+ * records (see sscma_client_commands.h), so decoding is bounds-checked copying.
+ */
+static inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    *p++ = v & 0xff;
+    *p++ = v >> 8;
+    return p;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p = put_u16(p, v & 0xffff);
+    return put_u16(p, v >> 16);
+}
+
+static inline bool is_binary(const char *data, size_t len)
+{
+    return len >= BINARY_FRAME_MAGIC_LEN && memcmp(data, BINARY_FRAME_MAGIC, BINARY_FRAME_MAGIC_LEN) == 0;
+}
+
+esp_err_t sscma_utils_binary_frame_length(const void *header, size_t *len)
+{
+    const uint8_t *h = header;
+
+    ESP_RETURN_ON_FALSE(header && len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    if (memcmp(h, BINARY_FRAME_MAGIC, BINARY_FRAME_MAGIC_LEN) != 0 || h[4] != BINARY_FRAME_VERSION)
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (esp_rom_crc16_le(0, h, BINARY_FRAME_HEADER_LEN - 2) != get_u16(h + BINARY_FRAME_HEADER_LEN - 2))
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    // bounded so a corrupt header that still passes its CRC cannot wrap the frame length
+    if (get_u32(h + 42) > BINARY_FRAME_MAX_LENGTH)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *len = BINARY_FRAME_HEADER_LEN + get_u32(h + 42);
+    return ESP_OK;
+}
+
+static inline void load_box(sscma_client_box_t *box, const uint8_t *p)
+{
+    box->x = get_u16(p);
+    box->y = get_u16(p + 2);
+    box->w = get_u16(p + 4);
+    box->h = get_u16(p + 6);
+    box->score = p[8];
+    box->target = p[9];
+}
+
+static inline void load_point(sscma_client_point_t *point, const uint8_t *p)
+{
+    point->x = get_u16(p);
+    point->y = get_u16(p + 2);
+    point->z = get_u16(p + 4);
+    point->score = p[6];
+    point->target = p[7];
+}
+
+static inline uint8_t *store_binary_box(uint8_t *p, const sscma_client_box_t *box)
+{
+    p = put_u16(p, box->x);
+    p = put_u16(p, box->y);
+    p = put_u16(p, box->w);
+    p = put_u16(p, box->h);
+    *p++ = box->score;
+    *p++ = box->target;
+    return p;
+}
+
+static inline uint8_t *store_binary_point(uint8_t *p, const sscma_client_point_t *point)
+{
+    p = put_u16(p, point->x);
+    p = put_u16(p, point->y);
+    p = put_u16(p, point->z);
+    *p++ = point->score;
+    *p++ = point->target;
+    return p;
+}
+
+static inline int binary_count(uint16_t v)
+{
+    return v == 0xffff ? INT_MIN : v;
+}
+
+static esp_err_t decode_binary(const uint8_t *data, size_t len, sscma_client_event_t *event)
+{
+    size_t frame_len;
+    const uint8_t *p, *end;
+    int n;
+
+    if (len < BINARY_FRAME_HEADER_LEN || sscma_utils_binary_frame_length(data, &frame_len) != ESP_OK || frame_len < BINARY_FRAME_HEADER_LEN || frame_len > len)
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    event->type = data[5];
+    event->code = (int16_t)get_u16(data + 6);
+    event->name = (const char *)data + 8;
+    event->name_len = strnlen(event->name, BINARY_FRAME_NAME_LEN);
+    event->has_data = true;
+    event->width = get_u16(data + 24);
+    event->height = get_u16(data + 26);
+    event->count = binary_count(get_u16(data + 28));
+    event->num_boxes = get_u16(data + 30);
+    event->num_classes = get_u16(data + 32);
+    event->num_points = get_u16(data + 34);
+    event->num_keypoints = get_u16(data + 36);
+    event->image_len = get_u32(data + 38);
+    event->image_raw = true;
+
+    p = data + BINARY_FRAME_HEADER_LEN;
+    end = data + frame_len;
+
+    n = event->num_boxes;
+    if ((size_t)(end - p) < (size_t)n * BINARY_BOX_LEN)
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    for (int i = 0; event->boxes && i < n && i < event->max_boxes; i++)
+    {
+        load_box(&event->boxes[i], p + i * BINARY_BOX_LEN);
+    }
+    p += n * BINARY_BOX_LEN;
+
+    n = event->num_classes;
+    if ((size_t)(end - p) < (size_t)n * BINARY_CLASS_LEN)
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    for (int i = 0; event->classes && i < n && i < event->max_classes; i++)
+    {
+        event->classes[i].score = p[i * BINARY_CLASS_LEN];
+        event->classes[i].target = p[i * BINARY_CLASS_LEN + 1];
+    }
+    p += n * BINARY_CLASS_LEN;
+
+    n = event->num_points;
+    if ((size_t)(end - p) < (size_t)n * BINARY_POINT_LEN)
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    for (int i = 0; event->points && i < n && i < event->max_points; i++)
+    {
+        load_point(&event->points[i], p + i * BINARY_POINT_LEN);
+    }
+    p += n * BINARY_POINT_LEN;
+
+    // keypoints are variable length, so each record has to be walked
+    for (int i = 0; i < event->num_keypoints; i++)
+    {
+        int points_num;
+        if ((size_t)(end - p) < BINARY_BOX_LEN + 1)
+        {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        points_num = p[BINARY_BOX_LEN];
+        if ((size_t)(end - p) < BINARY_BOX_LEN + 1 + (size_t)points_num * BINARY_POINT_LEN)
+        {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        if (event->keypoints && i < event->max_keypoints)
+        {
+            sscma_client_keypoint_t *keypoint = &event->keypoints[i];
+            load_box(&keypoint->box, p);
+            keypoint->points_num = points_num > SSCMA_CLIENT_MODEL_KEYPOINTS_MAX ? SSCMA_CLIENT_MODEL_KEYPOINTS_MAX : points_num;
+            for (int j = 0; j < keypoint->points_num; j++)
+            {
+                load_point(&keypoint->points[j], p + BINARY_BOX_LEN + 1 + j * BINARY_POINT_LEN);
+            }
+        }
+        p += BINARY_BOX_LEN + 1 + points_num * BINARY_POINT_LEN;
+    }
+
+    if ((size_t)(end - p) < event->image_len)
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    event->image = event->image_len ? (const char *)p : NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_encode_event(const sscma_client_event_t *event, void *buf, size_t size, size_t *ret_len)
+{
+    size_t len = BINARY_FRAME_HEADER_LEN;
+    uint8_t *p = buf;
+
+    ESP_RETURN_ON_FALSE(event && ret_len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(event->num_boxes >= 0 && event->num_boxes <= UINT16_MAX && event->num_classes >= 0 && event->num_classes <= UINT16_MAX && event->num_points >= 0
+                            && event->num_points <= UINT16_MAX && event->num_keypoints >= 0 && event->num_keypoints <= UINT16_MAX,
+                        ESP_ERR_INVALID_ARG, TAG, "too many results");
+
+    len += event->num_boxes * BINARY_BOX_LEN + event->num_classes * BINARY_CLASS_LEN + event->num_points * BINARY_POINT_LEN;
+    for (int i = 0; i < event->num_keypoints; i++)
+    {
+        len += BINARY_BOX_LEN + 1 + event->keypoints[i].points_num * BINARY_POINT_LEN;
+    }
+    len += event->image_len;
+    *ret_len = len;
+    ESP_RETURN_ON_FALSE(len - BINARY_FRAME_HEADER_LEN <= BINARY_FRAME_MAX_LENGTH, ESP_ERR_INVALID_SIZE, TAG, "frame too large");
+
+
+    if (buf == NULL)
+    {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_FALSE(size >= len, ESP_ERR_INVALID_SIZE, TAG, "buffer too small");
+
+    memcpy(p, BINARY_FRAME_MAGIC, BINARY_FRAME_MAGIC_LEN);
+    p += BINARY_FRAME_MAGIC_LEN;
+    *p++ = BINARY_FRAME_VERSION;
+    *p++ = (uint8_t)event->type;
+    p = put_u16(p, (uint16_t)(int16_t)(event->code == INT_MIN ? 0 : event->code));
+    memset(p, 0, BINARY_FRAME_NAME_LEN);
+    if (event->name)
+    {
+        memcpy(p, event->name, event->name_len < BINARY_FRAME_NAME_LEN ? event->name_len : BINARY_FRAME_NAME_LEN);
+    }
+    p += BINARY_FRAME_NAME_LEN;
+    p = put_u16(p, event->width == INT_MIN ? 0 : event->width);
+    p = put_u16(p, event->height == INT_MIN ? 0 : event->height);
+    p = put_u16(p, event->count == INT_MIN ? 0xffff : event->count);
+    p = put_u16(p, event->num_boxes);
+    p = put_u16(p, event->num_classes);
+    p = put_u16(p, event->num_points);
+    p = put_u16(p, event->num_keypoints);
+    p = put_u32(p, event->image_len);
+    p = put_u32(p, len - BINARY_FRAME_HEADER_LEN);
+    p = put_u16(p, esp_rom_crc16_le(0, buf, BINARY_FRAME_HEADER_LEN - 2));
+
+    for (int i = 0; i < event->num_boxes; i++)
+    {
+        p = store_binary_box(p, &event->boxes[i]);
+    }
+    for (int i = 0; i < event->num_classes; i++)
+    {
+        *p++ = event->classes[i].score;
+        *p++ = event->classes[i].target;
+    }
+    for (int i = 0; i < event->num_points; i++)
+    {
+        p = store_binary_point(p, &event->points[i]);
+    }
+    for (int i = 0; i < event->num_keypoints; i++)
+    {
+        p = store_binary_box(p, &event->keypoints[i].box);
+        *p++ = event->keypoints[i].points_num;
+        for (int j = 0; j < event->keypoints[i].points_num; j++)
+        {
+            p = store_binary_point(p, &event->keypoints[i].points[j]);
+        }
+    }
+    if (event->image_len)
+    {
+        memcpy(p, event->image, event->image_len);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_decode_event(const char *data, size_t len, sscma_client_event_t *event)
+{
+    ESP_RETURN_ON_FALSE(data && event, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    cursor_t c = { .p = data, .end = data + len };
+    const char *key;
+    size_t key_len;
+
+    event->image_raw = false;
+    if (is_binary(data, len))
+    {
+        return decode_binary((const uint8_t *)data, len, event);
+    }
+
+    event->type = INT_MIN;
+    event->code = INT_MIN;
+    event->name = NULL;
+    event->name_len = 0;
+    event->count = INT_MIN;
+    event->width = INT_MIN;
+    event->height = INT_MIN;
+    event->num_boxes = 0;
+    event->num_classes = 0;
+    event->num_points = 0;
+    event->num_keypoints = 0;
+    event->image = NULL;
+    event->image_len = 0;
+    event->has_data = false;
+
+    if (!expect(&c, '{'))
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (expect(&c, '}'))
+    {
+        return ESP_OK;
+    }
+    do
+    {
+        bool ok;
+        if (!parse_string(&c, &key, &key_len) || !expect(&c, ':'))
+        {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        if (key_is(key, key_len, "type"))
+        {
+            const char *mark = c.p;
+            ok = parse_int(&c, &event->type) || (c.p = mark, skip_value(&c, 1));
+        }
+        else if (key_is(key, key_len, "code"))
+        {
+            const char *mark = c.p;
+            ok = parse_int(&c, &event->code) || (c.p = mark, skip_value(&c, 1));
+        }
+        else if (key_is(key, key_len, "name") && peek(&c, '"'))
+        {
+            ok = parse_string(&c, &event->name, &event->name_len);
+        }
+        else if (key_is(key, key_len, "data") && peek(&c, '{'))
+        {
+            event->has_data = true;
+            ok = parse_data(&c, event);
+        }
+        else
+        {
+            ok = skip_value(&c, 1);
+        }
+        if (!ok)
+        {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    while (expect(&c, ','));
+
+    return expect(&c, '}') ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
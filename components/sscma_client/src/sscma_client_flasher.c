@@ -32,6 +32,16 @@ esp_err_t sscma_client_flasher_abort(sscma_client_flasher_handle_t handle)
     return handle->abort(handle);
 }
 
+esp_err_t sscma_client_flasher_verify(sscma_client_flasher_handle_t handle, uint32_t *crc)
+{
+    ESP_RETURN_ON_FALSE(handle && crc, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (handle->verify == NULL)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return handle->verify(handle, crc);
+}
+
 esp_err_t sscma_client_flasher_delete(sscma_client_flasher_handle_t handle)
 {
     ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -2,6 +2,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <sys/cdefs.h>
+#include <sys/param.h>
 #include "sdkconfig.h"
 #if CONFIG_SSCMA_ENABLE_DEBUG_LOG
 // The local log level must be defined before including esp_log.h
@@ -16,6 +17,7 @@
 #include "esp_log.h"
 #include "esp_check.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 
 #include "sscma_client_commands.h"
 #include "sscma_client_io.h"
@@ -51,6 +53,7 @@ typedef enum {
 #define OTA_CONTROL_REG_DEFAULT (0x028C208B)
 
 #define OTA_CHUNKED_SIZE (256)
+#define OTA_BURST_MAX    (15) // pages per transaction, bounded by the bus max_transfer_sz (4095)
 
 #define OTA_CMD_WRITE        (0xF2)
 #define OTA_CMD_READ         (0xF3)
@@ -65,6 +68,7 @@ static esp_err_t sscma_client_flasher_we2_start(sscma_client_flasher_handle_t fl
 static esp_err_t sscma_client_flasher_we2_write(sscma_client_flasher_handle_t flasher, const void *data, size_t len);
 static esp_err_t sscma_client_flasher_we2_finish(sscma_client_flasher_handle_t flasher);
 static esp_err_t sscma_client_flasher_we2_abort(sscma_client_flasher_handle_t flasher);
+static esp_err_t sscma_client_flasher_we2_verify(sscma_client_flasher_handle_t flasher, uint32_t *crc);
 static esp_err_t sscma_client_flasher_we2_del(sscma_client_flasher_handle_t flasher);
 
 typedef struct
@@ -77,8 +81,16 @@ typedef struct
     size_t offset;                        /*!< The offset. */
     uint32_t count;                       /*!< The Page Program Count. */
     void *user_ctx;                       /* !< User context */
-    uint8_t data[OTA_CHUNKED_SIZE + 6];   /* !< The data buffer. */
-    SemaphoreHandle_t lock;               /*!< The lock. */
+    size_t burst_size;                    /*!< Bytes per burst write. */
+    uint8_t *buffer[2];                   /*!< Burst buffers (DMA), one is sent while the other is staged. */
+    uint8_t *cmd;                         /*!< Command/status buffer (DMA). */
+    struct
+    {
+        int64_t start; /*!< Time flashing started (us). */
+        int64_t wait;  /*!< Time spent waiting on page programs (us). */
+        size_t bytes;  /*!< Bytes programmed. */
+    } stats;
+    SemaphoreHandle_t lock; /*!< The lock. */
 } sscma_client_flasher_we2_spi_t;
 
 esp_err_t sscma_client_new_flasher_we2_spi(const sscma_client_io_handle_t io, const sscma_client_flasher_we2_config_t *config, sscma_client_flasher_handle_t *ret_flasher)
@@ -97,10 +109,20 @@ esp_err_t sscma_client_new_flasher_we2_spi(const sscma_client_io_handle_t io, co
 
     flasher_we2->io = io;
 
+    flasher_we2->burst_size = (config->burst_pages > 0 ? MIN(config->burst_pages, OTA_BURST_MAX) : 1) * OTA_CHUNKED_SIZE;
+    for (int i = 0; i < 2; i++)
+    {
+        flasher_we2->buffer[i] = heap_caps_malloc(flasher_we2->burst_size + 6, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_GOTO_ON_FALSE(flasher_we2->buffer[i], ESP_ERR_NO_MEM, err, TAG, "no mem for burst buffer");
+    }
+    flasher_we2->cmd = heap_caps_malloc(16, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ESP_GOTO_ON_FALSE(flasher_we2->cmd, ESP_ERR_NO_MEM, err, TAG, "no mem for command buffer");
+
     flasher_we2->base.start = sscma_client_flasher_we2_start;
     flasher_we2->base.write = sscma_client_flasher_we2_write;
     flasher_we2->base.finish = sscma_client_flasher_we2_finish;
     flasher_we2->base.abort = sscma_client_flasher_we2_abort;
+    flasher_we2->base.verify = sscma_client_flasher_we2_verify;
     flasher_we2->base.del = sscma_client_flasher_we2_del;
 
     if (config->flags.reset_use_expander)
@@ -131,6 +153,9 @@ err:
     {
         vSemaphoreDelete(flasher_we2->lock);
     }
+    free(flasher_we2->buffer[0]);
+    free(flasher_we2->buffer[1]);
+    free(flasher_we2->cmd);
     if (flasher_we2->reset_gpio_num >= 0)
     {
         if (flasher_we2->io_expander)
@@ -157,6 +182,9 @@ esp_err_t sscma_client_flasher_we2_del(sscma_client_flasher_handle_t flasher)
     {
         vSemaphoreDelete(flasher_we2->lock);
     }
+    free(flasher_we2->buffer[0]);
+    free(flasher_we2->buffer[1]);
+    free(flasher_we2->cmd);
     if (flasher_we2->reset_gpio_num >= 0)
     {
         if (flasher_we2->io_expander)
@@ -175,14 +203,171 @@ esp_err_t sscma_client_flasher_we2_del(sscma_client_flasher_handle_t flasher)
     return ESP_OK;
 }
 
+static void sscma_client_flasher_we2_burst_prepare(uint8_t *buffer, uint32_t addr, const void *data, size_t len)
+{
+    buffer[0] = OTA_CMD_WRITE;
+    buffer[1] = OTA_BURST_WRITE_REG;
+    buffer[2] = (addr & 0xFF);
+    buffer[3] = (addr >> 8) & 0xFF;
+    buffer[4] = (addr >> 16) & 0xFF;
+    buffer[5] = (addr >> 24) & 0xFF;
+    if (data)
+    {
+        memcpy(&buffer[6], data, len);
+    }
+    else
+    {
+        memset(&buffer[6], 0xFF, len);
+    }
+}
+
+static esp_err_t sscma_client_flasher_we2_reg_read(sscma_client_flasher_we2_spi_t *flasher_we2, uint32_t addr, uint32_t *value)
+{
+    uint8_t *cmd = flasher_we2->cmd;
+    spi_transaction_t spi_trans = {};
+
+    // Register accesses are a few bytes each, polling them avoids an interrupt round trip per access
+    cmd[0] = OTA_CMD_WRITE;
+    cmd[1] = OTA_BURST_WRITE_REG;
+    cmd[2] = (addr & 0xFF);
+    cmd[3] = (addr >> 8) & 0xFF;
+    cmd[4] = (addr >> 16) & 0xFF;
+    cmd[5] = (addr >> 24) & 0xFF;
+    spi_trans.length = (6) * 8;
+    spi_trans.tx_buffer = cmd;
+    spi_trans.rx_buffer = NULL;
+    spi_trans.rxlength = 0;
+    ESP_RETURN_ON_ERROR(spi_device_polling_transmit(flasher_we2->io->handle, &spi_trans), TAG, "set address failed");
+
+    cmd[0] = OTA_CMD_WRITE;
+    cmd[1] = OTA_STATUS_REG;
+    cmd[2] = 0;
+    spi_trans.length = (3) * 8;
+    spi_trans.tx_buffer = cmd;
+    spi_trans.rx_buffer = NULL;
+    spi_trans.rxlength = 0;
+    ESP_RETURN_ON_ERROR(spi_device_polling_transmit(flasher_we2->io->handle, &spi_trans), TAG, "select read failed");
+
+    memset(&cmd[0], 0x00, 7);
+    memset(&cmd[7], 0xFF, 7);
+    cmd[0] = OTA_CMD_READ;
+    cmd[1] = 0x08;
+    cmd[2] = 0x00;
+    spi_trans.length = 7 * 8;
+    spi_trans.tx_buffer = &cmd[0];
+    spi_trans.rx_buffer = &cmd[7];
+    spi_trans.rxlength = 7 * 8;
+    ESP_RETURN_ON_ERROR(spi_device_polling_transmit(flasher_we2->io->handle, &spi_trans), TAG, "read failed");
+    memcpy(value, &cmd[10], 4);
+
+    return ESP_OK;
+}
+
+static esp_err_t sscma_client_flasher_we2_reg_write(sscma_client_flasher_we2_spi_t *flasher_we2, uint32_t addr, uint32_t value)
+{
+    uint8_t *cmd = flasher_we2->cmd;
+    spi_transaction_t spi_trans = {};
+
+    cmd[0] = OTA_CMD_WRITE;
+    cmd[1] = OTA_BURST_WRITE_REG;
+    cmd[2] = (addr & 0xFF);
+    cmd[3] = (addr >> 8) & 0xFF;
+    cmd[4] = (addr >> 16) & 0xFF;
+    cmd[5] = (addr >> 24) & 0xFF;
+    cmd[6] = (value & 0xFF);
+    cmd[7] = (value >> 8) & 0xFF;
+    cmd[8] = (value >> 16) & 0xFF;
+    cmd[9] = (value >> 24) & 0xFF;
+    spi_trans.length = 10 * 8;
+    spi_trans.tx_buffer = cmd;
+    spi_trans.rx_buffer = NULL;
+    spi_trans.rxlength = 0;
+
+    return spi_device_polling_transmit(flasher_we2->io->handle, &spi_trans);
+}
+
+static esp_err_t sscma_client_flasher_we2_crc_clear(sscma_client_flasher_we2_spi_t *flasher_we2)
+{
+    ESP_RETURN_ON_ERROR(sscma_client_flasher_we2_reg_write(flasher_we2, OTA_CRC_CLEAR_ADDR, 1), TAG, "clear crc failed");
+    return sscma_client_flasher_we2_reg_write(flasher_we2, OTA_CRC_CLEAR_ADDR, 0);
+}
+
+static esp_err_t sscma_client_flasher_we2_wait(sscma_client_flasher_we2_spi_t *flasher_we2, int64_t timeout)
+{
+    esp_err_t ret = ESP_OK;
+    int64_t start = esp_timer_get_time();
+    uint32_t status = 0xFFFFFFFF;
+
+    do
+    {
+        status = 0;
+        ESP_RETURN_ON_ERROR(sscma_client_flasher_we2_reg_read(flasher_we2, OTA_PPDONE_COUNT_ADDR, &status), TAG, "read status failed");
+        if ((esp_timer_get_time() - start) > timeout)
+        {
+            ESP_LOGE(TAG, "Timeout");
+            return ESP_ERR_TIMEOUT;
+        }
+        taskYIELD();
+    }
+    while (!((status >> 28) == 1 || (status & 0xFFFFF) == flasher_we2->count));
+
+    flasher_we2->stats.wait += esp_timer_get_time() - start;
+
+    // CRC Error
+    if (((status >> 28) == 1) || (status >> 28) == 3)
+    {
+        ESP_LOGE(TAG, "CRC Error");
+        ret = ESP_FAIL;
+    }
+
+    return ret;
+}
+
+static esp_err_t sscma_client_flasher_we2_program(sscma_client_flasher_we2_spi_t *flasher_we2, uint32_t addr, const void *data, size_t len, int64_t timeout)
+{
+    esp_err_t ret = ESP_OK;
+    size_t remain = len;
+    size_t burst = 0;
+    size_t next = 0;
+    int index = 0;
+    spi_transaction_t spi_trans = {};
+
+    burst = MIN(remain, flasher_we2->burst_size);
+    sscma_client_flasher_we2_burst_prepare(flasher_we2->buffer[index], addr, data, burst);
+    do
+    {
+        spi_trans.length = (6 + burst) * 8;
+        spi_trans.tx_buffer = flasher_we2->buffer[index];
+        spi_trans.rx_buffer = NULL;
+        spi_trans.rxlength = 0;
+        ESP_RETURN_ON_ERROR(spi_device_transmit(flasher_we2->io->handle, &spi_trans), TAG, "burst write failed");
+
+        remain -= burst;
+        addr += burst;
+        flasher_we2->count += burst / OTA_CHUNKED_SIZE;
+        flasher_we2->stats.bytes += burst;
+
+        // Stage the next burst in the other buffer while the WE2 programs this one
+        if (remain > 0)
+        {
+            next = MIN(remain, flasher_we2->burst_size);
+            index ^= 1;
+            sscma_client_flasher_we2_burst_prepare(flasher_we2->buffer[index], addr, data ? (const uint8_t *)data + (len - remain) : NULL, next);
+        }
+
+        ESP_RETURN_ON_ERROR(sscma_client_flasher_we2_wait(flasher_we2, timeout), TAG, "page program failed");
+        burst = next;
+    }
+    while (remain > 0);
+
+    return ret;
+}
+
 static esp_err_t sscma_client_flasher_we2_start(sscma_client_flasher_handle_t flasher, size_t offset)
 {
     esp_err_t ret = ESP_OK;
-    int64_t start = 0;
-    uint32_t addr = 0;
-    size_t remain = 0;
-    uint32_t status = 0;
     sscma_client_flasher_we2_spi_t *flasher_we2 = __containerof(flasher, sscma_client_flasher_we2_spi_t, base);
+    uint8_t *cmd = flasher_we2->cmd;
     spi_transaction_t spi_trans = {};
 
     // assert(offset >= OTA_START_OFFSET);
@@ -190,14 +375,16 @@ static esp_err_t sscma_client_flasher_we2_start(sscma_client_flasher_handle_t fl
 
     flasher_we2->count = 0;
     flasher_we2->offset = offset;
+    memset(&flasher_we2->stats, 0, sizeof(flasher_we2->stats));
+    flasher_we2->stats.start = esp_timer_get_time();
 
     ESP_GOTO_ON_ERROR(spi_device_acquire_bus(flasher_we2->io->handle, portMAX_DELAY), err, TAG, "acquire spi bus failed");
 
-    flasher_we2->data[0] = OTA_CMD_WRITE;
-    flasher_we2->data[1] = OTA_ENABLE_REG;
-    flasher_we2->data[2] = REG_D8_ISP_EN + REG_D8_TEST_MODE + REG_D8_SPI_DO_EN;
+    cmd[0] = OTA_CMD_WRITE;
+    cmd[1] = OTA_ENABLE_REG;
+    cmd[2] = REG_D8_ISP_EN + REG_D8_TEST_MODE + REG_D8_SPI_DO_EN;
     spi_trans.length = 3 * 8;
-    spi_trans.tx_buffer = flasher_we2->data;
+    spi_trans.tx_buffer = cmd;
     spi_trans.rx_buffer = NULL;
     spi_trans.rxlength = 0;
     ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
@@ -207,11 +394,11 @@ static esp_err_t sscma_client_flasher_we2_start(sscma_client_flasher_handle_t fl
         goto err;
     }
 
-    flasher_we2->data[0] = OTA_CMD_WRITE;
-    flasher_we2->data[1] = OTA_BURST_ENABLE_REG;
-    flasher_we2->data[2] = 0x31;
+    cmd[0] = OTA_CMD_WRITE;
+    cmd[1] = OTA_BURST_ENABLE_REG;
+    cmd[2] = 0x31;
     spi_trans.length = 3 * 8;
-    spi_trans.tx_buffer = flasher_we2->data;
+    spi_trans.tx_buffer = cmd;
     spi_trans.rx_buffer = NULL;
     spi_trans.rxlength = 0;
     ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
@@ -221,11 +408,11 @@ static esp_err_t sscma_client_flasher_we2_start(sscma_client_flasher_handle_t fl
         goto err;
     }
 
-    flasher_we2->data[0] = OTA_CMD_WRITE;
-    flasher_we2->data[1] = OTA_BURST_MODE_REG;
-    flasher_we2->data[2] = 0x11;
+    cmd[0] = OTA_CMD_WRITE;
+    cmd[1] = OTA_BURST_MODE_REG;
+    cmd[2] = 0x11;
     spi_trans.length = 3 * 8;
-    spi_trans.tx_buffer = flasher_we2->data;
+    spi_trans.tx_buffer = cmd;
     spi_trans.rx_buffer = NULL;
     spi_trans.rxlength = 0;
     ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
@@ -235,18 +422,18 @@ static esp_err_t sscma_client_flasher_we2_start(sscma_client_flasher_handle_t fl
         goto err;
     }
 
-    flasher_we2->data[0] = OTA_CMD_WRITE;
-    flasher_we2->data[1] = 0x00;
-    flasher_we2->data[2] = (OTA_CONTROL_ADDR & 0xFF);
-    flasher_we2->data[3] = (OTA_CONTROL_ADDR >> 8) & 0xFF;
-    flasher_we2->data[4] = (OTA_CONTROL_ADDR >> 16) & 0xFF;
-    flasher_we2->data[5] = (OTA_CONTROL_ADDR >> 24) & 0xFF;
-    flasher_we2->data[6] = (OTA_CONTROL_REG_DEFAULT & 0xFF);
-    flasher_we2->data[7] = (OTA_CONTROL_REG_DEFAULT >> 8) & 0xFF;
-    flasher_we2->data[8] = (OTA_CONTROL_REG_DEFAULT >> 16) & 0xFF;
-    flasher_we2->data[9] = (OTA_CONTROL_REG_DEFAULT >> 24) & 0xFF;
+    cmd[0] = OTA_CMD_WRITE;
+    cmd[1] = OTA_BURST_WRITE_REG;
+    cmd[2] = (OTA_CONTROL_ADDR & 0xFF);
+    cmd[3] = (OTA_CONTROL_ADDR >> 8) & 0xFF;
+    cmd[4] = (OTA_CONTROL_ADDR >> 16) & 0xFF;
+    cmd[5] = (OTA_CONTROL_ADDR >> 24) & 0xFF;
+    cmd[6] = (OTA_CONTROL_REG_DEFAULT & 0xFF);
+    cmd[7] = (OTA_CONTROL_REG_DEFAULT >> 8) & 0xFF;
+    cmd[8] = (OTA_CONTROL_REG_DEFAULT >> 16) & 0xFF;
+    cmd[9] = (OTA_CONTROL_REG_DEFAULT >> 24) & 0xFF;
     spi_trans.length = 10 * 8;
-    spi_trans.tx_buffer = flasher_we2->data;
+    spi_trans.tx_buffer = cmd;
     spi_trans.rx_buffer = NULL;
     spi_trans.rxlength = 0;
     ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
@@ -256,108 +443,28 @@ static esp_err_t sscma_client_flasher_we2_start(sscma_client_flasher_handle_t fl
         goto err;
     }
 
+    ret = sscma_client_flasher_we2_crc_clear(flasher_we2);
+    if (ret != ESP_OK)
+    {
+        spi_device_release_bus(flasher_we2->io->handle);
+        goto err;
+    }
+
     // if offset == 0, clear boot slot magic first
     if (offset == 0)
     {
         ESP_LOGW(TAG, "Writing firmware... clearing magic for boot from slot 0");
-        remain = 4096; // magic partition size 4K
-        addr = OTA_BASE_ADDR + OTA_MAX_OFFSET - remain;
-        // write chunk
-        do
+        // magic partition size 4K
+        ret = sscma_client_flasher_we2_program(flasher_we2, OTA_BASE_ADDR + OTA_MAX_OFFSET - 4096, NULL, 4096, 10000000);
+        if (ret == ESP_OK)
         {
-            flasher_we2->data[0] = OTA_CMD_WRITE;
-            flasher_we2->data[1] = 0x00;
-            flasher_we2->data[2] = (addr & 0xFF);
-            flasher_we2->data[3] = (addr >> 8) & 0xFF;
-            flasher_we2->data[4] = (addr >> 16) & 0xFF;
-            flasher_we2->data[5] = (addr >> 24) & 0xFF;
-            memset(flasher_we2->data + 6, 0xFF, OTA_CHUNKED_SIZE);
-            spi_trans.length = (6 + OTA_CHUNKED_SIZE) * 8;
-            spi_trans.tx_buffer = flasher_we2->data;
-            spi_trans.rx_buffer = NULL;
-            spi_trans.rxlength = 0;
-            ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-            if (ret != ESP_OK)
-            {
-                spi_device_release_bus(flasher_we2->io->handle);
-                goto err;
-            }
-
-            remain -= OTA_CHUNKED_SIZE;
-            addr += OTA_CHUNKED_SIZE;
-            flasher_we2->count++;
-
-            // check status
-            start = esp_timer_get_time();
-            status = 0xFFFFFFFF;
-            do
-            {
-                flasher_we2->data[0] = OTA_CMD_WRITE;
-                flasher_we2->data[1] = 0x00;
-                flasher_we2->data[2] = (OTA_PPDONE_COUNT_ADDR & 0xFF);
-                flasher_we2->data[3] = (OTA_PPDONE_COUNT_ADDR >> 8) & 0xFF;
-                flasher_we2->data[4] = (OTA_PPDONE_COUNT_ADDR >> 16) & 0xFF;
-                flasher_we2->data[5] = (OTA_PPDONE_COUNT_ADDR >> 24) & 0xFF;
-                spi_trans.length = (6) * 8;
-                spi_trans.tx_buffer = &flasher_we2->data;
-                spi_trans.rx_buffer = NULL;
-                spi_trans.rxlength = 0;
-                ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-                if (ret != ESP_OK)
-                {
-                    spi_device_release_bus(flasher_we2->io->handle);
-                    goto err;
-                }
-
-                flasher_we2->data[0] = OTA_CMD_WRITE;
-                flasher_we2->data[1] = OTA_STATUS_REG;
-                flasher_we2->data[2] = 0;
-                spi_trans.length = (3) * 8;
-                spi_trans.tx_buffer = &flasher_we2->data;
-                spi_trans.rx_buffer = NULL;
-                spi_trans.rxlength = 0;
-                ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-                if (ret != ESP_OK)
-                {
-                    spi_device_release_bus(flasher_we2->io->handle);
-                    goto err;
-                }
-                status = 0;
-                memset(&flasher_we2->data[0], 0x00, 7);
-                memset(&flasher_we2->data[7], 0xFF, 7);
-                flasher_we2->data[0] = OTA_CMD_READ;
-                flasher_we2->data[1] = 0x08;
-                flasher_we2->data[2] = 0x00;
-                spi_trans.length = 7 * 8;
-                spi_trans.tx_buffer = &flasher_we2->data[0];
-                spi_trans.rx_buffer = &flasher_we2->data[7];
-                spi_trans.rxlength = 7 * 8;
-                ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-                if (ret != ESP_OK)
-                {
-                    spi_device_release_bus(flasher_we2->io->handle);
-                    goto err;
-                }
-                memcpy(&status, &flasher_we2->data[10], 4);
-                if ((esp_timer_get_time() - start) > 10000000)
-                {
-                    spi_device_release_bus(flasher_we2->io->handle);
-                    ESP_LOGE(TAG, "Timeout");
-                    ret = ESP_ERR_TIMEOUT;
-                    goto err;
-                }
-                taskYIELD();
-            }
-            while (!((status >> 28) == 1 || (status & 0xFFFFF) == flasher_we2->count));
-            // CRC Error
-            if (((status >> 28) == 1) || (status >> 28) == 3)
-            {
-                ESP_LOGE(TAG, "CRC Error");
-                ret = ESP_FAIL;
-                goto err;
-            }
+            ret = sscma_client_flasher_we2_crc_clear(flasher_we2); // the CRCs cover the image only
+        }
+        if (ret != ESP_OK)
+        {
+            spi_device_release_bus(flasher_we2->io->handle);
+            goto err;
         }
-        while (remain > 0);
     }
 
     spi_device_release_bus(flasher_we2->io->handle);
@@ -396,123 +503,68 @@ err:
 static esp_err_t sscma_client_flasher_we2_write(sscma_client_flasher_handle_t flasher, const void *data, size_t len)
 {
     esp_err_t ret = ESP_OK;
-    int64_t start = 0;
-    size_t remain = len;
-    uint32_t addr = 0;
-    uint32_t status = 0;
-    spi_transaction_t spi_trans = {};
     sscma_client_flasher_we2_spi_t *flasher_we2 = __containerof(flasher, sscma_client_flasher_we2_spi_t, base);
     assert(len % OTA_CHUNKED_SIZE == 0);
     assert(flasher_we2->offset + len <= OTA_MAX_OFFSET);
 
     xSemaphoreTake(flasher_we2->lock, portMAX_DELAY);
     ESP_GOTO_ON_ERROR(spi_device_acquire_bus(flasher_we2->io->handle, portMAX_DELAY), err, TAG, "acquire spi bus failed");
-    do
+
+    ret = sscma_client_flasher_we2_program(flasher_we2, OTA_BASE_ADDR + flasher_we2->offset, data, len, 3000000);
+    if (ret == ESP_OK)
     {
-        // write chunk
-        addr = OTA_BASE_ADDR + flasher_we2->offset;
-        flasher_we2->data[0] = OTA_CMD_WRITE;
-        flasher_we2->data[1] = 0x00;
-        flasher_we2->data[2] = (addr & 0xFF);
-        flasher_we2->data[3] = (addr >> 8) & 0xFF;
-        flasher_we2->data[4] = (addr >> 16) & 0xFF;
-        flasher_we2->data[5] = (addr >> 24) & 0xFF;
-        memcpy(&flasher_we2->data[6], (uint8_t *)data + (len - remain), OTA_CHUNKED_SIZE);
-        spi_trans.length = (6 + OTA_CHUNKED_SIZE) * 8;
-        spi_trans.tx_buffer = flasher_we2->data;
-        spi_trans.rx_buffer = NULL;
-        spi_trans.rxlength = 0;
-        ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-        if (ret != ESP_OK)
-        {
-            spi_device_release_bus(flasher_we2->io->handle);
-            goto err;
-        }
-        remain -= OTA_CHUNKED_SIZE;
-        flasher_we2->offset += OTA_CHUNKED_SIZE;
-        flasher_we2->count++;
-
-        // check status
-        start = esp_timer_get_time();
-        status = 0xFFFFFFFF;
-        do
-        {
-            flasher_we2->data[0] = OTA_CMD_WRITE;
-            flasher_we2->data[1] = 0x00;
-            flasher_we2->data[2] = (OTA_PPDONE_COUNT_ADDR & 0xFF);
-            flasher_we2->data[3] = (OTA_PPDONE_COUNT_ADDR >> 8) & 0xFF;
-            flasher_we2->data[4] = (OTA_PPDONE_COUNT_ADDR >> 16) & 0xFF;
-            flasher_we2->data[5] = (OTA_PPDONE_COUNT_ADDR >> 24) & 0xFF;
-            spi_trans.length = (6) * 8;
-            spi_trans.tx_buffer = &flasher_we2->data;
-            spi_trans.rx_buffer = NULL;
-            spi_trans.rxlength = 0;
-            ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-            if (ret != ESP_OK)
-            {
-                spi_device_release_bus(flasher_we2->io->handle);
-                goto err;
-            }
+        flasher_we2->offset += len;
+    }
 
-            flasher_we2->data[0] = OTA_CMD_WRITE;
-            flasher_we2->data[1] = OTA_STATUS_REG;
-            flasher_we2->data[2] = 0;
-            spi_trans.length = (3) * 8;
-            spi_trans.tx_buffer = &flasher_we2->data;
-            spi_trans.rx_buffer = NULL;
-            spi_trans.rxlength = 0;
-            ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-            if (ret != ESP_OK)
-            {
-                spi_device_release_bus(flasher_we2->io->handle);
-                goto err;
-            }
-            status = 0;
-            memset(&flasher_we2->data[0], 0x00, 7);
-            memset(&flasher_we2->data[7], 0xFF, 7);
-            flasher_we2->data[0] = OTA_CMD_READ;
-            flasher_we2->data[1] = 0x08;
-            flasher_we2->data[2] = 0x00;
-            spi_trans.length = 7 * 8;
-            spi_trans.tx_buffer = &flasher_we2->data[0];
-            spi_trans.rx_buffer = &flasher_we2->data[7];
-            spi_trans.rxlength = 7 * 8;
-            ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
-            if (ret != ESP_OK)
-            {
-                spi_device_release_bus(flasher_we2->io->handle);
-                goto err;
-            }
-            memcpy(&status, &flasher_we2->data[10], 4);
-            if ((esp_timer_get_time() - start) > 3000000)
-            {
-                spi_device_release_bus(flasher_we2->io->handle);
-                ESP_LOGE(TAG, "Timeout");
-                ret = ESP_ERR_TIMEOUT;
-                goto err;
-            }
-            taskYIELD();
-        }
-        while (!((status >> 28) == 1 || (status & 0xFFFFF) == flasher_we2->count));
-        // CRC Error
-        if (((status >> 28) == 1) || (status >> 28) == 3)
+    spi_device_release_bus(flasher_we2->io->handle);
+err:
+    xSemaphoreGive(flasher_we2->lock);
+
+    return ret;
+}
+static esp_err_t sscma_client_flasher_we2_verify(sscma_client_flasher_handle_t flasher, uint32_t *crc)
+{
+    esp_err_t ret = ESP_OK;
+    uint32_t written = 0;
+    uint32_t read = 0;
+    sscma_client_flasher_we2_spi_t *flasher_we2 = __containerof(flasher, sscma_client_flasher_we2_spi_t, base);
+
+    xSemaphoreTake(flasher_we2->lock, portMAX_DELAY);
+    ESP_GOTO_ON_ERROR(spi_device_acquire_bus(flasher_we2->io->handle, portMAX_DELAY), err, TAG, "acquire spi bus failed");
+
+    // The WE2 keeps a CRC of the data it received and one of the data it read back after programming
+    ret = sscma_client_flasher_we2_reg_read(flasher_we2, OTA_CRC_WRITTEN_ADDR, &written);
+    if (ret == ESP_OK)
+    {
+        ret = sscma_client_flasher_we2_reg_read(flasher_we2, OTA_CRC_READ_ADDR, &read);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = sscma_client_flasher_we2_crc_clear(flasher_we2);
+    }
+
+    spi_device_release_bus(flasher_we2->io->handle);
+
+    if (ret == ESP_OK)
+    {
+        *crc = read;
+        if (read != written)
         {
-            ESP_LOGE(TAG, "CRC Error");
-            ret = ESP_FAIL;
-            goto err;
+            ESP_LOGE(TAG, "Read-back CRC 0x%08lx, written 0x%08lx", (unsigned long)read, (unsigned long)written);
+            ret = ESP_ERR_INVALID_CRC;
         }
     }
-    while (remain > 0);
 
-    spi_device_release_bus(flasher_we2->io->handle);
 err:
     xSemaphoreGive(flasher_we2->lock);
 
     return ret;
 }
+
 static esp_err_t sscma_client_flasher_we2_finish(sscma_client_flasher_handle_t flasher)
 {
     esp_err_t ret = ESP_OK;
+    int64_t elapsed = 0;
     spi_transaction_t spi_trans = {};
     sscma_client_flasher_we2_spi_t *flasher_we2 = __containerof(flasher, sscma_client_flasher_we2_spi_t, base);
 
@@ -520,17 +572,24 @@ static esp_err_t sscma_client_flasher_we2_finish(sscma_client_flasher_handle_t f
 
     ESP_GOTO_ON_ERROR(spi_device_acquire_bus(flasher_we2->io->handle, portMAX_DELAY), err, TAG, "acquire spi bus failed");
 
-    flasher_we2->data[0] = OTA_CMD_WRITE;
-    flasher_we2->data[1] = OTA_ENABLE_REG;
-    flasher_we2->data[2] = REG_OFF;
+    flasher_we2->cmd[0] = OTA_CMD_WRITE;
+    flasher_we2->cmd[1] = OTA_ENABLE_REG;
+    flasher_we2->cmd[2] = REG_OFF;
     spi_trans.length = 3 * 8;
-    spi_trans.tx_buffer = &flasher_we2->data;
+    spi_trans.tx_buffer = flasher_we2->cmd;
     spi_trans.rx_buffer = NULL;
     spi_trans.rxlength = 0;
     ret = spi_device_transmit(flasher_we2->io->handle, &spi_trans);
 
     spi_device_release_bus(flasher_we2->io->handle);
 
+    elapsed = esp_timer_get_time() - flasher_we2->stats.start;
+    if (elapsed > 0)
+    {
+        ESP_LOGI(TAG, "Programmed %d bytes in %lld ms, %d KB/s, %d%% waiting on page program", flasher_we2->stats.bytes, elapsed / 1000,
+            (int)(flasher_we2->stats.bytes * 1000000LL / 1024 / elapsed), (int)(flasher_we2->stats.wait * 100 / elapsed));
+    }
+
 err:
     if (flasher_we2->reset_gpio_num >= 0)
     {
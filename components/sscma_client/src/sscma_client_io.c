@@ -1,10 +1,12 @@
+#include <string.h>
 #include "esp_check.h"
+#include "esp_timer.h"
 #include "sscma_client_io.h"
 #include "sscma_client_io_interface.h"
 
 static const char *TAG = "sscma_client.io";
 
-esp_err_t sscma_client_io_del(sscma_client_io_t *io)
+esp_err_t sscma_client_del_io(sscma_client_io_t *io)
 {
     ESP_RETURN_ON_FALSE(io, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     ESP_RETURN_ON_FALSE(io->del, ESP_ERR_NOT_SUPPORTED, TAG, "del not supported");
@@ -17,7 +19,17 @@ esp_err_t sscma_client_io_write(sscma_client_io_t *io, const void *data, size_t
     ESP_RETURN_ON_FALSE(io->write, ESP_ERR_NOT_SUPPORTED, TAG, "write not supported");
     assert(len > 0);
     assert(data);
-    return io->write(io, data, len);
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = io->write(io, data, len);
+    int64_t elapsed = esp_timer_get_time() - start;
+    io->stats.writes++;
+    io->stats.write_bytes += len;
+    io->stats.write_time_us += elapsed;
+    if (elapsed > io->stats.write_max_us)
+    {
+        io->stats.write_max_us = elapsed;
+    }
+    return ret;
 }
 
 esp_err_t sscma_client_io_read(sscma_client_io_t *io, void *data, size_t len)
@@ -25,7 +37,17 @@ esp_err_t sscma_client_io_read(sscma_client_io_t *io, void *data, size_t len)
     ESP_RETURN_ON_FALSE(io, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     ESP_RETURN_ON_FALSE(io->read, ESP_ERR_NOT_SUPPORTED, TAG, "read not supported");
     assert(data);
-    return io->read(io, data, len);
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = io->read(io, data, len);
+    int64_t elapsed = esp_timer_get_time() - start;
+    io->stats.reads++;
+    io->stats.read_bytes += len;
+    io->stats.read_time_us += elapsed;
+    if (elapsed > io->stats.read_max_us)
+    {
+        io->stats.read_max_us = elapsed;
+    }
+    return ret;
 }
 
 esp_err_t sscma_client_io_available(sscma_client_io_t *io, size_t *ret_avail)
@@ -41,3 +63,24 @@ esp_err_t sscma_client_io_flush(sscma_client_io_t *io)
     ESP_RETURN_ON_FALSE(io->flush, ESP_ERR_NOT_SUPPORTED, TAG, "flush not supported");
     return io->flush(io);
 }
+
+esp_err_t sscma_client_io_set_rx_notify(sscma_client_io_t *io, sscma_client_io_notify_cb_t cb, void *arg)
+{
+    ESP_RETURN_ON_FALSE(io, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (io->set_rx_notify == NULL)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return io->set_rx_notify(io, cb, arg);
+}
+
+esp_err_t sscma_client_io_get_stats(sscma_client_io_t *io, sscma_client_io_stats_t *stats, bool reset)
+{
+    ESP_RETURN_ON_FALSE(io && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    *stats = io->stats;
+    if (reset)
+    {
+        memset(&io->stats, 0, sizeof(io->stats));
+    }
+    return ESP_OK;
+}
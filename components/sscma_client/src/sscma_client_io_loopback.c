@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "sscma_client_io_interface.h"
+#include "sscma_client_io.h"
+#include "esp_log.h"
+#include "esp_check.h"
+
+static const char *TAG = "sscma_client.io.loopback";
+
+static esp_err_t client_io_loopback_del(sscma_client_io_t *io);
+static esp_err_t client_io_loopback_write(sscma_client_io_t *io, const void *data, size_t len);
+static esp_err_t client_io_loopback_read(sscma_client_io_t *io, void *data, size_t len);
+static esp_err_t client_io_loopback_available(sscma_client_io_t *io, size_t *len);
+static esp_err_t client_io_loopback_flush(sscma_client_io_t *io);
+static esp_err_t client_io_loopback_set_rx_notify(sscma_client_io_t *io, sscma_client_io_notify_cb_t cb, void *arg);
+
+typedef struct
+{
+    uint8_t *data;
+    size_t len;
+    size_t head;
+    size_t count;
+} loopback_ring_t;
+
+typedef struct
+{
+    sscma_client_io_t base;
+    SemaphoreHandle_t lock;             // Mutex lock
+    loopback_ring_t rx;                 // Device to client
+    loopback_ring_t tx;                 // Client to device
+    sscma_client_io_notify_cb_t notify; // Data-ready callback
+    void *notify_arg;                   // Data-ready callback argument
+    void *user_ctx;                     // User context
+} sscma_client_io_loopback_t;
+
+static void ring_put(loopback_ring_t *ring, const uint8_t *data, size_t len)
+{
+    size_t tail = (ring->head + ring->count) % ring->len;
+    size_t first = ring->len - tail;
+
+    if (first >= len)
+    {
+        memcpy(ring->data + tail, data, len);
+    }
+    else
+    {
+        memcpy(ring->data + tail, data, first);
+        memcpy(ring->data, data + first, len - first);
+    }
+    ring->count += len;
+}
+
+static void ring_get(loopback_ring_t *ring, uint8_t *data, size_t len)
+{
+    size_t first = ring->len - ring->head;
+
+    if (first >= len)
+    {
+        memcpy(data, ring->data + ring->head, len);
+    }
+    else
+    {
+        memcpy(data, ring->data + ring->head, first);
+        memcpy(data + first, ring->data, len - first);
+    }
+    ring->head = (ring->head + len) % ring->len;
+    ring->count -= len;
+}
+
+esp_err_t sscma_client_new_io_loopback(const sscma_client_io_loopback_config_t *io_config, sscma_client_io_handle_t *ret_io)
+{
+#if CONFIG_SSCMA_ENABLE_DEBUG_LOG
+    esp_log_level_set(TAG, ESP_LOG_DEBUG);
+#endif
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_loopback_t *loopback_client_io = NULL;
+    ESP_GOTO_ON_FALSE(io_config && ret_io && io_config->rx_buffer_size && io_config->tx_buffer_size, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+
+    loopback_client_io = (sscma_client_io_loopback_t *)calloc(1, sizeof(sscma_client_io_loopback_t));
+    ESP_GOTO_ON_FALSE(loopback_client_io, ESP_ERR_NO_MEM, err, TAG, "no mem for loopback client io");
+
+    loopback_client_io->rx.data = (uint8_t *)malloc(io_config->rx_buffer_size);
+    ESP_GOTO_ON_FALSE(loopback_client_io->rx.data, ESP_ERR_NO_MEM, err, TAG, "no mem for rx buffer");
+    loopback_client_io->rx.len = io_config->rx_buffer_size;
+
+    loopback_client_io->tx.data = (uint8_t *)malloc(io_config->tx_buffer_size);
+    ESP_GOTO_ON_FALSE(loopback_client_io->tx.data, ESP_ERR_NO_MEM, err, TAG, "no mem for tx buffer");
+    loopback_client_io->tx.len = io_config->tx_buffer_size;
+
+    loopback_client_io->user_ctx = io_config->user_ctx;
+    loopback_client_io->base.del = client_io_loopback_del;
+    loopback_client_io->base.write = client_io_loopback_write;
+    loopback_client_io->base.read = client_io_loopback_read;
+    loopback_client_io->base.available = client_io_loopback_available;
+    loopback_client_io->base.flush = client_io_loopback_flush;
+    loopback_client_io->base.set_rx_notify = client_io_loopback_set_rx_notify;
+
+    loopback_client_io->lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(loopback_client_io->lock, ESP_ERR_NO_MEM, err, TAG, "no mem for mutex");
+
+    *ret_io = &loopback_client_io->base;
+    ESP_LOGI(TAG, "new loopback sscma client io @%p", loopback_client_io);
+
+    return ESP_OK;
+
+err:
+    if (loopback_client_io)
+    {
+        free(loopback_client_io->rx.data);
+        free(loopback_client_io->tx.data);
+        free(loopback_client_io);
+    }
+
+    return ret;
+}
+
+static esp_err_t client_io_loopback_del(sscma_client_io_t *io)
+{
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    if (loopback_client_io->lock)
+    {
+        vSemaphoreDelete(loopback_client_io->lock);
+    }
+    free(loopback_client_io->rx.data);
+    free(loopback_client_io->tx.data);
+    free(loopback_client_io);
+
+    ESP_LOGD(TAG, "del loopback sscma client io @%p", loopback_client_io);
+    return ESP_OK;
+}
+
+static esp_err_t client_io_loopback_write(sscma_client_io_t *io, const void *data, size_t len)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    if (loopback_client_io->tx.len - loopback_client_io->tx.count < len)
+    {
+        ret = ESP_FAIL; // nobody fetched the previous writes
+    }
+    else
+    {
+        ring_put(&loopback_client_io->tx, data, len);
+    }
+    xSemaphoreGive(loopback_client_io->lock);
+
+    return ret;
+}
+
+static esp_err_t client_io_loopback_read(sscma_client_io_t *io, void *data, size_t len)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    if (loopback_client_io->rx.count < len)
+    {
+        ret = ESP_FAIL;
+    }
+    else
+    {
+        ring_get(&loopback_client_io->rx, data, len);
+    }
+    xSemaphoreGive(loopback_client_io->lock);
+
+    return ret;
+}
+
+static esp_err_t client_io_loopback_available(sscma_client_io_t *io, size_t *len)
+{
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    *len = loopback_client_io->rx.count;
+    xSemaphoreGive(loopback_client_io->lock);
+
+    return ESP_OK;
+}
+
+static esp_err_t client_io_loopback_flush(sscma_client_io_t *io)
+{
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    loopback_client_io->rx.head = 0;
+    loopback_client_io->rx.count = 0;
+    xSemaphoreGive(loopback_client_io->lock);
+
+    return ESP_OK;
+}
+
+static esp_err_t client_io_loopback_set_rx_notify(sscma_client_io_t *io, sscma_client_io_notify_cb_t cb, void *arg)
+{
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    loopback_client_io->notify = cb;
+    loopback_client_io->notify_arg = arg;
+    xSemaphoreGive(loopback_client_io->lock);
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_client_io_loopback_inject(sscma_client_io_handle_t io, const void *data, size_t size)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_notify_cb_t notify = NULL;
+    void *notify_arg = NULL;
+
+    ESP_RETURN_ON_FALSE(io && io->del == client_io_loopback_del && (data || size == 0), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    if (loopback_client_io->rx.len - loopback_client_io->rx.count < size)
+    {
+        ret = ESP_ERR_NO_MEM;
+    }
+    else
+    {
+        ring_put(&loopback_client_io->rx, data, size);
+        notify = loopback_client_io->notify;
+        notify_arg = loopback_client_io->notify_arg;
+    }
+    xSemaphoreGive(loopback_client_io->lock);
+
+    // called without the lock, the client reads from its own task
+    if (notify && size)
+    {
+        notify(notify_arg);
+    }
+
+    return ret;
+}
+
+esp_err_t sscma_client_io_loopback_fetch(sscma_client_io_handle_t io, void *data, size_t size, size_t *ret_len)
+{
+    ESP_RETURN_ON_FALSE(io && io->del == client_io_loopback_del && data && ret_len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    *ret_len = loopback_client_io->tx.count < size ? loopback_client_io->tx.count : size;
+    ring_get(&loopback_client_io->tx, data, *ret_len);
+    xSemaphoreGive(loopback_client_io->lock);
+
+    return ESP_OK;
+}
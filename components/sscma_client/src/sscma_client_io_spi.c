@@ -9,6 +9,7 @@
 #endif
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "esp_heap_caps.h"
 #include "cJSON.h"
 #include "sscma_client_io_interface.h"
 #include "sscma_client_io.h"
@@ -27,6 +28,9 @@ static const char *TAG = "sscma_client.io.spi";
 
 #define MAX_RECIEVE_SIZE (uint16_t)4095
 
+#define QUEUED_SLOTS  2    // DMA buffers alternated in queued mode, one transaction is in flight at a time
+#define READY_TIMEOUT 1000 // ms, the device did not raise READY
+
 #define FEATURE_TRANSPORT               0x10
 #define FEATURE_TRANSPORT_CMD_READ      0x01
 #define FEATURE_TRANSPORT_CMD_WRITE     0x02
@@ -40,6 +44,9 @@ static esp_err_t client_io_spi_write(sscma_client_io_t *io, const void *data, si
 static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t len);
 static esp_err_t client_io_spi_available(sscma_client_io_t *io, size_t *len);
 static esp_err_t client_io_spi_flush(sscma_client_io_t *io);
+static esp_err_t client_io_spi_set_rx_notify(sscma_client_io_t *io, sscma_client_io_notify_cb_t cb, void *arg);
+static esp_err_t client_io_spi_write_queued(sscma_client_io_t *io, const void *data, size_t len);
+static esp_err_t client_io_spi_read_queued(sscma_client_io_t *io, void *data, size_t len);
 
 typedef struct
 {
@@ -51,9 +58,58 @@ typedef struct
     void *user_ctx;                       // User context
     esp_io_expander_handle_t io_expander; // IO expander
     SemaphoreHandle_t lock;               // Lock
+    sscma_client_io_notify_cb_t notify;   // Data-ready callback
+    void *notify_arg;                     // Data-ready callback argument
+    int ready_gpio_num;                   // READY line GPIO number
+    int ready_level;                      // READY line active level
+    SemaphoreHandle_t ready;              // Given on each READY edge
+    size_t payload_len;                   // Queued mode: payload bytes per write packet
+    size_t read_len;                      // Queued mode: bytes per read request
+    uint8_t *cmd_buffer;                  // Queued mode: command packet
+    uint8_t *dma_buffer[QUEUED_SLOTS];    // Queued mode: alternating packet buffers
+    spi_transaction_t cmd_trans;          // Queued mode: command transaction
+    spi_transaction_t trans[QUEUED_SLOTS];
     uint8_t buffer[PACKET_SIZE];
 } sscma_client_io_spi_t;
 
+static void client_io_spi_ready_isr(void *arg)
+{
+    sscma_client_io_spi_t *spi_client_io = (sscma_client_io_spi_t *)arg;
+    BaseType_t task_woken = pdFALSE;
+
+    xSemaphoreGiveFromISR(spi_client_io->ready, &task_woken);
+    if (task_woken == pdTRUE)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/*
+ * The device needs time to act on a command before the next transaction. With a READY line
+ * that is exactly as long as it takes, otherwise fall back to sleeping wait_delay.
+ */
+static esp_err_t client_io_spi_wait_ready(sscma_client_io_spi_t *spi_client_io)
+{
+    if (spi_client_io->ready_gpio_num < 0)
+    {
+        if (spi_client_io->wait_delay > 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
+        }
+        return ESP_OK;
+    }
+
+    // the level is checked first, so a stale edge only costs another turn of the loop
+    while (gpio_get_level(spi_client_io->ready_gpio_num) != spi_client_io->ready_level)
+    {
+        if (xSemaphoreTake(spi_client_io->ready, pdMS_TO_TICKS(READY_TIMEOUT)) != pdTRUE)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
 esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const sscma_client_io_spi_config_t *io_config, sscma_client_io_handle_t *ret_io)
 {
 #if CONFIG_SSCMA_ENABLE_DEBUG_LOG
@@ -70,7 +126,7 @@ esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const s
         .clock_speed_hz = io_config->pclk_hz,
         .mode = io_config->spi_mode,
         .spics_io_num = io_config->cs_gpio_num,
-        .queue_size = 1,
+        .queue_size = 1, // the device takes one transaction per READY, so none is ever queued behind another
     };
 
     ret = spi_bus_add_device((spi_host_device_t)bus, &dev_config, &spi_client_io->spi_dev);
@@ -99,6 +155,26 @@ esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const s
         }
     }
 
+    // GPIO0 is a strapping pin, 0 means unset so a zero-initialized config does not claim it
+    spi_client_io->ready_gpio_num = io_config->ready_gpio_num > 0 ? io_config->ready_gpio_num : -1;
+    spi_client_io->ready_level = io_config->flags.ready_high_active ? 1 : 0;
+    if (spi_client_io->ready_gpio_num >= 0)
+    {
+        gpio_config_t io_conf = {};
+        io_conf.intr_type = io_config->flags.ready_high_active ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE;
+        io_conf.pin_bit_mask = (1ULL << spi_client_io->ready_gpio_num);
+        io_conf.mode = GPIO_MODE_INPUT;
+        io_conf.pull_down_en = io_config->flags.ready_high_active ? 1 : 0;
+        io_conf.pull_up_en = io_config->flags.ready_high_active ? 0 : 1;
+        ESP_GOTO_ON_ERROR(gpio_config(&io_conf), err, TAG, "configuring ready GPIO failed");
+
+        spi_client_io->ready = xSemaphoreCreateBinary();
+        ESP_GOTO_ON_FALSE(spi_client_io->ready, ESP_ERR_NO_MEM, err, TAG, "no mem for ready semaphore");
+        ret = gpio_install_isr_service(0);
+        ESP_GOTO_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, err, TAG, "install gpio isr service failed");
+        ESP_GOTO_ON_ERROR(gpio_isr_handler_add(spi_client_io->ready_gpio_num, client_io_spi_ready_isr, spi_client_io), err, TAG, "add ready isr handler failed");
+    }
+
     spi_client_io->sync_gpio_num = io_config->sync_gpio_num;
     spi_client_io->wait_delay = io_config->wait_delay;
     spi_client_io->user_ctx = io_config->user_ctx;
@@ -107,6 +183,7 @@ esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const s
     spi_client_io->base.read = client_io_spi_read;
     spi_client_io->base.available = client_io_spi_available;
     spi_client_io->base.flush = client_io_spi_flush;
+    spi_client_io->base.set_rx_notify = client_io_spi_set_rx_notify;
     spi_client_io->base.handle = spi_client_io->spi_dev;
 
     spi_client_io->lock = xSemaphoreCreateMutex();
@@ -117,6 +194,38 @@ esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const s
     spi_client_io->spi_trans_max_bytes = max_trans_bytes;
     ESP_LOGI(TAG, "spi max trans bytes: %d", spi_client_io->spi_trans_max_bytes);
 
+    if (io_config->flags.queued_trans)
+    {
+        // every packet goes out as a single DMA transaction, so it has to fit in one
+        spi_client_io->payload_len = io_config->max_payload_len ? io_config->max_payload_len : MAX_PL_LEN;
+        if (spi_client_io->payload_len > max_trans_bytes - HEADER_LEN - CHECKSUM_LEN)
+        {
+            spi_client_io->payload_len = max_trans_bytes - HEADER_LEN - CHECKSUM_LEN;
+        }
+        spi_client_io->read_len = io_config->max_read_len ? io_config->max_read_len : MAX_RECIEVE_SIZE;
+        if (spi_client_io->read_len > max_trans_bytes)
+        {
+            spi_client_io->read_len = max_trans_bytes;
+        }
+        if (spi_client_io->read_len > UINT16_MAX)
+        {
+            spi_client_io->read_len = UINT16_MAX;
+        }
+
+        size_t packet_len = HEADER_LEN + spi_client_io->payload_len + CHECKSUM_LEN;
+        size_t buffer_len = ((packet_len > spi_client_io->read_len ? packet_len : spi_client_io->read_len) + 3) & ~3;
+        spi_client_io->cmd_buffer = heap_caps_calloc(1, (packet_len + 3) & ~3, MALLOC_CAP_DMA);
+        ESP_GOTO_ON_FALSE(spi_client_io->cmd_buffer, ESP_ERR_NO_MEM, err, TAG, "no mem for command buffer");
+        for (int i = 0; i < QUEUED_SLOTS; i++)
+        {
+            spi_client_io->dma_buffer[i] = heap_caps_calloc(1, buffer_len, MALLOC_CAP_DMA);
+            ESP_GOTO_ON_FALSE(spi_client_io->dma_buffer[i], ESP_ERR_NO_MEM, err, TAG, "no mem for dma buffer");
+        }
+        spi_client_io->base.write = client_io_spi_write_queued;
+        spi_client_io->base.read = client_io_spi_read_queued;
+        ESP_LOGI(TAG, "queued mode, payload %d, read %d", spi_client_io->payload_len, spi_client_io->read_len);
+    }
+
     *ret_io = &spi_client_io->base;
     ESP_LOGD(TAG, "new spi sscma client io @%p", spi_client_io);
 
@@ -134,6 +243,16 @@ err:
         {
             vSemaphoreDelete(spi_client_io->lock);
         }
+        if (spi_client_io->ready)
+        {
+            gpio_isr_handler_remove(spi_client_io->ready_gpio_num);
+            vSemaphoreDelete(spi_client_io->ready);
+        }
+        free(spi_client_io->cmd_buffer);
+        for (int i = 0; i < QUEUED_SLOTS; i++)
+        {
+            free(spi_client_io->dma_buffer[i]);
+        }
         free(spi_client_io);
     }
     return ret;
@@ -151,8 +270,23 @@ static esp_err_t client_io_spi_del(sscma_client_io_t *io)
     spi_bus_free((spi_host_device_t)spi_client_io->spi_dev);
     if (spi_client_io->sync_gpio_num >= 0)
     {
+        if (spi_client_io->notify)
+        {
+            gpio_isr_handler_remove(spi_client_io->sync_gpio_num);
+        }
         gpio_reset_pin(spi_client_io->sync_gpio_num);
     }
+    if (spi_client_io->ready)
+    {
+        gpio_isr_handler_remove(spi_client_io->ready_gpio_num);
+        gpio_reset_pin(spi_client_io->ready_gpio_num);
+        vSemaphoreDelete(spi_client_io->ready);
+    }
+    free(spi_client_io->cmd_buffer);
+    for (int i = 0; i < QUEUED_SLOTS; i++)
+    {
+        free(spi_client_io->dma_buffer[i]);
+    }
     ESP_LOGD(TAG, "del spi sscma client io @%p", spi_client_io);
 
     free(spi_client_io);
@@ -190,10 +324,7 @@ static esp_err_t client_io_spi_write(sscma_client_io_t *io, const void *data, si
             spi_client_io->buffer[5 + MAX_PL_LEN] = 0xFF;
             memcpy(spi_client_io->buffer + 4, data + i * MAX_PL_LEN, MAX_PL_LEN);
             spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
+            ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
             do
             {
                 uint16_t chunk_size = trans_len;
@@ -231,10 +362,7 @@ static esp_err_t client_io_spi_write(sscma_client_io_t *io, const void *data, si
             spi_client_io->buffer[5 + remain] = 0xFF;
             memcpy(spi_client_io->buffer + 4, data + packets * MAX_PL_LEN, remain);
             spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
+            ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
             do
             {
                 uint16_t chunk_size = trans_len;
@@ -298,10 +426,7 @@ static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t le
             spi_client_io->buffer[4] = 0xFF;
             spi_client_io->buffer[5] = 0xFF;
             spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
+            ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
             do
             {
                 uint16_t chunk_size = trans_len;
@@ -325,10 +450,7 @@ static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t le
                 trans_len -= chunk_size;
             }
             while (trans_len > 0);
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
+            ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
 
             trans_len = MAX_RECIEVE_SIZE;
             spi_trans.rx_buffer = data + i * MAX_RECIEVE_SIZE;
@@ -367,10 +489,7 @@ static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t le
             spi_client_io->buffer[4] = 0xFF;
             spi_client_io->buffer[5] = 0xFF;
             spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
+            ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
             do
             {
                 uint16_t chunk_size = trans_len;
@@ -395,10 +514,7 @@ static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t le
             }
             while (trans_len > 0);
 
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
+            ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
             trans_len = remain;
             spi_trans.rx_buffer = data + packets * MAX_RECIEVE_SIZE;
             do
@@ -485,10 +601,7 @@ static esp_err_t client_io_spi_available(sscma_client_io_t *io, size_t *len)
     spi_client_io->buffer[4] = 0xFF;
     spi_client_io->buffer[5] = 0xFF;
     spi_trans.tx_buffer = spi_client_io->buffer;
-    if (spi_client_io->wait_delay > 0)
-    {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-    }
+    ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
     do
     {
         uint16_t chunk_size = trans_len;
@@ -520,10 +633,7 @@ static esp_err_t client_io_spi_available(sscma_client_io_t *io, size_t *len)
     spi_trans.user = spi_client_io;
     spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
     memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-    if (spi_client_io->wait_delay > 0)
-    {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-    }
+    ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
     ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
     ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
     *len = (spi_client_io->buffer[0] << 8) | spi_client_io->buffer[1];
@@ -587,10 +697,7 @@ static esp_err_t client_io_spi_flush(sscma_client_io_t *io)
     spi_client_io->buffer[4] = 0xFF;
     spi_client_io->buffer[5] = 0xFF;
     spi_trans.tx_buffer = spi_client_io->buffer;
-    if (spi_client_io->wait_delay > 0)
-    {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-    }
+    ESP_GOTO_ON_ERROR(client_io_spi_wait_ready(spi_client_io), err, TAG, "device not ready");
     do
     {
         uint16_t chunk_size = trans_len;
@@ -619,4 +726,197 @@ err:
     spi_device_release_bus(spi_client_io->spi_dev);
     xSemaphoreGive(spi_client_io->lock);
     return ret;
-}
\ No newline at end of file
+}
+
+/*
+ * Queued mode. Each packet is one DMA transaction from its own buffer, so the next packet is
+ * filled, or the last read is copied out, while the current one is on the wire. Only that one
+ * transaction is ever in flight: the device acts on each packet before it can take the next,
+ * so a packet is only queued once the previous one completed and the device is ready again.
+ * Reads alternate between the two DMA buffers: chunk N is copied out of one while the read of
+ * chunk N+1 is still queued into the other.
+ */
+
+static esp_err_t client_io_spi_queue(sscma_client_io_spi_t *spi_client_io, spi_transaction_t *trans, bool *in_flight)
+{
+    spi_transaction_t *done = NULL;
+
+    if (*in_flight)
+    {
+        ESP_RETURN_ON_ERROR(spi_device_get_trans_result(spi_client_io->spi_dev, &done, portMAX_DELAY), TAG, "spi transmit (queue) failed");
+        *in_flight = false;
+    }
+    if (trans == NULL)
+    {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(client_io_spi_wait_ready(spi_client_io), TAG, "device not ready");
+    ESP_RETURN_ON_ERROR(spi_device_queue_trans(spi_client_io->spi_dev, trans, portMAX_DELAY), TAG, "spi transmit (queue) failed");
+    *in_flight = true;
+    return ESP_OK;
+}
+
+// Fills a command packet, carrying len bytes of data for a write or requesting len bytes for a read.
+static inline size_t client_io_spi_command(sscma_client_io_spi_t *spi_client_io, uint8_t *buffer, uint8_t cmd, size_t len, const void *data)
+{
+    size_t packet_len = HEADER_LEN + spi_client_io->payload_len + CHECKSUM_LEN;
+
+    buffer[0] = FEATURE_TRANSPORT;
+    buffer[1] = cmd;
+    buffer[2] = len >> 8;
+    buffer[3] = len & 0xFF;
+    if (data)
+    {
+        memcpy(buffer + HEADER_LEN, data, len);
+    }
+    else
+    {
+        len = 0;
+    }
+    buffer[HEADER_LEN + len] = 0xFF;
+    buffer[HEADER_LEN + len + 1] = 0xFF;
+    memset(buffer + HEADER_LEN + len + CHECKSUM_LEN, 0, packet_len - HEADER_LEN - len - CHECKSUM_LEN);
+    return packet_len;
+}
+
+static esp_err_t client_io_spi_write_queued(sscma_client_io_t *io, const void *data, size_t len)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
+    bool in_flight = false;
+    int slot = 0;
+
+    xSemaphoreTake(spi_client_io->lock, portMAX_DELAY);
+
+    if (spi_device_acquire_bus(spi_client_io->spi_dev, portMAX_DELAY) != ESP_OK)
+    {
+        xSemaphoreGive(spi_client_io->lock);
+        return ESP_FAIL;
+    }
+
+    for (size_t offset = 0; data && offset < len; offset += spi_client_io->payload_len)
+    {
+        size_t chunk = len - offset < spi_client_io->payload_len ? len - offset : spi_client_io->payload_len;
+        spi_transaction_t *trans = &spi_client_io->trans[slot];
+
+        memset(trans, 0, sizeof(*trans));
+        trans->length = client_io_spi_command(spi_client_io, spi_client_io->dma_buffer[slot], FEATURE_TRANSPORT_CMD_WRITE, chunk, (const uint8_t *)data + offset) * 8;
+        trans->tx_buffer = spi_client_io->dma_buffer[slot];
+        trans->user = spi_client_io;
+        ESP_GOTO_ON_ERROR(client_io_spi_queue(spi_client_io, trans, &in_flight), err, TAG, "spi write failed");
+        slot = (slot + 1) % QUEUED_SLOTS;
+    }
+
+err:
+    if (client_io_spi_queue(spi_client_io, NULL, &in_flight) != ESP_OK && ret == ESP_OK)
+    {
+        ret = ESP_FAIL;
+    }
+    spi_device_release_bus(spi_client_io->spi_dev);
+    xSemaphoreGive(spi_client_io->lock);
+    return ret;
+}
+
+static esp_err_t client_io_spi_read_queued(sscma_client_io_t *io, void *data, size_t len)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
+    bool in_flight = false;
+    int slot = 0;
+    uint8_t *pending = NULL; // destination of the previous chunk, copied out while the next one is read
+    size_t pending_len = 0;
+    int pending_slot = 0;
+
+    xSemaphoreTake(spi_client_io->lock, portMAX_DELAY);
+
+    if (spi_device_acquire_bus(spi_client_io->spi_dev, portMAX_DELAY) != ESP_OK)
+    {
+        xSemaphoreGive(spi_client_io->lock);
+        return ESP_FAIL;
+    }
+
+    for (size_t offset = 0; data && offset < len; offset += spi_client_io->read_len)
+    {
+        size_t chunk = len - offset < spi_client_io->read_len ? len - offset : spi_client_io->read_len;
+        spi_transaction_t *trans = &spi_client_io->trans[slot];
+
+        memset(&spi_client_io->cmd_trans, 0, sizeof(spi_client_io->cmd_trans));
+        spi_client_io->cmd_trans.length = client_io_spi_command(spi_client_io, spi_client_io->cmd_buffer, FEATURE_TRANSPORT_CMD_READ, chunk, NULL) * 8;
+        spi_client_io->cmd_trans.tx_buffer = spi_client_io->cmd_buffer;
+        spi_client_io->cmd_trans.user = spi_client_io;
+        // waits for the previous read, whose buffer is then complete
+        ESP_GOTO_ON_ERROR(client_io_spi_queue(spi_client_io, &spi_client_io->cmd_trans, &in_flight), err, TAG, "spi read command failed");
+
+        memset(trans, 0, sizeof(*trans));
+        trans->length = chunk * 8;
+        trans->rxlength = chunk * 8;
+        trans->rx_buffer = spi_client_io->dma_buffer[slot];
+        trans->user = spi_client_io;
+        ESP_GOTO_ON_ERROR(client_io_spi_queue(spi_client_io, trans, &in_flight), err, TAG, "spi read failed");
+
+        // the read of this chunk stays queued, the previous chunk is copied out of the other buffer meanwhile
+        if (pending)
+        {
+            memcpy(pending, spi_client_io->dma_buffer[pending_slot], pending_len);
+        }
+        pending = (uint8_t *)data + offset;
+        pending_len = chunk;
+        pending_slot = slot;
+        slot = (slot + 1) % QUEUED_SLOTS;
+    }
+    ESP_GOTO_ON_ERROR(client_io_spi_queue(spi_client_io, NULL, &in_flight), err, TAG, "spi read failed");
+    if (pending)
+    {
+        memcpy(pending, spi_client_io->dma_buffer[pending_slot], pending_len);
+    }
+
+err:
+    if (client_io_spi_queue(spi_client_io, NULL, &in_flight) != ESP_OK && ret == ESP_OK)
+    {
+        ret = ESP_FAIL;
+    }
+    spi_device_release_bus(spi_client_io->spi_dev);
+    xSemaphoreGive(spi_client_io->lock);
+    return ret;
+}
+
+static void client_io_spi_sync_isr(void *arg)
+{
+    sscma_client_io_spi_t *spi_client_io = (sscma_client_io_spi_t *)arg;
+    if (spi_client_io->notify)
+    {
+        spi_client_io->notify(spi_client_io->notify_arg);
+    }
+}
+
+static esp_err_t client_io_spi_set_rx_notify(sscma_client_io_t *io, sscma_client_io_notify_cb_t cb, void *arg)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
+
+    // the SYNC line is raised while the device holds data, only a native GPIO can interrupt on it
+    if (spi_client_io->sync_gpio_num < 0 || spi_client_io->io_expander)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (cb == NULL)
+    {
+        gpio_intr_disable(spi_client_io->sync_gpio_num);
+        gpio_isr_handler_remove(spi_client_io->sync_gpio_num);
+        spi_client_io->notify = NULL;
+        spi_client_io->notify_arg = NULL;
+        return ESP_OK;
+    }
+
+    ret = gpio_install_isr_service(0);
+    ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "install gpio isr service failed");
+
+    spi_client_io->notify_arg = arg;
+    spi_client_io->notify = cb;
+    ESP_RETURN_ON_ERROR(gpio_set_intr_type(spi_client_io->sync_gpio_num, GPIO_INTR_POSEDGE), TAG, "set sync interrupt type failed");
+    ESP_RETURN_ON_ERROR(gpio_isr_handler_add(spi_client_io->sync_gpio_num, client_io_spi_sync_isr, spi_client_io), TAG, "add sync isr handler failed");
+    ESP_RETURN_ON_ERROR(gpio_intr_enable(spi_client_io->sync_gpio_num), TAG, "enable sync interrupt failed");
+
+    return ESP_OK;
+}
@@ -1,3 +1,5 @@
+#include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/cdefs.h>
@@ -42,6 +44,10 @@ const int error_map[] = {
     ESP_FAIL,
 };
 
+#define SSCMA_CLIENT_RX_POLL_INTERVAL  10  // ms, transports without a data-ready signal
+#define SSCMA_CLIENT_RX_NOTIFY_TIMEOUT 100 // ms, guards against a missed data-ready edge
+#define SSCMA_CLIENT_RESULT_PEEK       64  // bytes looked at to classify a frame before parsing it
+
 #define SSCMA_CLIENT_CMD_ERROR_CODE(err) (error_map[(err & 0x0F) > (CMD_EUNKNOWN - 1) ? (CMD_EUNKNOWN - 1) : (err & 0x0F)])
 
 static inline void *__malloc(size_t sz)
@@ -133,280 +139,1301 @@ static inline int get_int_from_array(cJSON *object, int index)
     {
         return INT_MIN;
     }
-    return field->valueint;
+    return field->valueint;
+}
+
+static uint32_t sscma_client_cmd_hash(const char *name)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1; // 0 marks a free slot
+}
+
+/*
+ * A reply handed to callbacks and subscribers. It is freed when the last reference is
+ * dropped, so subscribers can keep it past their callback instead of copying out of it.
+ * Only replies wrapped here can be ref'd: magic catches a request or batch reply passed
+ * to sscma_client_reply_ref/unref, and a reply used after its last reference is gone.
+ */
+#define SSCMA_CLIENT_REPLY_SHARED_MAGIC 0x52504c59 // "RPLY"
+
+typedef struct
+{
+    sscma_client_reply_t reply;
+    uint32_t magic;
+    uint32_t refs;
+    bool in_block; // lives in the header of its pool block, no allocation of its own
+} sscma_client_reply_shared_t;
+
+/*
+ * Reply pool. A block holds the frame text, followed by an arena the cJSON nodes parsed
+ * from it are carved from, so a reply is released in O(1) by handing its block back.
+ * The arena only sees allocations made through the hooks of sscma_client_json_hooks, and
+ * only while the process task parses into the block; everything else uses the fallback.
+ */
+typedef struct
+{
+    sscma_client_reply_shared_t shared;
+
+    sscma_client_reply_pool_t *pool;
+    size_t index;
+    size_t used;       // bytes of the block in use, header included
+    bool heap_payload; // payload may hold heap nodes, so it still needs cJSON_Delete
+} sscma_client_reply_block_t;
+
+#define SSCMA_CLIENT_REPLY_BLOCK_HEADER ((sizeof(sscma_client_reply_block_t) + 7) & ~(size_t)7)
+#define SSCMA_CLIENT_REPLY_POOL_MAX     2 // clients with a reply pool at once
+
+static struct
+{
+    cJSON_Hooks fallback;
+    bool installed;
+    sscma_client_reply_block_t *volatile block; // arena being parsed into
+    TaskHandle_t volatile owner;                // task doing the parse
+    sscma_client_reply_pool_t *pools[SSCMA_CLIENT_REPLY_POOL_MAX];
+    portMUX_TYPE lock;
+} s_json = {
+    .fallback = { .malloc_fn = malloc, .free_fn = free },
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void *sscma_client_json_malloc(size_t size)
+{
+    sscma_client_reply_block_t *block = s_json.block;
+
+    if (block != NULL && s_json.owner == xTaskGetCurrentTaskHandle())
+    {
+        size_t offset = (block->used + 7) & ~(size_t)7;
+        if (offset + size <= block->pool->block_size)
+        {
+            block->used = offset + size;
+            return (uint8_t *)block + offset;
+        }
+        if (!block->heap_payload)
+        {
+            block->heap_payload = true;
+            portENTER_CRITICAL(&block->pool->lock);
+            block->pool->stats.spills++;
+            portEXIT_CRITICAL(&block->pool->lock);
+        }
+    }
+
+    return s_json.fallback.malloc_fn(size);
+}
+
+static void sscma_client_json_free(void *ptr)
+{
+    for (size_t i = 0; i < SSCMA_CLIENT_REPLY_POOL_MAX; i++)
+    {
+        sscma_client_reply_pool_t *pool = s_json.pools[i];
+        if (pool && (uint8_t *)ptr >= pool->base && (uint8_t *)ptr < pool->base + pool->blocks * pool->block_size)
+        {
+            return; // released with its block
+        }
+    }
+
+    s_json.fallback.free_fn(ptr);
+}
+
+void sscma_client_json_hooks(const cJSON_Hooks *fallback, cJSON_Hooks *ret_hooks)
+{
+    if (fallback && fallback->malloc_fn && fallback->free_fn)
+    {
+        s_json.fallback = *fallback;
+    }
+    s_json.installed = true;
+    ret_hooks->malloc_fn = sscma_client_json_malloc;
+    ret_hooks->free_fn = sscma_client_json_free;
+}
+
+// Routes cJSON allocations of the calling task into the block until sscma_client_json_arena_end.
+static void sscma_client_json_arena_begin(sscma_client_reply_block_t *block)
+{
+    bool claimed = false;
+
+    if (block == NULL)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_json.lock);
+    if (s_json.installed && s_json.block == NULL)
+    {
+        s_json.owner = xTaskGetCurrentTaskHandle();
+        s_json.block = block;
+        claimed = true;
+    }
+    portEXIT_CRITICAL(&s_json.lock);
+
+    block->heap_payload = !claimed;
+}
+
+static void sscma_client_json_arena_end(sscma_client_reply_block_t *block)
+{
+    if (block == NULL)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_json.lock);
+    if (s_json.block == block)
+    {
+        s_json.block = NULL;
+        s_json.owner = NULL;
+    }
+    portEXIT_CRITICAL(&s_json.lock);
+
+    portENTER_CRITICAL(&block->pool->lock);
+    if (block->used > block->pool->stats.arena_high_water)
+    {
+        block->pool->stats.arena_high_water = block->used;
+    }
+    portEXIT_CRITICAL(&block->pool->lock);
+}
+
+static esp_err_t sscma_client_reply_pool_new(size_t blocks, size_t block_size, sscma_client_reply_pool_t **ret_pool)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_reply_pool_t *pool = NULL;
+    bool registered = false;
+
+    ESP_RETURN_ON_FALSE(blocks > 0 && blocks <= UINT16_MAX && block_size > SSCMA_CLIENT_REPLY_BLOCK_HEADER, ESP_ERR_INVALID_ARG, TAG, "invalid reply pool size");
+
+    pool = (sscma_client_reply_pool_t *)calloc(1, sizeof(sscma_client_reply_pool_t));
+    ESP_RETURN_ON_FALSE(pool, ESP_ERR_NO_MEM, TAG, "no mem for reply pool");
+
+    pool->block_size = (block_size + 7) & ~(size_t)7;
+    pool->blocks = blocks;
+    pool->base = (uint8_t *)__malloc(pool->blocks * pool->block_size);
+    ESP_GOTO_ON_FALSE(pool->base, ESP_ERR_NO_MEM, err, TAG, "no mem for reply pool blocks");
+    pool->free_list = (uint16_t *)malloc(blocks * sizeof(uint16_t));
+    ESP_GOTO_ON_FALSE(pool->free_list, ESP_ERR_NO_MEM, err, TAG, "no mem for reply pool free list");
+
+    for (size_t i = 0; i < blocks; i++)
+    {
+        pool->free_list[i] = blocks - 1 - i;
+    }
+    pool->free_count = blocks;
+    portMUX_INITIALIZE(&pool->lock);
+    pool->stats.blocks = pool->blocks;
+    pool->stats.block_size = pool->block_size;
+
+    portENTER_CRITICAL(&s_json.lock);
+    for (size_t i = 0; i < SSCMA_CLIENT_REPLY_POOL_MAX && !registered; i++)
+    {
+        if (s_json.pools[i] == NULL)
+        {
+            s_json.pools[i] = pool;
+            registered = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_json.lock);
+    ESP_GOTO_ON_FALSE(registered, ESP_ERR_NO_MEM, err, TAG, "too many reply pools");
+
+    *ret_pool = pool;
+    return ESP_OK;
+
+err:
+    free(pool->free_list);
+    free(pool->base);
+    free(pool);
+    return ret;
+}
+
+static void sscma_client_reply_pool_del(sscma_client_reply_pool_t *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_json.lock);
+    for (size_t i = 0; i < SSCMA_CLIENT_REPLY_POOL_MAX; i++)
+    {
+        if (s_json.pools[i] == pool)
+        {
+            s_json.pools[i] = NULL;
+        }
+    }
+    portEXIT_CRITICAL(&s_json.lock);
+
+    free(pool->free_list);
+    free(pool->base);
+    free(pool);
+}
+
+// Takes a block with room for size bytes of frame text, NULL if the reply must use the heap.
+static sscma_client_reply_block_t *sscma_client_reply_pool_get(sscma_client_reply_pool_t *pool, size_t size)
+{
+    sscma_client_reply_block_t *block = NULL;
+    size_t index;
+
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    portENTER_CRITICAL(&pool->lock);
+    if (pool->free_count > 0 && SSCMA_CLIENT_REPLY_BLOCK_HEADER + size <= pool->block_size)
+    {
+        index = pool->free_list[--pool->free_count];
+        block = (sscma_client_reply_block_t *)(pool->base + index * pool->block_size);
+        block->pool = pool;
+        block->index = index;
+        block->used = SSCMA_CLIENT_REPLY_BLOCK_HEADER + size;
+        block->heap_payload = true;
+        pool->stats.acquired++;
+        pool->stats.in_use = pool->blocks - pool->free_count;
+        if (pool->stats.in_use > pool->stats.high_water)
+        {
+            pool->stats.high_water = pool->stats.in_use;
+        }
+    }
+    else
+    {
+        pool->stats.fallbacks++;
+    }
+    portEXIT_CRITICAL(&pool->lock);
+
+    return block;
+}
+
+static void sscma_client_reply_pool_put(sscma_client_reply_block_t *block)
+{
+    sscma_client_reply_pool_t *pool = block->pool;
+
+    portENTER_CRITICAL(&pool->lock);
+    pool->free_list[pool->free_count++] = block->index;
+    pool->stats.in_use = pool->blocks - pool->free_count;
+    portEXIT_CRITICAL(&pool->lock);
+}
+
+void sscma_client_reply_clear(sscma_client_reply_t *reply)
+{
+    if (reply->block)
+    {
+        sscma_client_reply_block_t *block = (sscma_client_reply_block_t *)reply->block;
+        if (reply->payload && block->heap_payload)
+        {
+            cJSON_Delete(reply->payload); // arena nodes are skipped by the free hook
+        }
+        sscma_client_reply_pool_put(block);
+        reply->block = NULL;
+        reply->payload = NULL;
+        reply->data = NULL;
+        reply->len = 0;
+        return;
+    }
+    if (reply->payload)
+    {
+        cJSON_Delete(reply->payload);
+        reply->payload = NULL;
+    }
+    if (reply->data)
+    {
+        free(reply->data);
+        reply->data = NULL;
+    }
+    reply->len = 0;
+}
+
+static sscma_client_reply_shared_t *sscma_client_reply_share(sscma_client_reply_t *reply)
+{
+    sscma_client_reply_shared_t *shared = NULL;
+
+    if (reply->block)
+    {
+        shared = &((sscma_client_reply_block_t *)reply->block)->shared;
+        shared->in_block = true;
+    }
+    else
+    {
+        shared = (sscma_client_reply_shared_t *)__malloc(sizeof(sscma_client_reply_shared_t));
+        if (shared == NULL)
+        {
+            return NULL;
+        }
+        shared->in_block = false;
+    }
+    shared->reply = *reply;
+    shared->magic = SSCMA_CLIENT_REPLY_SHARED_MAGIC;
+    shared->refs = 1;
+
+    return shared;
+}
+
+const sscma_client_reply_t *sscma_client_reply_ref(const sscma_client_reply_t *reply)
+{
+    sscma_client_reply_shared_t *shared = __containerof((sscma_client_reply_t *)reply, sscma_client_reply_shared_t, reply);
+
+    assert(shared->magic == SSCMA_CLIENT_REPLY_SHARED_MAGIC); // not a callback/subscriber reply
+    __atomic_add_fetch(&shared->refs, 1, __ATOMIC_RELAXED);
+
+    return reply;
+}
+
+void sscma_client_reply_unref(const sscma_client_reply_t *reply)
+{
+    sscma_client_reply_shared_t *shared = __containerof((sscma_client_reply_t *)reply, sscma_client_reply_shared_t, reply);
+    sscma_client_reply_t owned;
+
+    assert(shared->magic == SSCMA_CLIENT_REPLY_SHARED_MAGIC); // not a callback/subscriber reply
+    if (__atomic_sub_fetch(&shared->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    {
+        return;
+    }
+
+    shared->magic = 0;
+    owned = shared->reply;
+    if (!shared->in_block)
+    {
+        free(shared);
+    }
+    sscma_client_reply_clear(&owned); // a pooled reply takes its shared header with it
+}
+
+// Whether anybody takes replies of this type, otherwise the dispatch drops them.
+static inline bool sscma_client_has_listener(sscma_client_handle_t client, int type)
+{
+    if (client->subscribers.count > 0)
+    {
+        return true;
+    }
+    switch (type)
+    {
+        case CMD_TYPE_EVENT:
+            return client->on_event != NULL;
+        case CMD_TYPE_LOG:
+            return client->on_log != NULL;
+        default:
+            return client->on_response != NULL;
+    }
+}
+
+static void sscma_client_subscribers_notify(sscma_client_handle_t client, int type, const sscma_client_reply_t *reply)
+{
+    cJSON *name = cJSON_GetObjectItem(reply->payload, "name");
+    const char *event = NULL;
+    uint32_t hash = 0;
+
+    if (client->subscribers.count == 0)
+    {
+        return;
+    }
+    if (name != NULL && cJSON_IsString(name))
+    {
+        event = strrchr(name->valuestring, '@');
+        event = event ? event + 1 : name->valuestring;
+        hash = sscma_client_cmd_hash(event);
+    }
+
+    xSemaphoreTakeRecursive(client->subscribers.lock, portMAX_DELAY);
+    for (int i = 0; i < SSCMA_CLIENT_MAX_SUBSCRIBERS; i++)
+    {
+        struct sscma_client_subscriber_t *subscriber = &client->subscribers.slots[i];
+        if (subscriber->cb == NULL || (subscriber->type >= 0 && subscriber->type != type))
+        {
+            continue;
+        }
+        if (subscriber->hash != 0 && (subscriber->hash != hash || strcmp(subscriber->name, event) != 0))
+        {
+            continue;
+        }
+        subscriber->cb(client, reply, subscriber->user_ctx);
+    }
+    xSemaphoreGiveRecursive(client->subscribers.lock);
+}
+
+static void sscma_client_monitor(void *arg)
+{
+    sscma_client_handle_t client = (sscma_client_handle_t)arg;
+    sscma_client_reply_t received;
+    sscma_client_reply_shared_t *shared;
+    const sscma_client_reply_t *reply;
+    while (true)
+    {
+        xQueueReceive(client->reply_queue, &received, portMAX_DELAY);
+        client->throttle.busy = true;
+
+        cJSON *type = cJSON_GetObjectItem(received.payload, "type");
+        if (type == NULL)
+        {
+            sscma_client_reply_clear(&received);
+            client->throttle.busy = false;
+            continue;
+        }
+
+        // every callback and subscriber sees the same reply, none of them copies it
+        shared = sscma_client_reply_share(&received);
+        if (shared == NULL)
+        {
+            ESP_LOGW(TAG, "no mem for shared reply");
+            sscma_client_reply_clear(&received);
+            client->throttle.busy = false;
+            continue;
+        }
+        reply = &shared->reply;
+
+        cJSON *name = cJSON_GetObjectItem(reply->payload, "name");
+        if (client->on_connect && name != NULL && strnstr(name->valuestring, EVENT_INIT, strlen(name->valuestring)) != NULL)
+        {
+            client->on_connect(client, reply, client->user_ctx);
+        }
+        else if (type->valueint == CMD_TYPE_EVENT)
+        {
+            if (client->on_event)
+            {
+                client->on_event(client, reply, client->user_ctx);
+            }
+        }
+        else if (type->valueint == CMD_TYPE_LOG)
+        {
+            if (client->on_log)
+            {
+                client->on_log(client, reply, client->user_ctx);
+            }
+        }
+        else
+        {
+            if (client->on_response)
+            {
+                client->on_response(client, reply, client->user_ctx);
+            }
+        }
+
+        sscma_client_subscribers_notify(client, type->valueint, reply);
+
+        sscma_client_reply_unref(reply);
+        client->throttle.busy = false;
+    }
+}
+
+static inline char sscma_client_rx_byte(sscma_client_handle_t client, size_t offset)
+{
+    size_t index = client->rx_buffer.head + offset;
+    if (index >= client->rx_buffer.len)
+    {
+        index -= client->rx_buffer.len;
+    }
+    return client->rx_buffer.data[index];
+}
+
+static void sscma_client_rx_consume(sscma_client_handle_t client, size_t len)
+{
+    client->rx_buffer.head = (client->rx_buffer.head + len) % client->rx_buffer.len;
+    client->rx_buffer.count -= len;
+    client->rx_buffer.scanned -= len;
+}
+
+// Copies len bytes from the head of the ring, which may wrap around its end.
+static void sscma_client_rx_copy(sscma_client_handle_t client, void *dst, size_t len)
+{
+    size_t first = client->rx_buffer.len - client->rx_buffer.head;
+
+    if (first >= len)
+    {
+        memcpy(dst, client->rx_buffer.data + client->rx_buffer.head, len);
+    }
+    else
+    {
+        memcpy(dst, client->rx_buffer.data + client->rx_buffer.head, first);
+        memcpy((char *)dst + first, client->rx_buffer.data, len - first);
+    }
+}
+
+static void sscma_client_rx_reset(sscma_client_handle_t client)
+{
+    client->rx_buffer.head = 0;
+    client->rx_buffer.count = 0;
+    client->rx_buffer.scanned = 0;
+    client->rx_buffer.in_frame = false;
+    client->rx_buffer.binary = false;
+    client->rx_buffer.frame_len = 0;
+    client->rx_buffer.skip = 0;
+}
+
+/*
+ * Pending requests live in a fixed table. A reply is matched on the hash of its name, so
+ * the common case is one integer compare per slot and no string scan, and the reply is
+ * handed over in the slot itself: no queue or allocation per request.
+ */
+// The name a command is answered under: the part after "AT+" up to '=' or the line end.
+static void sscma_client_cmd_name(const char *cmd, char *name, size_t size)
+{
+    size_t i = 0;
+
+    if (strncmp(cmd, CMD_PREFIX, CMD_PREFIX_LEN) == 0)
+    {
+        cmd += CMD_PREFIX_LEN;
+    }
+    while (i < size - 1 && cmd[i] && cmd[i] != '\r' && cmd[i] != '\n' && cmd[i] != '=')
+    {
+        name[i] = cmd[i];
+        i++;
+    }
+    name[i] = '\0';
+}
+
+static esp_err_t sscma_client_request_submit(sscma_client_handle_t client, const char *cmd, sscma_client_batch_handle_t batch, size_t index, sscma_client_request_t **ret_request)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_request_t *request = NULL;
+    char name[sizeof(request->cmd)];
+    uint32_t hash;
+
+    sscma_client_cmd_name(cmd, name, sizeof(name));
+    hash = sscma_client_cmd_hash(name);
+
+    // probe from the hash's home slot, so lookups usually hit first time
+    portENTER_CRITICAL(&client->requests.lock);
+    for (size_t i = 0; i < client->requests.size; i++)
+    {
+        sscma_client_request_t *slot = &client->requests.slots[(hash + i) % client->requests.size];
+        if (slot->hash == 0)
+        {
+            request = slot;
+            request->hash = hash;
+            request->seq = client->requests.seq++;
+            request->done = false;
+            request->is_break = strstr(name, CMD_AT_BREAK) != NULL;
+            request->batch = batch;
+            request->index = index;
+            memcpy(request->cmd, name, sizeof(name));
+            if (request->is_break)
+            {
+                client->requests.breaks++;
+            }
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&client->requests.lock);
+
+    ESP_RETURN_ON_FALSE(request, ESP_ERR_NO_MEM, TAG, "request table full");
+
+    // drop a wakeup left over from the previous owner of the slot
+    xSemaphoreTake(request->ready, 0);
+
+    *ret_request = request;
+    return ret;
+}
+
+static void sscma_client_request_release(sscma_client_handle_t client, sscma_client_request_t *request)
+{
+    sscma_client_reply_t reply = { 0 };
+
+    portENTER_CRITICAL(&client->requests.lock);
+    if (request->done)
+    {
+        reply = request->reply; // answered after the waiter gave up
+        request->done = false;
+    }
+    if (request->is_break)
+    {
+        client->requests.breaks--;
+    }
+    request->hash = 0;
+    portEXIT_CRITICAL(&client->requests.lock);
+
+    sscma_client_reply_clear(&reply);
+}
+
+// Frees the slots a batch still holds. Called with the table locked.
+static void sscma_client_batch_cancel_locked(sscma_client_handle_t client, sscma_client_batch_handle_t batch)
+{
+    for (size_t i = 0; i < client->requests.size; i++)
+    {
+        sscma_client_request_t *slot = &client->requests.slots[i];
+        if (slot->hash != 0 && slot->batch == batch)
+        {
+            if (slot->is_break)
+            {
+                client->requests.breaks--;
+            }
+            slot->batch = NULL;
+            slot->hash = 0;
+        }
+    }
+}
+
+static void sscma_client_batch_free(sscma_client_batch_handle_t batch)
+{
+    for (size_t i = 0; i < batch->count; i++)
+    {
+        sscma_client_reply_clear(&batch->replies[i]);
+    }
+    vSemaphoreDelete(batch->done);
+    free(batch->replies);
+    free(batch);
+}
+
+static void sscma_client_batch_finish(sscma_client_batch_handle_t batch)
+{
+    if (batch->cb)
+    {
+        batch->cb(batch->client, batch, batch->user_ctx);
+        sscma_client_batch_free(batch);
+    }
+    else
+    {
+        xSemaphoreGive(batch->done);
+    }
+}
+
+// Gives up on batches whose timeout has passed, called from the process task.
+static void sscma_client_batch_expire(sscma_client_handle_t client)
+{
+    sscma_client_batch_handle_t expired = NULL;
+    TickType_t now = xTaskGetTickCount();
+
+    do
+    {
+        expired = NULL;
+        portENTER_CRITICAL(&client->requests.lock);
+        for (size_t i = 0; i < client->requests.size; i++)
+        {
+            sscma_client_batch_handle_t batch = client->requests.slots[i].batch;
+            if (client->requests.slots[i].hash != 0 && batch != NULL && batch->armed && now - batch->start >= batch->timeout)
+            {
+                expired = batch;
+                expired->finished = true;
+                expired->result = ESP_ERR_TIMEOUT;
+                sscma_client_batch_cancel_locked(client, expired);
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&client->requests.lock);
+
+        if (expired)
+        {
+            ESP_LOGW(TAG, "batch timeout, %d of %d commands unanswered", expired->pending, expired->count);
+            sscma_client_batch_finish(expired);
+        }
+    }
+    while (expired);
+}
+
+static esp_err_t sscma_client_request_wait(sscma_client_handle_t client, sscma_client_request_t *request, sscma_client_reply_t *reply, TickType_t timeout)
+{
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed = 0;
+
+    do
+    {
+        if (xSemaphoreTake(request->ready, timeout - elapsed) != pdTRUE)
+        {
+            break;
+        }
+        portENTER_CRITICAL(&client->requests.lock);
+        if (request->done)
+        {
+            *reply = request->reply;
+            request->done = false;
+            ret = ESP_OK;
+        }
+        portEXIT_CRITICAL(&client->requests.lock);
+        elapsed = xTaskGetTickCount() - start;
+    }
+    while (ret != ESP_OK && elapsed < timeout);
+
+    sscma_client_request_release(client, request);
+    return ret;
+}
+
+/*
+ * Hands a reply to the oldest pending request answered under name, or, for an unknown
+ * command log, to the one whose command appears in log_data. Returns false if no request
+ * is waiting, the reply then stays with the caller.
+ */
+static bool sscma_client_request_complete(sscma_client_handle_t client, const char *name, const char *log_data, sscma_client_reply_t *reply)
+{
+    sscma_client_request_t *found = NULL;
+    sscma_client_batch_handle_t finished = NULL;
+    bool wake = false;
+    uint32_t hash = name ? sscma_client_cmd_hash(name) : 0;
+
+    portENTER_CRITICAL(&client->requests.lock);
+    for (size_t i = 0; i < client->requests.size; i++)
+    {
+        sscma_client_request_t *slot = &client->requests.slots[(hash + i) % client->requests.size];
+        if (slot->hash == 0 || slot->done)
+        {
+            continue;
+        }
+        if (name ? (slot->hash != hash || strncmp(slot->cmd, name, sizeof(slot->cmd)) != 0) : strstr(log_data, slot->cmd) == NULL)
+        {
+            continue;
+        }
+        if (found == NULL || (int32_t)(slot->seq - found->seq) < 0)
+        {
+            found = slot;
+        }
+    }
+    if (found && found->batch)
+    {
+        // batch replies go straight to the batch, freeing the slot at once
+        found->batch->replies[found->index] = *reply;
+        if (--found->batch->pending == 0 && found->batch->armed && !found->batch->finished)
+        {
+            finished = found->batch;
+            finished->finished = true;
+            finished->result = ESP_OK;
+        }
+        if (found->is_break)
+        {
+            client->requests.breaks--;
+        }
+        found->batch = NULL;
+        found->hash = 0;
+    }
+    else if (found)
+    {
+        found->reply = *reply;
+        found->done = true;
+        wake = true;
+    }
+    portEXIT_CRITICAL(&client->requests.lock);
+
+    if (finished)
+    {
+        sscma_client_batch_finish(finished);
+    }
+    else if (wake)
+    {
+        xSemaphoreGive(found->ready);
+    }
+    return found != NULL;
+}
+
+static void sscma_client_dispatch(sscma_client_handle_t client, sscma_client_reply_t *reply)
+{
+    cJSON *type = cJSON_GetObjectItem(reply->payload, "type");
+    cJSON *name = cJSON_GetObjectItem(reply->payload, "name");
+
+    if (type == NULL || name == NULL)
+    {
+        ESP_LOGW(TAG, "invalid reply: %s", reply->data);
+        sscma_client_reply_clear(reply);
+        return;
+    }
+
+    if (client->on_connect)
+    {
+        if (name != NULL && strnstr(name->valuestring, EVENT_INIT, strlen(name->valuestring)) != NULL)
+        {
+            // drop the replies queued before the device restarted, each one may hold a pool block
+            sscma_client_reply_t stale;
+            while (xQueueReceive(client->reply_queue, &stale, 0) == pdTRUE)
+            {
+                sscma_client_reply_clear(&stale);
+            }
+            if (xQueueSend(client->reply_queue, reply, 0) != pdTRUE)
+
+            {
+                sscma_client_reply_clear(reply);
+            }
+            return;
+        }
+    }
+
+    if (type->valueint == CMD_TYPE_RESPONSE)
+    {
+        if (!sscma_client_request_complete(client, name->valuestring, NULL, reply))
+        {
+            ESP_LOGW(TAG, "request not found: %s", name->valuestring);
+            if (!sscma_client_has_listener(client, CMD_TYPE_RESPONSE) || xQueueSend(client->reply_queue, reply, 0) != pdTRUE)
+            {
+                sscma_client_reply_clear(reply); // discard this reply
+            }
+        }
+    }
+    else if (type->valueint == CMD_TYPE_LOG)
+    {
+        cJSON *code = cJSON_GetObjectItem(reply->payload, "code");
+        if (code == NULL)
+        {
+            ESP_LOGW(TAG, "invalid log: %s", reply->data);
+            sscma_client_reply_clear(reply);
+            return;
+        }
+        if (code->valueint == CMD_EINVAL)
+        { // unkown command
+            cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
+            if (data == NULL)
+            {
+                ESP_LOGW(TAG, "invalid log: %s", reply->data);
+                sscma_client_reply_clear(reply);
+                return;
+            }
+            if (!sscma_client_request_complete(client, NULL, data->valuestring, reply))
+            {
+                ESP_LOGW(TAG, "request not found: %s", name->valuestring);
+                if (!sscma_client_has_listener(client, CMD_TYPE_LOG) || xQueueSend(client->reply_queue, reply, 0) != pdTRUE)
+                {
+                    sscma_client_reply_clear(reply); // discard this reply
+                }
+            }
+        }
+        else
+        {
+            if (!sscma_client_has_listener(client, CMD_TYPE_LOG) || xQueueSend(client->reply_queue, reply, 0) != pdTRUE)
+            {
+                sscma_client_reply_clear(reply); // discard this reply
+            }
+        }
+    }
+    else if (type->valueint == CMD_TYPE_EVENT)
+    {
+        // discard all the events while AT+BREAK is pending
+        if (!sscma_client_has_listener(client, CMD_TYPE_EVENT) || client->requests.breaks > 0 || xQueueSend(client->reply_queue, reply, 0) != pdTRUE)
+        {
+            sscma_client_reply_clear(reply); // discard this reply
+        }
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Invalid reply: %s", reply->data);
+        sscma_client_reply_clear(reply);
+    }
+}
+
+/*
+ * Builds the payload callbacks look up (type, name, code, data.count, data.resolution)
+ * from a decoded event, so replies that are not parsed by cJSON still look the same.
+ */
+static cJSON *sscma_client_event_to_payload(const sscma_client_event_t *event)
+{
+    char name[32];
+    size_t name_len = 0;
+    cJSON *root = NULL;
+    cJSON *object = NULL;
+
+    name_len = event->name_len < sizeof(name) - 1 ? event->name_len : sizeof(name) - 1;
+    if (name_len)
+    {
+        memcpy(name, event->name, name_len);
+    }
+    name[name_len] = 0;
+
+    root = cJSON_CreateObject();
+    if (root == NULL)
+    {
+        return NULL;
+    }
+    cJSON_AddNumberToObject(root, "type", event->type);
+    cJSON_AddStringToObject(root, "name", name);
+    if (event->code != INT_MIN)
+    {
+        cJSON_AddNumberToObject(root, "code", event->code);
+    }
+    if (event->has_data)
+    {
+        object = cJSON_AddObjectToObject(root, "data");
+        if (object != NULL && event->count != INT_MIN)
+        {
+            cJSON_AddNumberToObject(object, "count", event->count);
+        }
+        if (object != NULL && event->width != INT_MIN)
+        {
+            int resolution[2] = { event->width, event->height };
+            cJSON_AddItemToObject(object, "resolution", cJSON_CreateIntArray(resolution, 2));
+        }
+    }
+
+    return root;
+}
+
+#if CONFIG_SSCMA_EVENT_LIGHT_PAYLOAD
+static bool span_contains(const char *str, size_t len, const char *word)
+{
+    size_t n = strlen(word);
+    for (size_t i = 0; i + n <= len; i++)
+    {
+        if (memcmp(str + i, word, n) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * INVOKE and SAMPLE events carry the results and a base64 image, which cJSON would copy
+ * into a tree of small allocations. For those, only the header fields the callbacks look
+ * up are put into the payload; the rest stays in the reply text for sscma_utils_*.
+ * Returns NULL for any other reply.
+ */
+static cJSON *sscma_client_event_payload(const char *data, size_t len)
+{
+    sscma_client_event_t event = { 0 };
+
+    if (sscma_utils_decode_event(data, len, &event) != ESP_OK || event.type != CMD_TYPE_EVENT || event.name == NULL)
+    {
+        return NULL;
+    }
+    if (!span_contains(event.name, event.name_len, EVENT_INVOKE) && !span_contains(event.name, event.name_len, EVENT_SAMPLE))
+    {
+        return NULL;
+    }
+
+    return sscma_client_event_to_payload(&event);
+}
+#endif
+
+// Whether the frame at the head of the ring is an INVOKE or SAMPLE event, from its first bytes only.
+static bool sscma_client_rx_is_result(sscma_client_handle_t client, size_t len, bool binary)
+{
+    char head[SSCMA_CLIENT_RESULT_PEEK + 1];
+    size_t n = len < SSCMA_CLIENT_RESULT_PEEK ? len : SSCMA_CLIENT_RESULT_PEEK;
+    const char *name;
+    size_t name_len;
+
+    sscma_client_rx_copy(client, head, n);
+    head[n] = '\0';
+
+    if (binary)
+    {
+        if (n < 8 + BINARY_FRAME_NAME_LEN || head[5] != CMD_TYPE_EVENT)
+        {
+            return false;
+        }
+        name = head + 8;
+        name_len = strnlen(name, BINARY_FRAME_NAME_LEN);
+    }
+    else
+    {
+        // {"type": 1, "name": "INVOKE", ... the device always leads with these two
+        const char *type = strstr(head, "\"type\"");
+        if (type == NULL)
+        {
+            return false;
+        }
+        type += 6;
+        while (*type == ' ' || *type == ':')
+        {
+            type++;
+        }
+        if (*type != '0' + CMD_TYPE_EVENT || (name = strstr(type, "\"name\"")) == NULL)
+        {
+            return false;
+        }
+        name_len = strlen(name);
+    }
+
+    return strnstr(name, EVENT_INVOKE, name_len) != NULL || strnstr(name, EVENT_SAMPLE, name_len) != NULL;
+}
+
+/*
+ * Latest-value-wins for inference results. A result is only parsed if the target interval
+ * has passed and the consumer is done with the previous one, so the next result delivered
+ * is the newest one; everything in between is dropped here, before any allocation.
+ */
+static bool sscma_client_rx_throttle(sscma_client_handle_t client, size_t len, bool binary)
+{
+    TickType_t now;
+
+    if (client->throttle.interval == 0 || !sscma_client_rx_is_result(client, len, binary))
+    {
+        return false;
+    }
+
+    now = xTaskGetTickCount();
+    if (now - client->throttle.last < client->throttle.interval)
+    {
+        client->throttle.stats.dropped_rate++;
+        return true;
+    }
+    if (client->throttle.busy || uxQueueMessagesWaiting(client->reply_queue) > 0)
+    {
+        client->throttle.stats.dropped_busy++;
+        return true;
+    }
+
+    client->throttle.last = now;
+    client->throttle.stats.delivered++;
+    return false;
+}
+
+// Copies the frame at the head of the ring into a reply and hands it on.
+static void sscma_client_rx_emit(sscma_client_handle_t client, size_t len, bool binary)
+{
+    sscma_client_reply_t reply = { 0 };
+    sscma_client_reply_block_t *block = NULL;
+
+    if (sscma_client_rx_throttle(client, len, binary))
+    {
+        return;
+    }
+
+    block = sscma_client_reply_pool_get(client->reply_pool, len + 1);
+
+    if (block)
+    {
+        reply.block = block;
+        reply.data = (char *)block + SSCMA_CLIENT_REPLY_BLOCK_HEADER;
+    }
+    else
+    {
+        reply.data = (char *)__malloc(len + 1);
+    }
+    if (reply.data == NULL)
+    {
+        ESP_LOGW(TAG, "no mem for reply: %d", len);
+        return;
+    }
+    reply.len = len;
+    sscma_client_rx_copy(client, reply.data, len);
+    reply.data[len] = 0;
+
+    sscma_client_json_arena_begin(block);
+    if (binary)
+    {
+        // binary frames are always decoded in place, the payload only carries the header
+        sscma_client_event_t event = { 0 };
+        if (sscma_utils_decode_event(reply.data, len, &event) == ESP_OK)
+        {
+            reply.payload = sscma_client_event_to_payload(&event);
+        }
+    }
+    else
+    {
+#if CONFIG_SSCMA_EVENT_LIGHT_PAYLOAD
+        reply.payload = sscma_client_event_payload(reply.data, len);
+        if (reply.payload == NULL)
+        {
+            reply.payload = cJSON_Parse(reply.data);
+        }
+#else
+        reply.payload = cJSON_Parse(reply.data);
+#endif
+    }
+    sscma_client_json_arena_end(block);
+
+    if (reply.payload == NULL)
+    {
+        if (binary)
+        {
+            ESP_LOGW(TAG, "invalid binary reply: %d", len);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "invalid reply: %s", reply.data);
+        }
+        sscma_client_reply_clear(&reply);
+        return;
+    }
+
+    sscma_client_dispatch(client, &reply);
+}
+
+static inline bool sscma_client_rx_is_magic(sscma_client_handle_t client, size_t pos)
+{
+    for (size_t i = 0; i < BINARY_FRAME_MAGIC_LEN; i++)
+    {
+        if (sscma_client_rx_byte(client, pos + 1 - BINARY_FRAME_MAGIC_LEN + i) != BINARY_FRAME_MAGIC[i])
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-void sscma_client_reply_clear(sscma_client_reply_t *reply)
+/*
+ * Waits for the header of the binary frame at the head of the ring, then for its body.
+ * A header that fails its checks was noise that happened to match the magic, so scanning
+ * resumes one byte further on. Frames that can never fit the ring are skipped.
+ */
+static void sscma_client_rx_parse_binary(sscma_client_handle_t client)
 {
-    if (reply->payload)
+    if (client->rx_buffer.frame_len == 0)
     {
-        cJSON_Delete(reply->payload);
-        reply->payload = NULL;
+        uint8_t header[BINARY_FRAME_HEADER_LEN];
+        size_t frame_len = 0;
+
+        if (client->rx_buffer.count < BINARY_FRAME_HEADER_LEN)
+        {
+            client->rx_buffer.scanned = client->rx_buffer.count;
+            return;
+        }
+        sscma_client_rx_copy(client, header, BINARY_FRAME_HEADER_LEN);
+        if (sscma_utils_binary_frame_length(header, &frame_len) != ESP_OK)
+        {
+            client->rx_buffer.scanned = 1;
+            sscma_client_rx_consume(client, 1);
+            client->rx_buffer.in_frame = false;
+            client->rx_buffer.binary = false;
+            return;
+        }
+        if (frame_len > client->rx_buffer.len)
+        {
+            ESP_LOGW(TAG, "binary reply too large: %d", frame_len);
+            client->rx_buffer.skip = frame_len;
+            client->rx_buffer.in_frame = false;
+            client->rx_buffer.binary = false;
+            return;
+        }
+        client->rx_buffer.frame_len = frame_len;
     }
-    if (reply->data)
+
+    if (client->rx_buffer.count < client->rx_buffer.frame_len)
     {
-        free(reply->data);
-        reply->data = NULL;
+        client->rx_buffer.scanned = client->rx_buffer.count;
+        return;
     }
-    reply->len = 0;
+
+    sscma_client_rx_emit(client, client->rx_buffer.frame_len, true);
+    client->rx_buffer.scanned = client->rx_buffer.frame_len;
+    sscma_client_rx_consume(client, client->rx_buffer.frame_len);
+    client->rx_buffer.in_frame = false;
+    client->rx_buffer.binary = false;
+    client->rx_buffer.frame_len = 0;
 }
 
-static void sscma_client_monitor(void *arg)
+/*
+ * Scans only the bytes received since the last call, remembering whether a frame prefix
+ * has been seen, so a large reply arriving over many reads is scanned once. Noise in front
+ * of a prefix is dropped, and complete frames are consumed from the head of the ring.
+ * Text (\r{ ... }\n) and binary frames may be interleaved.
+ */
+static void sscma_client_rx_parse(sscma_client_handle_t client)
 {
-    sscma_client_handle_t client = (sscma_client_handle_t)arg;
-    sscma_client_reply_t reply;
-    while (true)
+    while (client->rx_buffer.scanned < client->rx_buffer.count)
     {
-        xQueueReceive(client->reply_queue, &reply, portMAX_DELAY);
+        size_t pos = client->rx_buffer.scanned;
 
-        cJSON *type = cJSON_GetObjectItem(reply.payload, "type");
-        if (type == NULL)
+        if (client->rx_buffer.skip)
         {
-            sscma_client_reply_clear(&reply);
+            size_t n = client->rx_buffer.count < client->rx_buffer.skip ? client->rx_buffer.count : client->rx_buffer.skip;
+            client->rx_buffer.scanned = n;
+            sscma_client_rx_consume(client, n);
+            client->rx_buffer.skip -= n;
             continue;
         }
 
-        if (client->on_connect)
+        if (!client->rx_buffer.in_frame)
         {
-            cJSON *name = cJSON_GetObjectItem(reply.payload, "name");
-            if (name != NULL && strnstr(name->valuestring, EVENT_INIT, strlen(name->valuestring)) != NULL)
+            if (pos > 0 && sscma_client_rx_byte(client, pos) == RESPONSE_PREFIX[1] && sscma_client_rx_byte(client, pos - 1) == RESPONSE_PREFIX[0])
+            {
+                sscma_client_rx_consume(client, pos - 1);
+                client->rx_buffer.in_frame = true;
+            }
+            else if (pos >= BINARY_FRAME_MAGIC_LEN - 1 && sscma_client_rx_is_magic(client, pos))
             {
-                client->on_connect(client, &reply, client->user_ctx);
-                sscma_client_reply_clear(&reply);
-                continue;
+                sscma_client_rx_consume(client, pos + 1 - BINARY_FRAME_MAGIC_LEN);
+                client->rx_buffer.in_frame = true;
+                client->rx_buffer.binary = true;
+                client->rx_buffer.frame_len = 0;
             }
+            client->rx_buffer.scanned++;
+            continue;
         }
 
-        if (type->valueint == CMD_TYPE_EVENT)
+        if (client->rx_buffer.binary)
         {
-            if (client->on_event)
-            {
-                client->on_event(client, &reply, client->user_ctx);
-            }
+            sscma_client_rx_parse_binary(client);
+            continue;
         }
-        else if (type->valueint == CMD_TYPE_LOG)
+
+        // search the contiguous part of the ring for the last byte of the suffix
+        size_t start = (client->rx_buffer.head + pos) % client->rx_buffer.len;
+        size_t span = client->rx_buffer.count - pos;
+        if (span > client->rx_buffer.len - start)
         {
-            if (client->on_log)
-            {
-                client->on_log(client, &reply, client->user_ctx);
-            }
+            span = client->rx_buffer.len - start;
         }
-        else
+        char *lf = memchr(client->rx_buffer.data + start, RESPONSE_SUFFIX[1], span);
+        if (lf == NULL)
         {
-            if (client->on_response)
-            {
-                client->on_response(client, &reply, client->user_ctx);
-            }
+            client->rx_buffer.scanned += span;
+            continue;
         }
 
-        sscma_client_reply_clear(&reply);
+        pos += lf - (client->rx_buffer.data + start);
+        client->rx_buffer.scanned = pos + 1;
+        if (sscma_client_rx_byte(client, pos - 1) != RESPONSE_SUFFIX[0])
+        {
+            continue;
+        }
+
+        sscma_client_rx_emit(client, pos + 1, false);
+        sscma_client_rx_consume(client, pos + 1);
+        client->rx_buffer.in_frame = false;
+    }
+
+    // keep the last bytes, they may be the start of a prefix or magic
+    if (!client->rx_buffer.in_frame && client->rx_buffer.scanned > BINARY_FRAME_MAGIC_LEN - 1)
+    {
+        sscma_client_rx_consume(client, client->rx_buffer.scanned - (BINARY_FRAME_MAGIC_LEN - 1));
+    }
+}
+
+static void sscma_client_rx_notify(void *arg)
+{
+    sscma_client_handle_t client = (sscma_client_handle_t)arg;
+    BaseType_t task_woken = pdFALSE;
+
+    if (client->process_task.handle == NULL)
+    {
+        return;
+    }
+    if (xPortInIsrContext())
+    {
+        vTaskNotifyGiveFromISR(client->process_task.handle, &task_woken);
+        portYIELD_FROM_ISR(task_woken);
+    }
+    else
+    {
+        xTaskNotifyGive(client->process_task.handle);
     }
 }
 
 static void sscma_client_process(void *arg)
 {
     size_t rlen = 0;
-    char *suffix = NULL;
-    char *prefix = NULL;
+    size_t tail = 0;
+    size_t chunk = 0;
     sscma_client_handle_t client = (sscma_client_handle_t)arg;
-    sscma_client_reply_t reply;
     while (true)
     {
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-        if (client->inited == false)
+        sscma_client_batch_expire(client);
+
+        if (client->inited == false || sscma_client_available(client, &rlen) != ESP_OK || rlen == 0)
         {
+            // sleep until the IO reports new data, or poll if it has no data-ready signal
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(client->rx_notify ? SSCMA_CLIENT_RX_NOTIFY_TIMEOUT : SSCMA_CLIENT_RX_POLL_INTERVAL));
             continue;
         }
-        if (sscma_client_available(client, &rlen) == ESP_OK && rlen)
+
+        // drain everything available before sleeping again
+        while (rlen > 0)
         {
-            if (rlen + client->rx_buffer.pos > client->rx_buffer.len)
+            if (client->rx_buffer.count == client->rx_buffer.len)
             {
-                rlen = client->rx_buffer.len - client->rx_buffer.pos;
-                if (rlen <= 0)
-                {
-                    ESP_LOGW(TAG, "rx buffer is full");
-                    client->rx_buffer.pos = 0;
-                    continue;
-                }
+                ESP_LOGW(TAG, "rx buffer is full");
+                sscma_client_rx_reset(client);
             }
-            sscma_client_read(client, client->rx_buffer.data + client->rx_buffer.pos, rlen);
-            client->rx_buffer.pos += rlen;
-            client->rx_buffer.data[client->rx_buffer.pos] = 0;
-            while ((suffix = strnstr(client->rx_buffer.data, RESPONSE_SUFFIX, client->rx_buffer.pos)) != NULL)
+            tail = (client->rx_buffer.head + client->rx_buffer.count) % client->rx_buffer.len;
+            chunk = client->rx_buffer.len - client->rx_buffer.count;
+            if (chunk > client->rx_buffer.len - tail)
             {
-                if ((prefix = strnstr(client->rx_buffer.data, RESPONSE_PREFIX, suffix - client->rx_buffer.data)) != NULL)
-                {
-                    int len = suffix - prefix + RESPONSE_SUFFIX_LEN;
-                    reply.data = (char *)__malloc(len + 1);
-                    if (reply.data != NULL)
-                    {
-                        reply.len = len;
-                        memcpy(reply.data, prefix, len);
-
-                        // delete this reply from rx buffer
-                        memmove(client->rx_buffer.data, suffix + RESPONSE_SUFFIX_LEN, client->rx_buffer.pos - (suffix - client->rx_buffer.data) - RESPONSE_PREFIX_LEN);
-                        client->rx_buffer.pos -= len;
-
-                        reply.data[len] = 0;
-                        reply.payload = cJSON_Parse(reply.data);
-                        if (reply.payload != NULL)
-                        {
-                            cJSON *type = cJSON_GetObjectItem(reply.payload, "type");
-                            cJSON *name = cJSON_GetObjectItem(reply.payload, "name");
-
-                            if (type == NULL || name == NULL)
-                            {
-                                ESP_LOGW(TAG, "invalid reply: %s", reply.data);
-                                sscma_client_reply_clear(&reply);
-                                continue;
-                            }
-
-                            if (client->on_connect)
-                            {
-                                if (name != NULL && strnstr(name->valuestring, EVENT_INIT, strlen(name->valuestring)) != NULL)
-                                {
-                                    xQueueReset(client->reply_queue); // reset reply queue
-                                    if (xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                    {
-                                        sscma_client_reply_clear(&reply);
-                                    }
-                                    continue;
-                                }
-                            }
-
-                            if (type->valueint == CMD_TYPE_RESPONSE)
-                            {
-                                sscma_client_request_t *first_req, *next_req = NULL;
-                                bool found = false;
-                                if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
-                                {
-                                    listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-                                    do
-                                    {
-                                        listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                                        if (strncmp(next_req->cmd, name->valuestring, sizeof(next_req->cmd)) == 0)
-                                        {
-                                            if (next_req->reply)
-                                            {
-                                                found = true;
-                                                if (xQueueSend(next_req->reply, &reply, 0) != pdTRUE)
-                                                {
-                                                    sscma_client_reply_clear(&reply); // discard this reply
-                                                }
-                                                break;
-                                            }
-                                        }
-                                    }
-                                    while (next_req != first_req);
-                                }
-                                if (!found)
-                                {
-                                    ESP_LOGW(TAG, "request not found: %s", name->valuestring);
-                                    if (client->on_response == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                    {
-                                        sscma_client_reply_clear(&reply); // discard this reply
-                                    }
-                                }
-                            }
-                            else if (type->valueint == CMD_TYPE_LOG)
-                            {
-                                cJSON *code = cJSON_GetObjectItem(reply.payload, "code");
-                                if (code == NULL)
-                                {
-                                    ESP_LOGW(TAG, "invalid log: %s", reply.data);
-                                    sscma_client_reply_clear(&reply);
-                                    continue;
-                                }
-                                if (code->valueint == CMD_EINVAL)
-                                { // unkown command
-                                    cJSON *data = cJSON_GetObjectItem(reply.payload, "data");
-                                    if (data == NULL)
-                                    {
-                                        ESP_LOGW(TAG, "invalid log: %s", reply.data);
-                                        sscma_client_reply_clear(&reply);
-                                        continue;
-                                    }
-                                    sscma_client_request_t *first_req, *next_req = NULL;
-                                    bool found = false;
-                                    if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
-                                    {
-                                        listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-                                        do
-                                        {
-                                            listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                                            if (strnstr(data->valuestring, next_req->cmd, strlen(data->valuestring)) != NULL)
-                                            {
-                                                if (next_req->reply)
-                                                {
-                                                    found = true;
-                                                    if (xQueueSend(next_req->reply, &reply, 0) != pdTRUE)
-                                                    {
-                                                        sscma_client_reply_clear(&reply); // discard this reply
-                                                    }
-                                                    break;
-                                                }
-                                            }
-                                        }
-                                        while (next_req != first_req);
-                                    }
-                                    if (!found)
-                                    {
-                                        ESP_LOGW(TAG, "request not found: %s", name->valuestring);
-                                        if (client->on_log == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                        {
-                                            sscma_client_reply_clear(&reply); // discard this reply
-                                        }
-                                    }
-                                }
-                                else
-                                {
-                                    if (client->on_log == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                    {
-                                        sscma_client_reply_clear(&reply); // discard this reply
-                                    }
-                                }
-                            }
-                            else if (type->valueint == CMD_TYPE_EVENT)
-                            {
-                                sscma_client_request_t *first_req, *next_req = NULL;
-                                bool found = false;
-                                // discard all the events while AT+BREAK is found
-                                if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
-                                {
-                                    listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-                                    do
-                                    {
-                                        listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                                        if (strnstr(next_req->cmd, CMD_AT_BREAK, strlen(next_req->cmd)) != NULL)
-                                        {
-                                            found = true;
-                                            break;
-                                        }
-                                    }
-                                    while (next_req != first_req);
-                                }
-                                if (client->on_event == NULL || found || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                {
-                                    sscma_client_reply_clear(&reply); // discard this reply
-                                }
-                            }
-                            else
-                            {
-                                ESP_LOGW(TAG, "Invalid reply: %s", reply.data);
-                                sscma_client_reply_clear(&reply);
-                            }
-                        }
-                    }
-                }
-                else
-                {
-                    // discard this reply
-                    ESP_LOGW(TAG, "Invalid reply: %d/%d", client->rx_buffer.pos, client->rx_buffer.len);
-                    memmove(client->rx_buffer.data, suffix + RESPONSE_SUFFIX_LEN, client->rx_buffer.pos - (suffix - client->rx_buffer.data) - RESPONSE_PREFIX_LEN);
-                    client->rx_buffer.pos -= suffix - client->rx_buffer.data + RESPONSE_SUFFIX_LEN;
-                    client->rx_buffer.data[client->rx_buffer.pos] = 0;
-                }
+                chunk = client->rx_buffer.len - tail;
+            }
+            if (chunk > rlen)
+            {
+                chunk = rlen;
+            }
+            if (sscma_client_read(client, client->rx_buffer.data + tail, chunk) != ESP_OK)
+            {
+                break;
             }
+            client->rx_buffer.count += chunk;
+            rlen -= chunk;
+            sscma_client_rx_parse(client);
         }
     }
 }
@@ -420,7 +1447,7 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
     BaseType_t res;
     sscma_client_handle_t client = NULL;
     ESP_GOTO_ON_FALSE(io && config && ret_client, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
-    client = (sscma_client_handle_t)malloc(sizeof(struct sscma_client_t));
+    client = (sscma_client_handle_t)calloc(1, sizeof(struct sscma_client_t));
     ESP_GOTO_ON_FALSE(client, ESP_ERR_NO_MEM, err, TAG, "no mem for sscma client");
     client->io = io;
     client->inited = false;
@@ -446,8 +1473,10 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
 
     client->rx_buffer.data = (char *)malloc(config->rx_buffer_size);
     ESP_GOTO_ON_FALSE(client->rx_buffer.data, ESP_ERR_NO_MEM, err, TAG, "no mem for rx buffer");
-    client->rx_buffer.pos = 0;
     client->rx_buffer.len = config->rx_buffer_size;
+    sscma_client_rx_reset(client);
+    client->rx_notify = false;
+    client->process_task.handle = NULL;
 
     client->tx_buffer.data = (char *)malloc(config->tx_buffer_size);
     ESP_GOTO_ON_FALSE(client->tx_buffer.data, ESP_ERR_NO_MEM, err, TAG, "no mem for tx buffer");
@@ -459,13 +1488,30 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
 
     client->user_ctx = config->user_ctx;
 
-    client->request_list = (List_t *)malloc(sizeof(List_t));
-    ESP_GOTO_ON_FALSE(client->request_list, ESP_ERR_NO_MEM, err, TAG, "no mem for request list");
+    client->requests.size = config->request_slots > 0 ? config->request_slots : 8;
+    client->requests.slots = heap_caps_calloc(client->requests.size, sizeof(sscma_client_request_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_GOTO_ON_FALSE(client->requests.slots, ESP_ERR_NO_MEM, err, TAG, "no mem for request table");
+    for (size_t i = 0; i < client->requests.size; i++)
+    {
+        client->requests.slots[i].ready = xSemaphoreCreateBinaryStatic(&client->requests.slots[i].ready_buffer);
+    }
+    portMUX_INITIALIZE(&client->requests.lock);
 
     client->reply_queue = xQueueCreate(config->event_queue_size, sizeof(sscma_client_reply_t));
     ESP_GOTO_ON_FALSE(client->reply_queue, ESP_ERR_NO_MEM, err, TAG, "no mem for reply queue");
 
-    vListInitialise(client->request_list);
+    client->subscribers.lock = xSemaphoreCreateRecursiveMutex();
+    ESP_GOTO_ON_FALSE(client->subscribers.lock, ESP_ERR_NO_MEM, err, TAG, "no mem for subscriber lock");
+
+    // every result is delivered until sscma_client_set_result_rate is called
+    memset(&client->throttle, 0, sizeof(client->throttle));
+
+    client->reply_pool = NULL;
+    if (config->reply_pool_blocks > 0)
+    {
+        ESP_GOTO_ON_ERROR(sscma_client_reply_pool_new(config->reply_pool_blocks, config->reply_pool_block_size > 0 ? config->reply_pool_block_size : 16384, &client->reply_pool), err, TAG,
+            "create reply pool failed");
+    }
 
 #ifdef CONFIG_SSCMA_PROCESS_TASK_STACK_ALLOC_EXTERNAL
     client->process_task.task = heap_caps_calloc(1, sizeof(StaticTask_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
@@ -530,6 +1576,14 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
     client->on_response = NULL;
     client->on_event = NULL;
     client->on_log = NULL;
+
+    // wake the process task on data-ready instead of polling, where the transport supports it
+    client->rx_notify = sscma_client_io_set_rx_notify(client->io, sscma_client_rx_notify, client) == ESP_OK;
+    if (client->rx_notify)
+    {
+        xTaskNotifyGive(client->process_task.handle);
+    }
+
     *ret_client = client;
 
     ESP_LOGD(TAG, "new sscma client @%p", client);
@@ -558,9 +1612,14 @@ err:
         {
             vQueueDelete(client->reply_queue);
         }
-        if (client->request_list)
+        if (client->requests.slots)
         {
-            free(client->request_list);
+            free(client->requests.slots);
+        }
+        sscma_client_reply_pool_del(client->reply_pool);
+        if (client->subscribers.lock)
+        {
+            vSemaphoreDelete(client->subscribers.lock);
         }
         if (client->process_task.handle)
         {
@@ -618,27 +1677,26 @@ esp_err_t sscma_client_del(sscma_client_handle_t client)
                 gpio_reset_pin(client->reset_gpio_num);
             }
         }
+        if (client->rx_notify)
+        {
+            sscma_client_io_set_rx_notify(client->io, NULL, NULL);
+        }
         vQueueDelete(client->reply_queue);
 
-        sscma_client_request_t *first_req, *next_req = NULL;
-        if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
+        for (size_t i = 0; i < client->requests.size; i++)
         {
-            listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-            do
+            if (client->requests.slots[i].done)
             {
-                listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                uxListRemove(&(next_req->item));
-                vQueueDelete(next_req->reply);
-                free(next_req);
+                sscma_client_reply_clear(&client->requests.slots[i].reply);
             }
-            while (next_req != first_req);
         }
-
-        free(client->request_list);
+        free(client->requests.slots);
         free(client->rx_buffer.data);
         free(client->tx_buffer.data);
         vTaskDelete(client->process_task.handle);
         vTaskDelete(client->monitor_task.handle);
+        sscma_client_reply_pool_del(client->reply_pool);
+        vSemaphoreDelete(client->subscribers.lock);
 
 #ifdef CONFIG_SSCMA_PROCESS_TASK_STACK_ALLOC_EXTERNAL
         free(client->process_task.stack);
@@ -727,7 +1785,7 @@ esp_err_t sscma_client_reset(sscma_client_handle_t client)
     esp_err_t ret = ESP_OK;
     vTaskSuspend(client->process_task.handle);
 
-    client->rx_buffer.pos = 0;
+    sscma_client_rx_reset(client);
     client->tx_buffer.pos = 0;
 
     // perform hardware reset
@@ -804,106 +1862,252 @@ esp_err_t sscma_client_register_callback(sscma_client_handle_t client, const ssc
     return ESP_OK;
 }
 
-esp_err_t sscma_client_request(sscma_client_handle_t client, const char *cmd, sscma_client_reply_t *reply, bool wait, TickType_t timeout)
+esp_err_t sscma_client_subscribe(sscma_client_handle_t client, int type, const char *name, sscma_client_reply_cb_t cb, void *user_ctx, sscma_client_subscriber_handle_t *ret_subscriber)
 {
-    esp_err_t ret = ESP_OK;
-    sscma_client_request_t *request = NULL;
+    esp_err_t ret = ESP_ERR_NO_MEM;
 
-    if (wait)
+    ESP_RETURN_ON_FALSE(client && cb && ret_subscriber, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(name == NULL || strlen(name) < sizeof(client->subscribers.slots[0].name), ESP_ERR_INVALID_ARG, TAG, "name too long");
+
+    xSemaphoreTakeRecursive(client->subscribers.lock, portMAX_DELAY);
+    for (int i = 0; i < SSCMA_CLIENT_MAX_SUBSCRIBERS; i++)
     {
-        request = (sscma_client_request_t *)__malloc(sizeof(sscma_client_request_t));
-        ESP_GOTO_ON_FALSE(request, ESP_ERR_NO_MEM, err, TAG, "no mem for request");
-        request->reply = xQueueCreate(1, sizeof(sscma_client_reply_t));
-        strncpy(request->cmd, &cmd[CMD_PREFIX_LEN], sizeof(request->cmd) - 1);
-        request->cmd[sizeof(request->cmd) - 1] = '\0';
-        for (int i = 0; i < sizeof(request->cmd); i++)
+        struct sscma_client_subscriber_t *subscriber = &client->subscribers.slots[i];
+        if (subscriber->cb == NULL)
         {
-            if (request->cmd[i] == '\n' || request->cmd[i] == '\r' || request->cmd[i] == '=')
-            {
-                request->cmd[i] = '\0';
-            }
+            subscriber->type = type;
+            subscriber->hash = name ? sscma_client_cmd_hash(name) : 0;
+            strlcpy(subscriber->name, name ? name : "", sizeof(subscriber->name));
+            subscriber->user_ctx = user_ctx;
+            subscriber->cb = cb;
+            client->subscribers.count++;
+            *ret_subscriber = subscriber;
+            ret = ESP_OK;
+            break;
         }
-        ESP_GOTO_ON_FALSE(request->reply, ESP_ERR_NO_MEM, err, TAG, "no mem for reply");
-        vListInitialiseItem(&(request->item));
-        listSET_LIST_ITEM_OWNER(&(request->item), request);
-        vListInsertEnd(client->request_list, &(request->item));
     }
+    xSemaphoreGiveRecursive(client->subscribers.lock);
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "too many subscribers");
+
+    return ret;
+}
+
+esp_err_t sscma_client_unsubscribe(sscma_client_handle_t client, sscma_client_subscriber_handle_t subscriber)
+{
+    ESP_RETURN_ON_FALSE(client && subscriber && subscriber->cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    // waits for a callback running in the monitor task, unless called from it
+    xSemaphoreTakeRecursive(client->subscribers.lock, portMAX_DELAY);
+    subscriber->cb = NULL;
+    client->subscribers.count--;
+    xSemaphoreGiveRecursive(client->subscribers.lock);
 
-    ESP_GOTO_ON_ERROR(sscma_client_write(client, cmd, strlen(cmd)), err, TAG, "write command failed");
+    return ESP_OK;
+}
+
+esp_err_t sscma_client_request(sscma_client_handle_t client, const char *cmd, sscma_client_reply_t *reply, bool wait, TickType_t timeout)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_request_t *request = NULL;
 
+    // register before writing, so the reply cannot overtake the registration
     if (wait)
     {
-        if (xQueueReceive(request->reply, reply, timeout) == pdTRUE)
-        {
-            ret = ESP_OK;
-        }
-        else
-        {
-            ret = ESP_ERR_TIMEOUT;
-        }
+        ESP_RETURN_ON_ERROR(sscma_client_request_submit(client, cmd, NULL, 0, &request), TAG, "submit request failed");
     }
 
-err:
-    if (wait)
+    ret = sscma_client_write(client, cmd, strlen(cmd));
+    if (ret != ESP_OK)
     {
-        if (listIS_CONTAINED_WITHIN(client->request_list, &(request->item)))
-        {
-            uxListRemove(&(request->item));
-        }
+        ESP_LOGE(TAG, "write command failed");
         if (request)
         {
-            vQueueDelete(request->reply);
-            free(request);
+            sscma_client_request_release(client, request);
         }
+        return ret;
+    }
+
+    if (wait)
+    {
+        ret = sscma_client_request_wait(client, request, reply, timeout);
     }
+
     return ret;
 }
 
-esp_err_t sscma_client_get_info(sscma_client_handle_t client, sscma_client_info_t **info, bool cached)
+esp_err_t sscma_client_batch_submit(
+    sscma_client_handle_t client, const char *const *cmds, size_t count, TickType_t timeout, sscma_client_batch_cb_t cb, void *user_ctx, sscma_client_batch_handle_t *ret_batch)
 {
     esp_err_t ret = ESP_OK;
-    sscma_client_reply_t reply;
+    sscma_client_batch_handle_t batch = NULL;
+    sscma_client_request_t *request = NULL;
+    bool answered = false;
 
-    *info = &client->info;
+    ESP_RETURN_ON_FALSE(client && cmds && count && (cb || ret_batch), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
 
-    if (cached && client->info.id != NULL)
+    batch = (sscma_client_batch_handle_t)calloc(1, sizeof(struct sscma_client_batch_t));
+    ESP_RETURN_ON_FALSE(batch, ESP_ERR_NO_MEM, TAG, "no mem for batch");
+    batch->replies = (sscma_client_reply_t *)calloc(count, sizeof(sscma_client_reply_t));
+    ESP_GOTO_ON_FALSE(batch->replies, ESP_ERR_NO_MEM, err, TAG, "no mem for batch replies");
+
+    batch->client = client;
+    batch->count = count;
+    batch->pending = count;
+    batch->cb = cb;
+    batch->user_ctx = user_ctx;
+    batch->done = xSemaphoreCreateBinaryStatic(&batch->done_buffer);
+
+    // register every command before writing any, replies may arrive in any order
+    for (size_t i = 0; i < count; i++)
     {
-        return ret;
+        ESP_GOTO_ON_ERROR(sscma_client_request_submit(client, cmds[i], batch, i, &request), err, TAG, "submit batch command %d failed", i);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ESP_GOTO_ON_ERROR(sscma_client_write(client, cmds[i], strlen(cmds[i])), err, TAG, "write batch command %d failed", i);
     }
 
-    ESP_RETURN_ON_ERROR(sscma_client_request(client, CMD_PREFIX CMD_AT_ID CMD_QUERY CMD_SUFFIX, &reply, true, CMD_WAIT_DELAY), TAG, "request id failed");
+    if (ret_batch)
+    {
+        *ret_batch = cb ? NULL : batch;
+    }
 
-    if (reply.payload != NULL)
+    // from here on the batch may complete, and with a callback be freed, at any time
+    portENTER_CRITICAL(&client->requests.lock);
+    batch->start = xTaskGetTickCount();
+    batch->timeout = timeout;
+    batch->armed = true;
+    if (batch->pending == 0 && !batch->finished)
     {
-        fetch_string_from_object(reply.payload, "data", &client->info.id);
+        batch->finished = true;
+        batch->result = ESP_OK;
+        answered = true; // every reply arrived before the batch was armed
+    }
+    portEXIT_CRITICAL(&client->requests.lock);
 
-        sscma_client_reply_clear(&reply);
+    if (answered)
+    {
+        sscma_client_batch_finish(batch);
     }
 
-    ESP_RETURN_ON_ERROR(sscma_client_request(client, CMD_PREFIX CMD_AT_NAME CMD_QUERY CMD_SUFFIX, &reply, true, CMD_WAIT_DELAY), TAG, "request name failed");
+    return ESP_OK;
 
-    if (reply.payload != NULL)
+err:
+    if (batch->replies)
+    {
+        // nothing can complete the batch yet, at least one command is unanswered
+        portENTER_CRITICAL(&client->requests.lock);
+        batch->finished = true;
+        sscma_client_batch_cancel_locked(client, batch);
+        portEXIT_CRITICAL(&client->requests.lock);
+        sscma_client_batch_free(batch);
+    }
+    else
     {
-        fetch_string_from_object(reply.payload, "data", &(client->info.name));
+        free(batch);
+    }
 
-        sscma_client_reply_clear(&reply);
+    return ret;
+}
+
+esp_err_t sscma_client_batch_wait(sscma_client_batch_handle_t batch, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(batch && batch->cb == NULL, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    if (!batch->waited)
+    {
+        if (xSemaphoreTake(batch->done, timeout) != pdTRUE)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        batch->waited = true;
     }
 
-    ESP_RETURN_ON_ERROR(sscma_client_request(client, CMD_PREFIX CMD_AT_VERSION CMD_QUERY CMD_SUFFIX, &reply, true, CMD_WAIT_DELAY), TAG, "request version failed");
+    return batch->result;
+}
 
-    if (reply.payload != NULL)
+esp_err_t sscma_client_batch_get_reply(sscma_client_batch_handle_t batch, size_t index, const sscma_client_reply_t **reply)
+{
+    ESP_RETURN_ON_FALSE(batch && reply && index < batch->count, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *reply = &batch->replies[index];
+
+    return batch->replies[index].payload ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t sscma_client_batch_del(sscma_client_batch_handle_t batch)
+{
+    bool cancelled = false;
+
+    ESP_RETURN_ON_FALSE(batch && batch->cb == NULL, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    portENTER_CRITICAL(&batch->client->requests.lock);
+    if (!batch->finished)
     {
-        cJSON *data = cJSON_GetObjectItem(reply.payload, "data");
+        batch->finished = true;
+        batch->result = ESP_ERR_TIMEOUT;
+        sscma_client_batch_cancel_locked(batch->client, batch);
+        cancelled = true;
+    }
+    portEXIT_CRITICAL(&batch->client->requests.lock);
+
+    if (!cancelled && !batch->waited)
+    {
+        // completed but not yet signalled, wait for the give before freeing
+        xSemaphoreTake(batch->done, portMAX_DELAY);
+    }
+
+    sscma_client_batch_free(batch);
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_client_get_info(sscma_client_handle_t client, sscma_client_info_t **info, bool cached)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_batch_handle_t batch = NULL;
+    const sscma_client_reply_t *reply = NULL;
+    const char *const cmds[] = {
+        CMD_PREFIX CMD_AT_ID CMD_QUERY CMD_SUFFIX,
+        CMD_PREFIX CMD_AT_NAME CMD_QUERY CMD_SUFFIX,
+        CMD_PREFIX CMD_AT_VERSION CMD_QUERY CMD_SUFFIX,
+    };
+
+    *info = &client->info;
+
+    if (cached && client->info.id != NULL)
+    {
+        return ret;
+    }
+
+    // all three are in flight at once, the device answers them back to back
+    ESP_RETURN_ON_ERROR(sscma_client_batch_submit(client, cmds, 3, CMD_WAIT_DELAY, NULL, NULL, &batch), TAG, "request info failed");
+
+    ret = sscma_client_batch_wait(batch, portMAX_DELAY); // bounded by the batch timeout
+
+    if (sscma_client_batch_get_reply(batch, 0, &reply) == ESP_OK)
+    {
+        fetch_string_from_object(reply->payload, "data", &client->info.id);
+    }
+    if (sscma_client_batch_get_reply(batch, 1, &reply) == ESP_OK)
+    {
+        fetch_string_from_object(reply->payload, "data", &(client->info.name));
+    }
+    if (sscma_client_batch_get_reply(batch, 2, &reply) == ESP_OK)
+    {
+        cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
         if (data != NULL)
         {
             fetch_string_from_object(data, "hardware", &(client->info.hw_ver));
             fetch_string_from_object(data, "software", &(client->info.fw_ver));
             fetch_string_from_object(data, "at_api", &(client->info.sw_ver));
         }
-
-        sscma_client_reply_clear(&reply);
     }
 
+    sscma_client_batch_del(batch);
+
     return ret;
 }
 
@@ -1223,6 +2427,85 @@ esp_err_t sscma_client_get_confidence_threshold(sscma_client_handle_t client, in
     return ret;
 }
 
+esp_err_t sscma_client_set_thresholds(sscma_client_handle_t client, int iou, int confidence)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_batch_handle_t batch = NULL;
+    const sscma_client_reply_t *reply = NULL;
+    char cmd_buf[2][64] = { 0 };
+    const char *cmds[2];
+    size_t count = 0;
+
+    if (iou >= 0)
+    {
+        snprintf(cmd_buf[count], sizeof(cmd_buf[count]), CMD_PREFIX CMD_AT_TIOU CMD_SET "%d" CMD_SUFFIX, iou);
+        cmds[count] = cmd_buf[count];
+        count++;
+    }
+    if (confidence >= 0)
+    {
+        snprintf(cmd_buf[count], sizeof(cmd_buf[count]), CMD_PREFIX CMD_AT_TSCORE CMD_SET "%d" CMD_SUFFIX, confidence);
+        cmds[count] = cmd_buf[count];
+        count++;
+    }
+    if (count == 0)
+    {
+        return ret;
+    }
+
+    ESP_RETURN_ON_ERROR(sscma_client_batch_submit(client, cmds, count, CMD_WAIT_DELAY, NULL, NULL, &batch), TAG, "request set thresholds failed");
+
+    ret = sscma_client_batch_wait(batch, portMAX_DELAY); // bounded by the batch timeout
+
+    for (size_t i = 0; i < count && ret == ESP_OK; i++)
+    {
+        if (sscma_client_batch_get_reply(batch, i, &reply) == ESP_OK)
+        {
+            int code = get_int_from_object(reply->payload, "code");
+            ret = SSCMA_CLIENT_CMD_ERROR_CODE(code);
+        }
+    }
+
+    sscma_client_batch_del(batch);
+
+    return ret;
+}
+
+esp_err_t sscma_client_get_thresholds(sscma_client_handle_t client, int *iou, int *confidence)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_batch_handle_t batch = NULL;
+    const sscma_client_reply_t *reply = NULL;
+    const char *const cmds[] = {
+        CMD_PREFIX CMD_AT_TIOU CMD_QUERY CMD_SUFFIX,
+        CMD_PREFIX CMD_AT_TSCORE CMD_QUERY CMD_SUFFIX,
+    };
+    int *thresholds[] = { iou, confidence };
+
+    ESP_RETURN_ON_FALSE(iou != NULL && confidence != NULL, ESP_ERR_INVALID_ARG, TAG, "threshold is NULL");
+
+    ESP_RETURN_ON_ERROR(sscma_client_batch_submit(client, cmds, 2, CMD_WAIT_DELAY, NULL, NULL, &batch), TAG, "request get thresholds failed");
+
+    ret = sscma_client_batch_wait(batch, portMAX_DELAY); // bounded by the batch timeout
+
+    for (size_t i = 0; i < 2 && ret == ESP_OK; i++)
+    {
+        if (sscma_client_batch_get_reply(batch, i, &reply) == ESP_OK)
+        {
+            int code = get_int_from_object(reply->payload, "code");
+            ret = SSCMA_CLIENT_CMD_ERROR_CODE(code);
+            if (ret == ESP_OK)
+            {
+                *thresholds[i] = get_int_from_object(reply->payload, "data");
+            }
+        }
+    }
+
+    sscma_client_batch_del(batch);
+
+    return ret;
+}
+
 esp_err_t sscma_client_set_model_info(sscma_client_handle_t client, const char *model_info)
 {
     esp_err_t ret = ESP_OK;
@@ -1276,423 +2559,507 @@ set_model_info_exit:
     return ret;
 }
 
-esp_err_t sscma_utils_fetch_boxes_from_reply(const sscma_client_reply_t *reply, sscma_client_box_t **boxes, int *num_boxes)
+esp_err_t sscma_client_benchmark(sscma_client_handle_t client, int iterations, sscma_client_benchmark_t *result)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_reply_t reply;
+    int64_t start, begin, elapsed, total = 0;
+
+    ESP_RETURN_ON_FALSE(client && result && iterations > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    memset(result, 0, sizeof(*result));
+    result->latency_min_us = INT64_MAX;
+    sscma_client_io_get_stats(client->io, &result->io, true);
+
+    begin = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++)
+    {
+        start = esp_timer_get_time();
+        ret = sscma_client_request(client, CMD_PREFIX CMD_AT_INFO CMD_QUERY CMD_SUFFIX, &reply, true, CMD_WAIT_DELAY);
+        if (ret != ESP_OK)
+        {
+            break;
+        }
+        elapsed = esp_timer_get_time() - start;
+        if (reply.payload != NULL)
+        {
+            result->reply_bytes += reply.len;
+            sscma_client_reply_clear(&reply);
+        }
+        total += elapsed;
+        result->iterations++;
+        result->latency_min_us = elapsed < result->latency_min_us ? elapsed : result->latency_min_us;
+        result->latency_max_us = elapsed > result->latency_max_us ? elapsed : result->latency_max_us;
+    }
+    elapsed = esp_timer_get_time() - begin;
+
+    sscma_client_io_get_stats(client->io, &result->io, false);
+    if (result->iterations == 0)
+    {
+        result->latency_min_us = 0;
+        return ret;
+    }
+    result->latency_avg_us = total / result->iterations;
+    result->throughput = elapsed > 0 ? (uint32_t)(result->reply_bytes * 1000000ULL / elapsed) : 0;
+    result->read_throughput = result->io.read_time_us > 0 ? (uint32_t)(result->io.read_bytes * 1000000ULL / result->io.read_time_us) : 0;
+
+    ESP_LOGI(TAG, "benchmark: %d round trips, latency %lld/%lld/%lld us, %u B/s (read %u B/s, %lu reads, max %lld us)", result->iterations, result->latency_min_us, result->latency_avg_us,
+             result->latency_max_us, (unsigned)result->throughput, (unsigned)result->read_throughput, (unsigned long)result->io.reads, result->io.read_max_us);
+
+    return ret;
+}
+
+esp_err_t sscma_client_benchmark_read(sscma_client_handle_t client, size_t len, sscma_client_benchmark_t *result)
 {
     esp_err_t ret = ESP_OK;
+    void *buffer = NULL;
+    int64_t start;
+
+    ESP_RETURN_ON_FALSE(client && result && len > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    buffer = __malloc(len);
+    ESP_RETURN_ON_FALSE(buffer, ESP_ERR_NO_MEM, TAG, "no mem for bulk read");
+
+    sscma_client_io_get_stats(client->io, &result->io, true);
+    start = esp_timer_get_time();
+    ret = sscma_client_io_read(client->io, buffer, len);
+    result->bulk_time_us = esp_timer_get_time() - start;
+    sscma_client_io_get_stats(client->io, &result->io, false);
+    free(buffer);
+
+    result->bulk_bytes = ret == ESP_OK ? len : 0;
+    result->bulk_throughput = ret == ESP_OK && result->bulk_time_us > 0 ? (uint32_t)(len * 1000000ULL / result->bulk_time_us) : 0;
+
+    ESP_LOGI(TAG, "benchmark: bulk read %u bytes in %lld us, %u B/s", (unsigned)len, result->bulk_time_us, (unsigned)result->bulk_throughput);
+
+    return ret;
+}
+
+esp_err_t sscma_client_set_binary_mode(sscma_client_handle_t client, bool enable)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_reply_t reply;
+    char cmd[64] = { 0 };
+
+    ESP_RETURN_ON_FALSE(client, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    snprintf(cmd, sizeof(cmd), CMD_PREFIX CMD_AT_BINARY CMD_SET "%d" CMD_SUFFIX, enable ? 1 : 0);
+
+    ESP_RETURN_ON_ERROR(sscma_client_request(client, cmd, &reply, true, CMD_WAIT_DELAY), TAG, "request set binary mode failed");
+
+    if (reply.payload != NULL)
+    {
+        int code = get_int_from_object(reply.payload, "code");
+        // firmware without binary framing rejects the command as unknown
+        ret = code == CMD_EINVAL ? ESP_ERR_NOT_SUPPORTED : SSCMA_CLIENT_CMD_ERROR_CODE(code);
+        sscma_client_reply_clear(&reply);
+    }
+
+    return ret;
+}
+
+esp_err_t sscma_client_get_reply_pool_stats(sscma_client_handle_t client, sscma_client_reply_pool_stats_t *stats, bool reset)
+{
+    ESP_RETURN_ON_FALSE(client && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(client->reply_pool, ESP_ERR_NOT_SUPPORTED, TAG, "no reply pool");
+
+    sscma_client_reply_pool_t *pool = client->reply_pool;
+
+    portENTER_CRITICAL(&pool->lock);
+    *stats = pool->stats;
+    if (reset)
+    {
+        pool->stats.acquired = 0;
+        pool->stats.fallbacks = 0;
+        pool->stats.spills = 0;
+        pool->stats.high_water = pool->stats.in_use;
+        pool->stats.arena_high_water = 0;
+    }
+    portEXIT_CRITICAL(&pool->lock);
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_client_set_result_rate(sscma_client_handle_t client, int rate)
+{
+    ESP_RETURN_ON_FALSE(client && rate >= 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    client->throttle.interval = rate > 0 ? pdMS_TO_TICKS(1000 / rate) : 0;
+    client->throttle.last = xTaskGetTickCount() - client->throttle.interval;
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_client_get_result_stats(sscma_client_handle_t client, sscma_client_result_stats_t *stats, bool reset)
+{
+    ESP_RETURN_ON_FALSE(client && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *stats = client->throttle.stats;
+    if (reset)
+    {
+        memset(&client->throttle.stats, 0, sizeof(client->throttle.stats));
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_fetch_boxes_from_reply(const sscma_client_reply_t *reply, sscma_client_box_t **boxes, int *num_boxes)
+{
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "boxes is NULL");
     ESP_RETURN_ON_FALSE(num_boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_boxes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *boxes = NULL;
     *num_boxes = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *boxes_data = cJSON_GetObjectItem(data, "boxes");
-        if (boxes_data == NULL)
-            return ESP_OK;
-        *num_boxes = cJSON_GetArraySize(boxes_data);
-        if (*num_boxes == 0)
-            return ESP_OK;
-        *boxes = __malloc(sizeof(sscma_client_box_t) * (*num_boxes));
-        ESP_RETURN_ON_FALSE(*boxes != NULL, ESP_ERR_NO_MEM, TAG, "malloc boxes failed");
-        for (int i = 0; i < *num_boxes; i++)
-        {
-            cJSON *box = cJSON_GetArrayItem(boxes_data, i);
-            if (box != NULL)
-            {
-                (*boxes)[i].x = get_int_from_array(box, 0);
-                (*boxes)[i].y = get_int_from_array(box, 1);
-                (*boxes)[i].w = get_int_from_array(box, 2);
-                (*boxes)[i].h = get_int_from_array(box, 3);
-                (*boxes)[i].score = get_int_from_array(box, 4);
-                (*boxes)[i].target = get_int_from_array(box, 5);
-            }
-        }
-    }
+    // count first, then decode into an array of the right size
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    if (event.num_boxes == 0)
+        return ESP_OK;
 
-    return ret;
+    event.boxes = __malloc(sizeof(sscma_client_box_t) * event.num_boxes);
+    ESP_RETURN_ON_FALSE(event.boxes != NULL, ESP_ERR_NO_MEM, TAG, "malloc boxes failed");
+    event.max_boxes = event.num_boxes;
+    sscma_utils_decode_event(reply->data, reply->len, &event);
+
+    *boxes = event.boxes;
+    *num_boxes = event.max_boxes;
+
+    return ESP_OK;
 }
 
 esp_err_t sscma_utils_copy_boxes_from_reply(const sscma_client_reply_t *reply, sscma_client_box_t *boxes, int max_boxes, int *num_boxes)
 {
-    esp_err_t ret = ESP_OK;
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
-    ESP_RETURN_ON_FALSE(boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "classes is NULL");
-    ESP_RETURN_ON_FALSE(num_boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_classes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "boxes is NULL");
+    ESP_RETURN_ON_FALSE(num_boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_boxes is NULL");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *num_boxes = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *boxes_data = cJSON_GetObjectItem(data, "boxes");
-        if (boxes_data == NULL)
-            return ESP_OK;
-        *num_boxes = cJSON_GetArraySize(boxes_data) > max_boxes ? max_boxes : cJSON_GetArraySize(boxes_data);
-        if (*num_boxes == 0)
-            return ESP_OK;
-        for (int i = 0; i < *num_boxes; i++)
-        {
-            cJSON *item = cJSON_GetArrayItem(boxes_data, i);
-            if (item != NULL)
-            {
-                boxes[i].x = get_int_from_array(item, 0);
-                boxes[i].y = get_int_from_array(item, 1);
-                boxes[i].w = get_int_from_array(item, 2);
-                boxes[i].h = get_int_from_array(item, 3);
-                boxes[i].score = get_int_from_array(item, 4);
-                boxes[i].target = get_int_from_array(item, 5);
-            }
-        }
-    }
+    event.boxes = boxes;
+    event.max_boxes = max_boxes;
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    *num_boxes = event.num_boxes > max_boxes ? max_boxes : event.num_boxes;
 
-    return ret;
+    return ESP_OK;
 }
+
 esp_err_t sscma_utils_fetch_classes_from_reply(const sscma_client_reply_t *reply, sscma_client_class_t **classes, int *num_classes)
 {
-    esp_err_t ret = ESP_OK;
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(classes != NULL, ESP_ERR_INVALID_ARG, TAG, "classes is NULL");
     ESP_RETURN_ON_FALSE(num_classes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_classes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *classes = NULL;
     *num_classes = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *classes_data = cJSON_GetObjectItem(data, "classes");
-        if (classes_data == NULL)
-            return ESP_OK;
-        *num_classes = cJSON_GetArraySize(classes_data);
-        if (*num_classes == 0)
-            return ESP_OK;
-        *classes = __malloc(sizeof(sscma_client_class_t) * (*num_classes));
-        ESP_RETURN_ON_FALSE(*classes != NULL, ESP_ERR_NO_MEM, TAG, "malloc classes failed");
-        for (int i = 0; i < *num_classes; i++)
-        {
-            cJSON *item = cJSON_GetArrayItem(classes_data, i);
-            if (item != NULL)
-            {
-                (*classes)[i].score = get_int_from_array(item, 0);
-                (*classes)[i].target = get_int_from_array(item, 1);
-            }
-        }
-    }
+    // count first, then decode into an array of the right size
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    if (event.num_classes == 0)
+        return ESP_OK;
 
-    return ret;
+    event.classes = __malloc(sizeof(sscma_client_class_t) * event.num_classes);
+    ESP_RETURN_ON_FALSE(event.classes != NULL, ESP_ERR_NO_MEM, TAG, "malloc classes failed");
+    event.max_classes = event.num_classes;
+    sscma_utils_decode_event(reply->data, reply->len, &event);
+
+    *classes = event.classes;
+    *num_classes = event.max_classes;
+
+    return ESP_OK;
 }
 
 esp_err_t sscma_utils_copy_classes_from_reply(const sscma_client_reply_t *reply, sscma_client_class_t *classes, int max_classes, int *num_classes)
 {
-    esp_err_t ret = ESP_OK;
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(classes != NULL, ESP_ERR_INVALID_ARG, TAG, "classes is NULL");
     ESP_RETURN_ON_FALSE(num_classes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_classes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *num_classes = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *classes_data = cJSON_GetObjectItem(data, "classes");
-        if (classes_data == NULL)
-            return ESP_OK;
-        *num_classes = cJSON_GetArraySize(classes_data) > max_classes ? max_classes : cJSON_GetArraySize(classes_data);
-        if (*num_classes == 0)
-            return ESP_OK;
-        for (int i = 0; i < *num_classes; i++)
-        {
-            cJSON *item = cJSON_GetArrayItem(classes_data, i);
-            if (item != NULL)
-            {
-                classes[i].score = get_int_from_array(item, 0);
-                classes[i].target = get_int_from_array(item, 1);
-            }
-        }
-    }
+    event.classes = classes;
+    event.max_classes = max_classes;
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    *num_classes = event.num_classes > max_classes ? max_classes : event.num_classes;
 
-    return ret;
+    return ESP_OK;
 }
 
 esp_err_t sscma_utils_fetch_points_from_reply(const sscma_client_reply_t *reply, sscma_client_point_t **points, int *num_points)
 {
-    esp_err_t ret = ESP_OK;
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(points != NULL, ESP_ERR_INVALID_ARG, TAG, "points is NULL");
     ESP_RETURN_ON_FALSE(num_points != NULL, ESP_ERR_INVALID_ARG, TAG, "num_points is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *points = NULL;
     *num_points = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *ponits_data = cJSON_GetObjectItem(data, "points");
-        if (ponits_data == NULL)
-            return ESP_OK;
-        *num_points = cJSON_GetArraySize(ponits_data);
-        if (*num_points == 0)
-            return ESP_OK;
-        *points = __malloc(sizeof(sscma_client_point_t) * (*num_points));
-        ESP_RETURN_ON_FALSE(*points != NULL, ESP_ERR_NO_MEM, TAG, "malloc points failed");
-        for (int i = 0; i < *num_points; i++)
-        {
-            cJSON *item = cJSON_GetArrayItem(ponits_data, i);
-            if (item != NULL)
-            {
-                (*points)[i].x = get_int_from_array(item, 0);
-                (*points)[i].y = get_int_from_array(item, 1);
-                (*points)[i].z = 0;
-                (*points)[i].score = get_int_from_array(item, 2);
-                (*points)[i].target = get_int_from_array(item, 3);
-            }
-        }
-    }
+    // count first, then decode into an array of the right size
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    if (event.num_points == 0)
+        return ESP_OK;
 
-    return ret;
+    event.points = __malloc(sizeof(sscma_client_point_t) * event.num_points);
+    ESP_RETURN_ON_FALSE(event.points != NULL, ESP_ERR_NO_MEM, TAG, "malloc points failed");
+    event.max_points = event.num_points;
+    sscma_utils_decode_event(reply->data, reply->len, &event);
+
+    *points = event.points;
+    *num_points = event.max_points;
+
+    return ESP_OK;
 }
 
 esp_err_t sscma_utils_copy_points_from_reply(const sscma_client_reply_t *reply, sscma_client_point_t *points, int max_points, int *num_points)
 {
-    esp_err_t ret = ESP_OK;
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(points != NULL, ESP_ERR_INVALID_ARG, TAG, "points is NULL");
     ESP_RETURN_ON_FALSE(num_points != NULL, ESP_ERR_INVALID_ARG, TAG, "num_points is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *num_points = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *ponits_data = cJSON_GetObjectItem(data, "points");
-        if (ponits_data == NULL)
-            return ESP_OK;
-        *num_points = cJSON_GetArraySize(ponits_data);
-        if (*num_points == 0)
-            return ESP_OK;
-        *num_points = cJSON_GetArraySize(ponits_data) > max_points ? max_points : cJSON_GetArraySize(ponits_data);
-        for (int i = 0; i < *num_points; i++)
-        {
-            cJSON *item = cJSON_GetArrayItem(ponits_data, i);
-            if (item != NULL)
-            {
-                points[i].x = get_int_from_array(item, 0);
-                points[i].y = get_int_from_array(item, 1);
-                points[i].z = 0;
-                points[i].score = get_int_from_array(item, 2);
-                points[i].target = get_int_from_array(item, 3);
-            }
-        }
-    }
+    event.points = points;
+    event.max_points = max_points;
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    *num_points = event.num_points > max_points ? max_points : event.num_points;
 
-    return ret;
+    return ESP_OK;
 }
 
 esp_err_t sscma_utils_fetch_keypoints_from_reply(const sscma_client_reply_t *reply, sscma_client_keypoint_t **keypoints, int *num_keypoints)
 {
-    esp_err_t ret = ESP_OK;
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "keypoints is NULL");
     ESP_RETURN_ON_FALSE(num_keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "num_keypoints is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *keypoints = NULL;
     *num_keypoints = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *keypoints_data = cJSON_GetObjectItem(data, "keypoints");
-        if (keypoints_data == NULL)
-            return ESP_OK;
-        *num_keypoints = cJSON_GetArraySize(keypoints_data);
-        if (*num_keypoints == 0)
-            return ESP_OK;
-        *keypoints = __malloc(sizeof(sscma_client_keypoint_t) * (*num_keypoints));
-        ESP_RETURN_ON_FALSE(*keypoints != NULL, ESP_ERR_NO_MEM, TAG, "malloc keypoints failed");
-        for (int i = 0; i < *num_keypoints; i++)
-        {
-            cJSON *item = cJSON_GetArrayItem(keypoints_data, i);
-            if (item != NULL)
-            {
-                cJSON *box = cJSON_GetArrayItem(item, 0);
-                cJSON *points = cJSON_GetArrayItem(item, 1);
-                if (box != NULL && points != NULL)
-                {
-                    (*keypoints)[i].box.x = get_int_from_array(box, 0);
-                    (*keypoints)[i].box.y = get_int_from_array(box, 1);
-                    (*keypoints)[i].box.w = get_int_from_array(box, 2);
-                    (*keypoints)[i].box.h = get_int_from_array(box, 3);
-                    (*keypoints)[i].box.score = get_int_from_array(box, 4);
-                    (*keypoints)[i].box.target = get_int_from_array(box, 5);
-                    (*keypoints)[i].points_num = cJSON_GetArraySize(points) > SSCMA_CLIENT_MODEL_KEYPOINTS_MAX ? SSCMA_CLIENT_MODEL_KEYPOINTS_MAX : cJSON_GetArraySize(points);
-                    for (int j = 0; j < (*keypoints)[i].points_num; j++)
-                    {
-                        cJSON *point = cJSON_GetArrayItem(points, j);
-                        if (point != NULL)
-                        {
-                            (*keypoints)[i].points[j].x = get_int_from_array(point, 0);
-                            (*keypoints)[i].points[j].y = get_int_from_array(point, 1);
-                            (*keypoints)[i].points[j].z = 0;
-                            (*keypoints)[i].points[j].score = get_int_from_array(point, 2);
-                            (*keypoints)[i].points[j].target = get_int_from_array(point, 3);
-                        }
-                    }
-                }
-            }
-        }
-    }
+    // count first, then decode into an array of the right size
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    if (event.num_keypoints == 0)
+        return ESP_OK;
 
-    return ret;
+    event.keypoints = __malloc(sizeof(sscma_client_keypoint_t) * event.num_keypoints);
+    ESP_RETURN_ON_FALSE(event.keypoints != NULL, ESP_ERR_NO_MEM, TAG, "malloc keypoints failed");
+    event.max_keypoints = event.num_keypoints;
+    sscma_utils_decode_event(reply->data, reply->len, &event);
+
+    *keypoints = event.keypoints;
+    *num_keypoints = event.max_keypoints;
+
+    return ESP_OK;
 }
 
 esp_err_t sscma_utils_copy_keypoints_from_reply(const sscma_client_reply_t *reply, sscma_client_keypoint_t *keypoints, int max_keypoints, int *num_keypoints)
 {
-    esp_err_t ret = ESP_OK;
+    sscma_client_event_t event = { 0 };
 
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "keypoints is NULL");
     ESP_RETURN_ON_FALSE(num_keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "num_keypoints is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+    ESP_RETURN_ON_FALSE(reply->data != NULL, ESP_ERR_INVALID_ARG, TAG, "reply has no data");
 
     *num_keypoints = 0;
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (data != NULL)
-    {
-        cJSON *keypoints_data = cJSON_GetObjectItem(data, "keypoints");
-        if (keypoints_data == NULL)
-            return ESP_OK;
-        *num_keypoints = cJSON_GetArraySize(keypoints_data) > max_keypoints ? max_keypoints : cJSON_GetArraySize(keypoints_data);
+    event.keypoints = keypoints;
+    event.max_keypoints = max_keypoints;
+    ESP_RETURN_ON_ERROR(sscma_utils_decode_event(reply->data, reply->len, &event), TAG, "decode reply failed");
+    *num_keypoints = event.num_keypoints > max_keypoints ? max_keypoints : event.num_keypoints;
+
+    return ESP_OK;
+}
 
-        for (int i = 0; i < *num_keypoints; i++)
+// Copies a JSON string body, resolving the escapes a JSON writer may put into base64 ("\/").
+static size_t copy_unescaped(char *dst, const char *src, size_t len)
+{
+    const char *slash = memchr(src, '\\', len);
+    size_t n = 0;
+
+    if (slash == NULL)
+    {
+        memcpy(dst, src, len);
+        return len;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (src[i] == '\\' && i + 1 < len)
         {
-            cJSON *item = cJSON_GetArrayItem(keypoints_data, i);
-            if (item != NULL)
-            {
-                cJSON *box = cJSON_GetArrayItem(item, 0);
-                cJSON *points = cJSON_GetArrayItem(item, 1);
-                if (box != NULL && points != NULL)
-                {
-                    keypoints[i].box.x = get_int_from_array(box, 0);
-                    keypoints[i].box.y = get_int_from_array(box, 1);
-                    keypoints[i].box.w = get_int_from_array(box, 2);
-                    keypoints[i].box.h = get_int_from_array(box, 3);
-                    keypoints[i].box.score = get_int_from_array(box, 4);
-                    keypoints[i].box.target = get_int_from_array(box, 5);
-                    keypoints[i].points_num = cJSON_GetArraySize(points) > SSCMA_CLIENT_MODEL_KEYPOINTS_MAX ? SSCMA_CLIENT_MODEL_KEYPOINTS_MAX : cJSON_GetArraySize(points);
-                    for (int j = 0; j < keypoints[i].points_num; j++)
-                    {
-                        cJSON *point = cJSON_GetArrayItem(points, j);
-                        if (point != NULL)
-                        {
-                            keypoints[i].points[j].x = get_int_from_array(point, 0);
-                            keypoints[i].points[j].y = get_int_from_array(point, 1);
-                            keypoints[i].points[j].z = 0;
-                            keypoints[i].points[j].score = get_int_from_array(point, 2);
-                            keypoints[i].points[j].target = get_int_from_array(point, 3);
-                        }
-                    }
-                }
-            }
+            i++;
         }
+        dst[n++] = src[i];
     }
-
-    return ret;
+    return n;
 }
 
 esp_err_t sscma_utils_fetch_image_from_reply(const sscma_client_reply_t *reply, char **image, int *image_size)
 {
+    sscma_client_event_t event = { 0 };
+
     ESP_RETURN_ON_FALSE(reply && image && image_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
 
     *image = NULL;
     *image_size = 0;
 
-    if (!cJSON_IsObject(reply->payload))
+    if (reply->data == NULL || sscma_utils_decode_event(reply->data, reply->len, &event) != ESP_OK)
     {
         return ESP_ERR_INVALID_ARG;
     }
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (!data)
+    if (event.image == NULL)
     {
         return ESP_FAIL;
     }
 
-    cJSON *image_data = cJSON_GetObjectItem(data, "image");
-    if (!image_data)
+    if (event.image_raw)
     {
-        return ESP_FAIL;
-    }
-
-    const char *image_str = cJSON_GetStringValue(image_data);
-    if (!image_str)
-    {
-        return ESP_FAIL;
+        size_t len = 0;
+        mbedtls_base64_encode(NULL, 0, &len, (const unsigned char *)event.image, event.image_len);
+        *image = __malloc(len + 1);
+        if (!(*image))
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        if (mbedtls_base64_encode((unsigned char *)*image, len + 1, &len, (const unsigned char *)event.image, event.image_len) != 0)
+        {
+            free(*image);
+            *image = NULL;
+            return ESP_FAIL;
+        }
+        *image_size = len;
+        return ESP_OK;
     }
 
-    *image = __strdup(image_str);
+    *image = __malloc(event.image_len + 1);
     if (!(*image))
     {
         return ESP_ERR_NO_MEM;
     }
 
-    *image_size = strlen(image_str);
+    *image_size = copy_unescaped(*image, event.image, event.image_len);
+    (*image)[*image_size] = 0;
 
     return ESP_OK;
 }
 
 esp_err_t sscma_utils_copy_image_from_reply(const sscma_client_reply_t *reply, char *image, int max_image_size, int *image_size)
 {
+    sscma_client_event_t event = { 0 };
+
     ESP_RETURN_ON_FALSE(reply && image && image_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
 
-    if (!cJSON_IsObject(reply->payload))
+    if (reply->data == NULL || sscma_utils_decode_event(reply->data, reply->len, &event) != ESP_OK)
     {
         return ESP_ERR_INVALID_ARG;
     }
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (!data)
+    if (event.image == NULL)
     {
         return ESP_FAIL;
     }
 
-    cJSON *image_data = cJSON_GetObjectItem(data, "image");
-    if (!image_data)
+    if (event.image_raw)
     {
-        return ESP_FAIL;
+        size_t len = 0;
+        if (mbedtls_base64_encode((unsigned char *)image, max_image_size, &len, (const unsigned char *)event.image, event.image_len) != 0)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        *image_size = len;
+        return ESP_OK;
+    }
+
+    if (event.image_len > max_image_size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    *image_size = copy_unescaped(image, event.image, event.image_len);
+    if (*image_size < max_image_size)
+    {
+        image[*image_size] = 0;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_fetch_jpeg_from_reply(const sscma_client_reply_t *reply, uint8_t **jpeg, size_t *jpeg_size)
+{
+    sscma_client_event_t event = { 0 };
+    char *image = NULL;
+    size_t len = 0;
+
+    ESP_RETURN_ON_FALSE(reply && jpeg && jpeg_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    *jpeg = NULL;
+    *jpeg_size = 0;
+
+    if (reply->data == NULL || sscma_utils_decode_event(reply->data, reply->len, &event) != ESP_OK)
+    {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    const char *image_str = cJSON_GetStringValue(image_data);
-    if (!image_str)
+    if (event.image == NULL)
     {
         return ESP_FAIL;
     }
 
-    size_t image_str_len = strlen(image_str);
-    if (image_str_len > max_image_size)
+    if (event.image_raw)
     {
-        return ESP_ERR_INVALID_SIZE;
+        *jpeg = __malloc(event.image_len);
+        if (!(*jpeg))
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(*jpeg, event.image, event.image_len);
+        *jpeg_size = event.image_len;
+        return ESP_OK;
+    }
+
+    image = __malloc(event.image_len + 1);
+    if (!image)
+    {
+        return ESP_ERR_NO_MEM;
     }
+    len = copy_unescaped(image, event.image, event.image_len);
 
-    *image_size = image_str_len;
-    strcpy(image, image_str);
+    // base64 decodes to at most 3/4 of its length
+    *jpeg = __malloc(len / 4 * 3 + 3);
+    if (!(*jpeg))
+    {
+        free(image);
+        return ESP_ERR_NO_MEM;
+    }
+    if (mbedtls_base64_decode(*jpeg, len / 4 * 3 + 3, jpeg_size, (const unsigned char *)image, len) != 0)
+    {
+        free(*jpeg);
+        *jpeg = NULL;
+        *jpeg_size = 0;
+        free(image);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    free(image);
 
     return ESP_OK;
 }
@@ -1743,6 +3110,13 @@ err:
     return ret;
 }
 
+esp_err_t sscma_client_ota_verify(sscma_client_handle_t client, uint32_t *crc)
+{
+    ESP_RETURN_ON_FALSE(client && crc, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    return sscma_client_flasher_verify(client->flasher, crc);
+}
+
 esp_err_t sscma_client_ota_finish(sscma_client_handle_t client)
 {
     esp_err_t ret = ESP_OK;
@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "unity.h"
+
+#include "sscma_client.h"
+#include "sscma_client_flasher_interface.h"
+
+#define XSOH  0x01
+#define XSTX  0x02
+#define XEOT  0x04
+#define XACK  0x06
+#define XNACK 0x15
+#define XC    0x43
+
+#define OTA_ENTER_HINT "Send data using the xmodem protocol from your terminal\r\n"
+#define OTA_DONE_HINT  "Do you want to end file transmission and reboot system?\r\n"
+
+#define TEST_IMAGE_LEN  (3 * 1024 + 3 * 128)
+#define TEST_MAX_BLOCKS (TEST_IMAGE_LEN / 128)
+
+/*
+ * Stands in for the WE2 bootloader on the other end of the loopback IO: answers the menu,
+ * polls with 'C' until the first block, then checks every block against a bitwise CRC and
+ * ACKs it, except for one block that is NAKed the first time it arrives.
+ */
+typedef struct
+{
+    sscma_client_io_handle_t io;
+    SemaphoreHandle_t done;
+    uint8_t nak_id;                        // block to NAK once, 0 for none
+    bool naked;                            // whether nak_id was NAKed
+    uint8_t expected;                      // ID of the next block
+    uint8_t image[TEST_IMAGE_LEN];         // accepted payload
+    size_t image_len;                      // bytes in image
+    size_t blocks[TEST_MAX_BLOCKS];        // sizes of the accepted blocks, in order
+    int num_blocks;                        // accepted blocks
+    int packets;                           // blocks received, accepted or not
+    int ahead;                             // blocks after the expected one, sent before the rewind
+    int replayed;                          // blocks that had already been accepted
+    int crc_errors;                        // blocks whose CRC disagreed with the bitwise CRC
+    uint8_t crc_index[256 / 8];            // table entries the CRC of the blocks looked up
+    bool menu;                             // waiting for the key that enters XMODEM
+    bool started;                          // first block received
+    bool eot;                              // EOT received
+    volatile bool finished;                // 'y' received, the transfer is over
+    int io_errors;                         // answers the loopback IO could not take
+} test_device_t;
+
+static uint16_t test_crc16_bitwise(test_device_t *device, const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        // the entry a table-driven CRC would look up for this byte
+        uint8_t index = (crc >> 8) ^ data[i];
+        device->crc_index[index / 8] |= 1 << (index % 8);
+
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static void test_device_reply(test_device_t *device, uint8_t byte)
+{
+    if (sscma_client_io_loopback_inject(device->io, &byte, 1) != ESP_OK)
+    {
+        device->io_errors++;
+    }
+}
+
+// Handles one complete block, size bytes of payload after the 3-byte header.
+static void test_device_block(test_device_t *device, const uint8_t *packet, size_t size)
+{
+    uint8_t id = packet[1];
+    uint16_t crc = test_crc16_bitwise(device, packet + 3, size);
+
+    device->packets++;
+    if ((uint8_t)(id + packet[2]) != 0xFF)
+    {
+        device->crc_errors++;
+        test_device_reply(device, XNACK);
+        return;
+    }
+    if (id != device->expected)
+    {
+        // stale blocks of the window are dropped without an answer, as a receiver that
+        // NAKed a block does; anything older was already ACKed and must not be resent
+        if ((uint8_t)(device->expected - id) <= 0x7F)
+        {
+            device->replayed++;
+        }
+        else
+        {
+            device->ahead++;
+        }
+        return;
+    }
+    if (packet[3 + size] != (crc >> 8) || packet[3 + size + 1] != (crc & 0xFF))
+    {
+        device->crc_errors++;
+        test_device_reply(device, XNACK);
+        return;
+    }
+    if (id == device->nak_id && !device->naked)
+    {
+        device->naked = true;
+        test_device_reply(device, XNACK);
+        return;
+    }
+    if (device->num_blocks < TEST_MAX_BLOCKS && device->image_len + size <= TEST_IMAGE_LEN)
+    {
+        memcpy(device->image + device->image_len, packet + 3, size);
+        device->image_len += size;
+        device->blocks[device->num_blocks++] = size;
+    }
+    device->expected++;
+    test_device_reply(device, XACK);
+}
+
+/*
+ * Handles the bytes at the start of buf. Returns how many were consumed, 0 if a block is
+ * still incomplete.
+ */
+static size_t test_device_parse(test_device_t *device, const uint8_t *buf, size_t len)
+{
+    if (device->menu)
+    {
+        if (buf[0] == '1')
+        {
+            if (sscma_client_io_loopback_inject(device->io, OTA_ENTER_HINT, strlen(OTA_ENTER_HINT)) != ESP_OK)
+            {
+                device->io_errors++;
+            }
+            device->menu = false;
+        }
+        return 1;
+    }
+
+    if (buf[0] == XSOH || buf[0] == XSTX)
+    {
+        size_t size = buf[0] == XSTX ? 1024 : 128;
+        if (len < 3 + size + 2)
+        {
+            return 0;
+        }
+        device->started = true;
+        test_device_block(device, buf, size);
+        return 3 + size + 2;
+    }
+
+    if (buf[0] == XEOT && device->started)
+    {
+        device->eot = true;
+        test_device_reply(device, XACK);
+        if (sscma_client_io_loopback_inject(device->io, OTA_DONE_HINT, strlen(OTA_DONE_HINT)) != ESP_OK)
+        {
+            device->io_errors++;
+        }
+    }
+    else if (buf[0] == 'y' && device->eot)
+    {
+        device->finished = true;
+    }
+
+    // menu keys still in flight, or bytes between blocks
+    return 1;
+}
+
+static void test_device_task(void *arg)
+{
+    test_device_t *device = (test_device_t *)arg;
+    static uint8_t buf[2 * (3 + 1024 + 2)];
+    size_t len = 0;
+    size_t rlen = 0;
+    size_t used = 0;
+    TickType_t poll = 0;
+
+    while (!device->finished)
+    {
+        sscma_client_io_loopback_fetch(device->io, buf + len, sizeof(buf) - len, &rlen);
+        if (rlen == 0)
+        {
+            // a receiver polls with 'C' until the sender starts
+            if (!device->menu && !device->started && xTaskGetTickCount() - poll >= pdMS_TO_TICKS(100))
+            {
+                test_device_reply(device, XC);
+                poll = xTaskGetTickCount();
+            }
+            vTaskDelay(1);
+            continue;
+        }
+        len += rlen;
+
+        while (len > 0 && !device->finished && (used = test_device_parse(device, buf, len)) > 0)
+        {
+            len -= used;
+            memmove(buf, buf + used, len);
+        }
+    }
+
+    xSemaphoreGive(device->done);
+    vTaskDelete(NULL);
+}
+
+static void test_flash(bool xmodem_1k, int window, uint8_t nak_id, const size_t *blocks, int num_blocks)
+{
+    sscma_client_io_loopback_config_t io_config = {
+        .rx_buffer_size = 1024,
+        .tx_buffer_size = 16 * 1024,
+    };
+    sscma_client_flasher_we2_config_t config = {
+        .reset_gpio_num = -1,
+        .xmodem_window = window,
+        .flags.xmodem_1k = xmodem_1k,
+    };
+    sscma_client_io_handle_t io = NULL;
+    sscma_client_flasher_handle_t flasher = NULL;
+    test_device_t *device = calloc(1, sizeof(test_device_t));
+    uint8_t *image = malloc(TEST_IMAGE_LEN);
+    uint32_t seed = 1;
+
+    TEST_ASSERT_NOT_NULL(device);
+    TEST_ASSERT_NOT_NULL(image);
+    // pseudo-random bytes make the blocks look up every entry of the CRC table
+    for (size_t i = 0; i < TEST_IMAGE_LEN; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        image[i] = seed >> 16;
+    }
+
+    TEST_ESP_OK(sscma_client_new_io_loopback(&io_config, &io));
+    TEST_ESP_OK(sscma_client_new_flasher_we2_uart(io, &config, &flasher));
+
+    device->io = io;
+    device->nak_id = nak_id;
+    device->expected = 1;
+    device->menu = true;
+    device->done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(device->done);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(test_device_task, "we2_device", 4096, device, uxTaskPriorityGet(NULL), NULL));
+
+    TEST_ESP_OK(sscma_client_flasher_start(flasher, 0));
+    TEST_ESP_OK(sscma_client_flasher_write(flasher, image, TEST_IMAGE_LEN));
+    TEST_ESP_OK(sscma_client_flasher_finish(flasher));
+    TEST_ASSERT_TRUE(xSemaphoreTake(device->done, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(0, device->io_errors);
+
+    // table CRC of every block agrees with the bitwise CRC, and every entry was used
+    TEST_ASSERT_EQUAL(0, device->crc_errors);
+    for (size_t i = 0; i < sizeof(device->crc_index); i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8(0xFF, device->crc_index[i]);
+    }
+
+    // 1K blocks while a full one is left, 128-byte blocks for the tail
+    TEST_ASSERT_EQUAL(num_blocks, device->num_blocks);
+    for (int i = 0; i < num_blocks; i++)
+    {
+        TEST_ASSERT_EQUAL(blocks[i], device->blocks[i]);
+    }
+    TEST_ASSERT_EQUAL(TEST_IMAGE_LEN, device->image_len);
+    TEST_ASSERT_EQUAL_MEMORY(image, device->image, TEST_IMAGE_LEN);
+
+    // a NAK resends from the NAKed block, never from before it, and only the window is lost
+    TEST_ASSERT_EQUAL(nak_id != 0, device->naked);
+    TEST_ASSERT_EQUAL(0, device->replayed);
+    TEST_ASSERT_LESS_OR_EQUAL(window > 1 ? window - 1 : 0, device->ahead);
+    TEST_ASSERT_EQUAL(num_blocks + device->naked + device->ahead, device->packets);
+
+    TEST_ESP_OK(sscma_client_flasher_delete(flasher));
+    TEST_ESP_OK(sscma_client_del_io(io));
+    vSemaphoreDelete(device->done);
+    free(device);
+    free(image);
+}
+
+TEST_CASE("we2 uart flasher sends 1K blocks with a 128-byte tail", "[sscma_client][flasher]")
+{
+    static const size_t blocks[] = { 1024, 1024, 1024, 128, 128, 128 };
+    test_flash(true, 1, 0, blocks, sizeof(blocks) / sizeof(blocks[0]));
+}
+
+TEST_CASE("we2 uart flasher rewinds to a NAKed block within the window", "[sscma_client][flasher]")
+{
+    static const size_t blocks[] = { 1024, 1024, 1024, 128, 128, 128 };
+    test_flash(true, 4, 2, blocks, sizeof(blocks) / sizeof(blocks[0]));
+}
+
+TEST_CASE("we2 uart flasher rewinds to a NAKed 128-byte block", "[sscma_client][flasher]")
+{
+    size_t blocks[TEST_MAX_BLOCKS];
+    for (int i = 0; i < TEST_MAX_BLOCKS; i++)
+    {
+        blocks[i] = 128;
+    }
+    test_flash(false, 8, 5, blocks, TEST_MAX_BLOCKS);
+}
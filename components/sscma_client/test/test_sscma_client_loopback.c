@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_rom_crc.h"
+
+#include "unity.h"
+
+#include "sscma_client.h"
+#include "sscma_client_commands.h"
+
+#define TEST_MAX_RESULTS 4
+#define TEST_WAIT        pdMS_TO_TICKS(1000)
+
+// What the event callback decoded from one reply
+typedef struct
+{
+    int type;
+    char name[BINARY_FRAME_NAME_LEN + 1];
+    int width;
+    int height;
+    int num_boxes;
+    sscma_client_box_t boxes[TEST_MAX_RESULTS];
+    int num_classes;
+    sscma_client_class_t classes[TEST_MAX_RESULTS];
+    bool image_raw;
+    size_t image_len;
+    char image[64];
+} test_result_t;
+
+typedef struct
+{
+    sscma_client_io_handle_t io;
+    sscma_client_handle_t client;
+    QueueHandle_t results;
+} test_ctx_t;
+
+static const sscma_client_box_t s_boxes[] = {
+    { .x = 120, .y = 96, .w = 40, .h = 60, .score = 87, .target = 0 },
+    { .x = 300, .y = 200, .w = 32, .h = 32, .score = 65, .target = 2 },
+};
+
+static const sscma_client_class_t s_classes[] = {
+    { .score = 91, .target = 1 },
+};
+
+static const uint8_t s_jpeg[] = { 0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0xFF, 0xD9 };
+
+#define TEST_TEXT_IMAGE "/9j/4AAQSkZJRg=="
+#define TEST_TEXT_FRAME                                                                                                                                                                                \
+    "\r{\"type\": 1, \"name\": \"INVOKE\", \"code\": 0, \"data\": {\"count\": 3, \"resolution\": [416, 416], \"boxes\": [[120, 96, 40, 60, 87, 0], [300, 200, 32, 32, 65, 2]], \"classes\": [[91, 1]], " \
+    "\"image\": \"" TEST_TEXT_IMAGE "\"}}\n"
+
+static void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    test_ctx_t *ctx = (test_ctx_t *)user_ctx;
+    test_result_t result = { 0 };
+    sscma_client_event_t event = {
+        .boxes = result.boxes,
+        .max_boxes = TEST_MAX_RESULTS,
+        .classes = result.classes,
+        .max_classes = TEST_MAX_RESULTS,
+    };
+
+    if (sscma_utils_decode_event(reply->data, reply->len, &event) != ESP_OK)
+    {
+        result.type = INT_MIN;
+        xQueueSend(ctx->results, &result, 0);
+        return;
+    }
+
+    result.type = event.type;
+    memcpy(result.name, event.name, event.name_len < BINARY_FRAME_NAME_LEN ? event.name_len : BINARY_FRAME_NAME_LEN);
+    result.width = event.width;
+    result.height = event.height;
+    result.num_boxes = event.num_boxes;
+    result.num_classes = event.num_classes;
+    result.image_raw = event.image_raw;
+    result.image_len = event.image_len;
+    if (event.image && event.image_len <= sizeof(result.image))
+    {
+        memcpy(result.image, event.image, event.image_len);
+    }
+    xQueueSend(ctx->results, &result, 0);
+}
+
+static void test_setup(test_ctx_t *ctx, size_t rx_buffer_size)
+{
+    sscma_client_io_loopback_config_t io_config = {
+        .rx_buffer_size = 8192,
+        .tx_buffer_size = 1024,
+    };
+    sscma_client_config_t config = SSCMA_CLIENT_CONFIG_DEFAULT();
+    sscma_client_callback_t callback = { .on_event = on_event };
+
+    config.rx_buffer_size = rx_buffer_size;
+    config.event_queue_size = 8;
+
+    ctx->results = xQueueCreate(8, sizeof(test_result_t));
+    TEST_ASSERT_NOT_NULL(ctx->results);
+    TEST_ESP_OK(sscma_client_new_io_loopback(&io_config, &ctx->io));
+    TEST_ESP_OK(sscma_client_new(ctx->io, &config, &ctx->client));
+    TEST_ESP_OK(sscma_client_register_callback(ctx->client, &callback, ctx));
+    TEST_ESP_OK(sscma_client_init(ctx->client));
+}
+
+static void test_teardown(test_ctx_t *ctx)
+{
+    TEST_ESP_OK(sscma_client_del(ctx->client));
+    TEST_ESP_OK(sscma_client_del_io(ctx->io));
+    vQueueDelete(ctx->results);
+}
+
+// Encodes an INVOKE event with the reference results and an image of image_len bytes.
+static uint8_t *test_encode_event(size_t image_len, size_t *ret_len)
+{
+    static char image[2048];
+    sscma_client_event_t event = {
+        .type = CMD_TYPE_EVENT,
+        .code = 0,
+        .name = EVENT_INVOKE,
+        .name_len = strlen(EVENT_INVOKE),
+        .has_data = true,
+        .count = 3,
+        .width = 416,
+        .height = 416,
+        .boxes = (sscma_client_box_t *)s_boxes,
+        .num_boxes = sizeof(s_boxes) / sizeof(s_boxes[0]),
+        .classes = (sscma_client_class_t *)s_classes,
+        .num_classes = sizeof(s_classes) / sizeof(s_classes[0]),
+        .image = image_len == sizeof(s_jpeg) ? (const char *)s_jpeg : image,
+        .image_len = image_len,
+        .image_raw = true,
+    };
+    uint8_t *frame = NULL;
+
+    TEST_ASSERT_TRUE(image_len == sizeof(s_jpeg) || image_len <= sizeof(image));
+    memset(image, 0, sizeof(image));
+    TEST_ESP_OK(sscma_utils_encode_event(&event, NULL, 0, ret_len));
+    frame = malloc(*ret_len);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ESP_OK(sscma_utils_encode_event(&event, frame, *ret_len, ret_len));
+
+    return frame;
+}
+
+static void test_assert_results(const test_result_t *result)
+{
+    TEST_ASSERT_EQUAL(CMD_TYPE_EVENT, result->type);
+    TEST_ASSERT_EQUAL_STRING(EVENT_INVOKE, result->name);
+    TEST_ASSERT_EQUAL(416, result->width);
+    TEST_ASSERT_EQUAL(416, result->height);
+    TEST_ASSERT_EQUAL(2, result->num_boxes);
+    for (int i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_EQUAL(s_boxes[i].x, result->boxes[i].x);
+        TEST_ASSERT_EQUAL(s_boxes[i].y, result->boxes[i].y);
+        TEST_ASSERT_EQUAL(s_boxes[i].w, result->boxes[i].w);
+        TEST_ASSERT_EQUAL(s_boxes[i].h, result->boxes[i].h);
+        TEST_ASSERT_EQUAL(s_boxes[i].score, result->boxes[i].score);
+        TEST_ASSERT_EQUAL(s_boxes[i].target, result->boxes[i].target);
+    }
+    TEST_ASSERT_EQUAL(1, result->num_classes);
+    TEST_ASSERT_EQUAL(s_classes[0].score, result->classes[0].score);
+    TEST_ASSERT_EQUAL(s_classes[0].target, result->classes[0].target);
+}
+
+static void test_assert_idle(test_ctx_t *ctx)
+{
+    test_result_t result;
+    TEST_ASSERT_FALSE_MESSAGE(xQueueReceive(ctx->results, &result, pdMS_TO_TICKS(200)) == pdTRUE, "unexpected reply");
+}
+
+TEST_CASE("sscma client decodes text frames from the loopback io", "[sscma_client]")
+{
+    test_ctx_t ctx = { 0 };
+    test_result_t result;
+
+    test_setup(&ctx, 4096);
+
+    // noise in front of the prefix is dropped
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, "\n\r}garbage" TEST_TEXT_FRAME, strlen("\n\r}garbage" TEST_TEXT_FRAME)));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    test_assert_results(&result);
+    TEST_ASSERT_FALSE(result.image_raw);
+    TEST_ASSERT_EQUAL(strlen(TEST_TEXT_IMAGE), result.image_len);
+    TEST_ASSERT_EQUAL_MEMORY(TEST_TEXT_IMAGE, result.image, result.image_len);
+
+    // a frame split over several reads is reassembled
+    const char *frame = TEST_TEXT_FRAME;
+    size_t half = strlen(frame) / 2;
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, frame, half));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, frame + half, strlen(frame) - half));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    test_assert_results(&result);
+
+    test_assert_idle(&ctx);
+    test_teardown(&ctx);
+}
+
+TEST_CASE("sscma client decodes binary frames from the loopback io", "[sscma_client]")
+{
+    test_ctx_t ctx = { 0 };
+    test_result_t result;
+    size_t len = 0;
+    uint8_t *frame = test_encode_event(sizeof(s_jpeg), &len);
+
+    test_setup(&ctx, 4096);
+
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, frame, len));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    test_assert_results(&result);
+    TEST_ASSERT_TRUE(result.image_raw);
+    TEST_ASSERT_EQUAL(sizeof(s_jpeg), result.image_len);
+    TEST_ASSERT_EQUAL_MEMORY(s_jpeg, result.image, sizeof(s_jpeg));
+
+    // binary and text frames may be interleaved
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, TEST_TEXT_FRAME, strlen(TEST_TEXT_FRAME)));
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, frame, len));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    TEST_ASSERT_FALSE(result.image_raw);
+    test_assert_results(&result);
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    TEST_ASSERT_TRUE(result.image_raw);
+    test_assert_results(&result);
+
+    test_assert_idle(&ctx);
+    test_teardown(&ctx);
+    free(frame);
+}
+
+TEST_CASE("sscma client resyncs after a bad binary header", "[sscma_client]")
+{
+    test_ctx_t ctx = { 0 };
+    test_result_t result;
+    size_t len = 0;
+    size_t bad_len = 0;
+    uint16_t crc;
+    uint8_t *frame = test_encode_event(sizeof(s_jpeg), &len);
+    uint8_t *bad = malloc(len);
+
+
+    TEST_ASSERT_NOT_NULL(bad);
+    test_setup(&ctx, 4096);
+
+    // a magic followed by a header that fails its CRC, then the real frame
+    memcpy(bad, frame, len);
+    bad[BINARY_FRAME_HEADER_LEN - 1] ^= 0x5A;
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, bad, BINARY_FRAME_HEADER_LEN));
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, frame, len));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    TEST_ASSERT_TRUE(result.image_raw);
+    test_assert_results(&result);
+
+    // a valid header whose length field would wrap the frame length, then the real frame
+    memcpy(bad, frame, len);
+    memset(bad + 42, 0xFF, 4);
+    crc = esp_rom_crc16_le(0, bad, BINARY_FRAME_HEADER_LEN - 2);
+    bad[BINARY_FRAME_HEADER_LEN - 2] = crc & 0xFF;
+    bad[BINARY_FRAME_HEADER_LEN - 1] = crc >> 8;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, sscma_utils_binary_frame_length(bad, &bad_len));
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, bad, BINARY_FRAME_HEADER_LEN));
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, frame, len));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    TEST_ASSERT_TRUE(result.image_raw);
+    test_assert_results(&result);
+
+    // a magic with an unknown version, then a text frame
+    memcpy(bad, frame, len);
+    bad[BINARY_FRAME_MAGIC_LEN] = BINARY_FRAME_VERSION + 1;
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, bad, BINARY_FRAME_HEADER_LEN));
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, TEST_TEXT_FRAME, strlen(TEST_TEXT_FRAME)));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    TEST_ASSERT_FALSE(result.image_raw);
+    test_assert_results(&result);
+
+    test_assert_idle(&ctx);
+    test_teardown(&ctx);
+    free(bad);
+    free(frame);
+}
+
+TEST_CASE("sscma client skips binary frames larger than its rx buffer", "[sscma_client]")
+{
+    test_ctx_t ctx = { 0 };
+    test_result_t result;
+    size_t len = 0;
+    uint8_t *frame = test_encode_event(2048, &len);
+
+    test_setup(&ctx, 1024);
+    TEST_ASSERT_GREATER_THAN(1024, len);
+
+    // the oversized frame is dropped whole, the frame after it still arrives
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, frame, len));
+    TEST_ESP_OK(sscma_client_io_loopback_inject(ctx.io, TEST_TEXT_FRAME, strlen(TEST_TEXT_FRAME)));
+    TEST_ASSERT_TRUE(xQueueReceive(ctx.results, &result, TEST_WAIT));
+    TEST_ASSERT_FALSE(result.image_raw);
+    test_assert_results(&result);
+
+    test_assert_idle(&ctx);
+    test_teardown(&ctx);
+    free(frame);
+}
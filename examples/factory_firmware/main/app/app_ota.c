@@ -1,6 +1,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdatomic.h>
@@ -19,6 +20,7 @@
 #include "esp_https_ota.h"
 #include "cJSON.h"
 #include "cJSON_Utils.h"
+#include "mbedtls/sha256.h"
 
 #include "sensecap-watcher.h"
 
@@ -28,6 +30,7 @@
 #include "util.h"
 #include "tf_module_ai_camera.h"
 #include "app_sensecraft.h"
+#include "storage.h"
 #include "app_device_info.h"
 #include "app_ble.h"
 
@@ -39,7 +42,20 @@ ESP_EVENT_DEFINE_BASE(OTA_EVENT_BASE);
 #define HTTP_RX_CHUNK_SIZE              512
 #define SSCMA_FLASH_CHUNK_SIZE_SPI      256   //this value is copied from the `sscma_client_ota` example
 #define SSCMA_FLASH_CHUNK_SIZE_UART     128   //this value is copied from the `sscma_client_ota` example
+#define SSCMA_FLASH_BLOCK_SIZE_SPI      (CONFIG_SSCMA_FLASHER_BURST_PAGES * 256 * (15 / CONFIG_SSCMA_FLASHER_BURST_PAGES))  //bytes handed to the flasher per write, whole SPI bursts of up to 15 pages
+
+#define SSCMA_FLASH_BLOCK_SIZE_UART     4096  //bytes handed to the flasher per write, whole XMODEM-1K blocks
 #define AI_MODEL_RINGBUFF_SIZE          102400
+#define AI_MODEL_FLASH_ADDR             0xA00000
+#define AI_MODEL_BLOCK_SIZE             65536  //unit of the model manifest, resume and delta
+#define AI_MODEL_BLOCKS_MAX             96     //the model slot runs from 0xA00000 to the boot magic at 16MB
+#define AI_MODEL_DIGEST_SIZE            32     //sha256
+#define AI_MODEL_MANIFEST_SUFFIX        ".manifest"
+#define AI_MODEL_MANIFEST_MAX_SIZE      16384
+#define AI_MODEL_JOURNAL_KEY            "aimodel_jnl"
+#define AI_MODEL_JOURNAL_MAGIC          0x4A4D4942
+#define AI_MODEL_VALIDATOR_SIZE         64     //ETag or Last-Modified value kept in the journal
+#define AI_MODEL_JOURNAL_SAVE_BLOCKS    8      //verified blocks per journal save, bounds the NVS wear and the work lost on power loss
 
 //event group events
 #define EVENT_OTA_ESP32_DL_ABORT        BIT0  //due to network too slow
@@ -56,6 +72,31 @@ enum {
     OTA_TYPE_AI_MODEL
 };
 
+// what is known to be in the model slot, kept in NVS so a download can resume after a reboot
+typedef struct {
+    uint32_t magic;
+    uint32_t url_hash;   //image the blocks were fetched from
+    uint32_t size;       //image size, 0 while unknown
+    uint32_t blocks;
+    char etag[AI_MODEL_VALIDATOR_SIZE];           //validators of the image the blocks came from,
+    char last_modified[AI_MODEL_VALIDATOR_SIZE];  //empty if the server sent none
+    uint8_t digest[AI_MODEL_BLOCKS_MAX][AI_MODEL_DIGEST_SIZE];  //all zero until the block is flashed and verified
+} ai_model_journal_t;
+
+typedef struct {
+    bool valid;
+    int size;
+    int blocks;
+    uint8_t digest[AI_MODEL_BLOCKS_MAX][AI_MODEL_DIGEST_SIZE];
+} ai_model_manifest_t;
+
+// what a response says about the object behind the url
+typedef struct {
+    int total;  //from Content-Range, 0 if not a ranged response
+    char etag[AI_MODEL_VALIDATOR_SIZE];
+    char last_modified[AI_MODEL_VALIDATOR_SIZE];
+} ai_model_object_t;
+
 static const char *TAG = "ota";
 
 static TaskHandle_t g_task;
@@ -83,6 +124,11 @@ static RingbufHandle_t g_rb_ai_model;
 
 
 static ota_sscma_writer_userdata_t g_sscma_writer_userdata;
+static ai_model_journal_t *g_model_journal;
+static bool g_model_journal_dirty;  //verified blocks not saved yet
+
+static ai_model_manifest_t *g_model_manifest;
+static ai_model_object_t g_model_object;  //headers of the ai model transfer in progress
 
 
 static void __ota_event_handler(void *handler_args, esp_event_base_t base, int32_t id, void *event_data)
@@ -343,6 +389,286 @@ static const char *ota_type_str(int ota_type)
     else return "unknown ota";
 }
 
+// only the part before the query, signed urls of the same object differ in their query
+static uint32_t ai_model_url_hash(const char *url)
+{
+    uint32_t hash = 2166136261u;
+    while (*url && *url != '?' && *url != '#') {
+        hash = (hash ^ (uint8_t)*url++) * 16777619u;
+    }
+    return hash;
+}
+
+static bool ai_model_block_verified(int index)
+{
+    static const uint8_t zero[AI_MODEL_DIGEST_SIZE] = {0};
+    return index < (int)g_model_journal->blocks && memcmp(g_model_journal->digest[index], zero, AI_MODEL_DIGEST_SIZE) != 0;
+}
+
+static void ai_model_journal_load(void)
+{
+    size_t len = sizeof(ai_model_journal_t);
+    if (storage_read(AI_MODEL_JOURNAL_KEY, g_model_journal, &len) != ESP_OK ||
+        len != sizeof(ai_model_journal_t) || g_model_journal->magic != AI_MODEL_JOURNAL_MAGIC) {
+        memset(g_model_journal, 0, sizeof(ai_model_journal_t));
+        g_model_journal->magic = AI_MODEL_JOURNAL_MAGIC;
+    }
+}
+
+static esp_err_t ai_model_journal_save(void)
+{
+    esp_err_t ret = storage_write(AI_MODEL_JOURNAL_KEY, g_model_journal, sizeof(ai_model_journal_t));
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ai model journal, save failed: %s", esp_err_to_name(ret));
+    } else {
+        g_model_journal_dirty = false;
+    }
+    return ret;
+}
+
+// every block of the image is flashed and verified, nothing left to resume
+static bool ai_model_journal_complete(void)
+{
+    if (g_model_journal->size == 0 || g_model_journal->blocks == 0) return false;
+    for (int i = 0; i < (int)g_model_journal->blocks; i++) {
+        if (!ai_model_block_verified(i)) return false;
+    }
+    return true;
+}
+
+static void ai_model_object_header(ai_model_object_t *object, const char *key, const char *value)
+{
+    if (strcasecmp(key, "Content-Range") == 0) {
+        const char *total = strchr(value, '/');  //bytes <first>-<last>/<total>
+        object->total = total && total[1] != '*' ? atoi(total + 1) : 0;
+    } else if (strcasecmp(key, "ETag") == 0) {
+        strlcpy(object->etag, value, sizeof(object->etag));
+    } else if (strcasecmp(key, "Last-Modified") == 0) {
+        strlcpy(object->last_modified, value, sizeof(object->last_modified));
+    }
+}
+
+// same size and a validator that proves the object behind the url is the one the journal describes
+static bool ai_model_object_matches(const ai_model_object_t *object)
+{
+    ai_model_journal_t *journal = g_model_journal;
+
+    if (object->total != (int)journal->size) return false;
+    if (journal->etag[0] && object->etag[0]) return strcmp(journal->etag, object->etag) == 0;
+    if (journal->last_modified[0] && object->last_modified[0]) return strcmp(journal->last_modified, object->last_modified) == 0;
+    return false;
+}
+
+// checks the headers of an ai model transfer against the journal, recording the validators of a new image
+static bool ai_model_object_accept(const ai_model_object_t *object, bool ranged)
+{
+    ai_model_journal_t *journal = g_model_journal;
+
+    if (ranged && object->total != (int)journal->size) {
+        ESP_LOGW(TAG, "ai model, image is %d bytes on the server, expected %" PRIu32, object->total, journal->size);
+        return false;
+    }
+    if ((journal->etag[0] && object->etag[0] && strcmp(journal->etag, object->etag) != 0) ||
+        (journal->last_modified[0] && object->last_modified[0] && strcmp(journal->last_modified, object->last_modified) != 0)) {
+        ESP_LOGW(TAG, "ai model, image changed on the server during the update");
+        return false;
+    }
+    if (!journal->etag[0] && !journal->last_modified[0] && (object->etag[0] || object->last_modified[0])) {
+        strlcpy(journal->etag, object->etag, sizeof(journal->etag));
+        strlcpy(journal->last_modified, object->last_modified, sizeof(journal->last_modified));
+        ai_model_journal_save();
+    }
+    return true;
+}
+
+static esp_err_t ai_model_probe_event_handler(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_HEADER) {
+        ai_model_object_header(evt->user_data, evt->header_key, evt->header_value);
+    }
+    return ESP_OK;
+}
+
+// asks for the first byte only, to learn the size and validators of the object behind the url
+static bool ai_model_probe(const char *url, ai_model_object_t *object)
+{
+    esp_http_client_handle_t client = NULL;
+    bool ok = false;
+
+    memset(object, 0, sizeof(ai_model_object_t));
+
+    esp_http_client_config_t config = {
+        .url = url,
+        .method = HTTP_METHOD_GET,
+        .timeout_ms = HTTPS_TIMEOUT_MS,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .event_handler = ai_model_probe_event_handler,
+        .user_data = object,
+#ifdef CONFIG_SKIP_COMMON_NAME_CHECK
+        .skip_cert_common_name_check = true,
+#endif
+    };
+    client = esp_http_client_init(&config);
+    if (!client) return false;
+    esp_http_client_set_header(client, "Range", "bytes=0-0");
+    if (esp_http_client_open(client, 0) == ESP_OK && esp_http_client_fetch_headers(client) >= 0) {
+        ok = esp_http_client_get_status_code(client) == 206 && object->total > 0;
+    }
+    esp_http_client_cleanup(client);
+    return ok;
+}
+
+// the manifest sits next to the model as <url path>.manifest, keeping any query:
+// {"size": <image bytes>, "block_size": 65536, "blocks": ["<sha256 hex of block 0>", ...]}
+static bool ai_model_manifest_fetch(const char *url)
+{
+    ai_model_manifest_t *manifest = g_model_manifest;
+    esp_http_client_handle_t client = NULL;
+    char *manifest_url = NULL, *body = NULL;
+    cJSON *root = NULL;
+    int len = 0, total = 0, status;
+
+    memset(manifest, 0, sizeof(ai_model_manifest_t));
+
+    manifest_url = psram_calloc(1, strlen(url) + sizeof(AI_MODEL_MANIFEST_SUFFIX));
+    body = psram_calloc(1, AI_MODEL_MANIFEST_MAX_SIZE + 1);
+    if (!manifest_url || !body) goto manifest_end;
+    size_t path_len = strcspn(url, "?#");
+    memcpy(manifest_url, url, path_len);
+    strcpy(manifest_url + path_len, AI_MODEL_MANIFEST_SUFFIX);
+    strcat(manifest_url, url + path_len);
+
+    esp_http_client_config_t config = {
+        .url = manifest_url,
+        .method = HTTP_METHOD_GET,
+        .timeout_ms = HTTPS_TIMEOUT_MS,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+#ifdef CONFIG_SKIP_COMMON_NAME_CHECK
+        .skip_cert_common_name_check = true,
+#endif
+    };
+    client = esp_http_client_init(&config);
+    if (!client || esp_http_client_open(client, 0) != ESP_OK) goto manifest_end;
+    esp_http_client_fetch_headers(client);
+    status = esp_http_client_get_status_code(client);
+    if (status != 200) {
+        ESP_LOGI(TAG, "ai model manifest, not served (HTTP %d), fetching the whole model", status);
+        goto manifest_end;
+    }
+    while (total < AI_MODEL_MANIFEST_MAX_SIZE &&
+           (len = esp_http_client_read(client, body + total, AI_MODEL_MANIFEST_MAX_SIZE - total)) > 0) {
+        total += len;
+    }
+
+    root = cJSON_Parse(body);
+    cJSON *size = cJSON_GetObjectItem(root, "size");
+    cJSON *block_size = cJSON_GetObjectItem(root, "block_size");
+    cJSON *blocks = cJSON_GetObjectItem(root, "blocks");
+    if (!cJSON_IsNumber(size) || !cJSON_IsNumber(block_size) || !cJSON_IsArray(blocks) ||
+        block_size->valueint != AI_MODEL_BLOCK_SIZE || size->valueint <= 0 ||
+        cJSON_GetArraySize(blocks) != (size->valueint + AI_MODEL_BLOCK_SIZE - 1) / AI_MODEL_BLOCK_SIZE ||
+        cJSON_GetArraySize(blocks) > AI_MODEL_BLOCKS_MAX) {
+        ESP_LOGW(TAG, "ai model manifest, invalid, fetching the whole model");
+        goto manifest_end;
+    }
+    manifest->size = size->valueint;
+    manifest->blocks = cJSON_GetArraySize(blocks);
+    for (int i = 0; i < manifest->blocks; i++) {
+        const char *hex = cJSON_GetStringValue(cJSON_GetArrayItem(blocks, i));
+        if (!hex || strlen(hex) != 2 * AI_MODEL_DIGEST_SIZE) goto manifest_end;
+        for (int j = 0; j < AI_MODEL_DIGEST_SIZE; j++) {
+            unsigned int byte;
+            if (sscanf(hex + 2 * j, "%2x", &byte) != 1) goto manifest_end;
+            manifest->digest[i][j] = byte;
+        }
+    }
+    manifest->valid = true;
+
+manifest_end:
+    if (root) cJSON_Delete(root);
+    if (client) esp_http_client_cleanup(client);
+    free(body);
+    free(manifest_url);
+    if (!manifest->valid) memset(manifest, 0, sizeof(ai_model_manifest_t));
+    return manifest->valid;
+}
+
+// decide which blocks of the model to fetch, returns the image size or 0 if unknown (fetch everything)
+static int ai_model_plan(const char *url, bool *need)
+{
+    ai_model_journal_t *journal = g_model_journal;
+    ai_model_manifest_t *manifest = g_model_manifest;
+    ai_model_object_t object;
+    uint32_t url_hash = ai_model_url_hash(url);
+    int size = 0;
+
+    ai_model_journal_load();
+
+    if (ai_model_manifest_fetch(url)) {
+        // delta, fetch the blocks whose digest differs from what is in flash
+        size = manifest->size;
+        for (int i = 0; i < manifest->blocks; i++) {
+            need[i] = !(ai_model_block_verified(i) && memcmp(journal->digest[i], manifest->digest[i], AI_MODEL_DIGEST_SIZE) == 0);
+        }
+        for (int i = 0; i < manifest->blocks; i++) {
+            if (need[i]) memset(journal->digest[i], 0, AI_MODEL_DIGEST_SIZE);
+        }
+        memset(journal->digest[manifest->blocks], 0, (AI_MODEL_BLOCKS_MAX - manifest->blocks) * AI_MODEL_DIGEST_SIZE);
+        journal->blocks = manifest->blocks;
+        journal->size = manifest->size;
+        journal->etag[0] = 0;  //the blocks are checked against the manifest, not against an older image
+        journal->last_modified[0] = 0;
+    } else if (journal->url_hash == url_hash && journal->size > 0 && !ai_model_journal_complete() &&
+               ai_model_probe(url, &object) && ai_model_object_matches(&object)) {
+        // resume an interrupted download, the server still has the image the verified blocks came from
+        size = journal->size;
+        for (int i = 0; i < (int)journal->blocks; i++) {
+            need[i] = !ai_model_block_verified(i);
+        }
+    } else {
+        if (journal->url_hash == url_hash && journal->size > 0) {
+            ESP_LOGI(TAG, "ai model journal, %s, fetching the whole model",
+                     ai_model_journal_complete() ? "previous update completed" : "image changed on the server");
+        }
+        memset(journal, 0, sizeof(ai_model_journal_t));
+        journal->magic = AI_MODEL_JOURNAL_MAGIC;
+    }
+    journal->url_hash = url_hash;
+    ai_model_journal_save();
+
+    return size;
+}
+
+static esp_err_t ai_model_block_commit(sscma_client_handle_t sscma_client, int index, mbedtls_sha256_context *sha)
+{
+    uint8_t digest[AI_MODEL_DIGEST_SIZE];
+    uint32_t crc = 0;
+    esp_err_t ret;
+
+    mbedtls_sha256_finish(sha, digest);
+    if (index >= AI_MODEL_BLOCKS_MAX) {
+        return ESP_OK;  //past what the journal tracks, flashed but not resumable
+    }
+    if (g_model_manifest->valid && memcmp(digest, g_model_manifest->digest[index], AI_MODEL_DIGEST_SIZE) != 0) {
+        ESP_LOGE(TAG, "ai model block %d, digest differs from the manifest", index);
+        return ESP_ERR_INVALID_CRC;
+    }
+    //the read-back crc only covers what was just sent, so it is checked here and not kept
+    ret = sscma_client_ota_verify(sscma_client, &crc);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGE(TAG, "ai model block %d, read-back verify failed: %s", index, esp_err_to_name(ret));
+        return ret;
+    }
+    memcpy(g_model_journal->digest[index], digest, AI_MODEL_DIGEST_SIZE);
+    g_model_journal_dirty = true;
+    if ((index + 1) % AI_MODEL_JOURNAL_SAVE_BLOCKS == 0) {
+        ai_model_journal_save();
+    }
+    ESP_LOGD(TAG, "ai model block %d verified, crc 0x%08" PRIx32, index, crc);
+
+    return ESP_OK;
+}
+
 static sscma_client_flasher_handle_t bsp_sscma_flasher_init_legacy(sscma_client_handle_t sscma_client)
 {
     static sscma_client_flasher_handle_t _sscma_flasher_handle = NULL;
@@ -382,8 +708,12 @@ static sscma_client_flasher_handle_t bsp_sscma_flasher_init_legacy(sscma_client_
     const sscma_client_flasher_we2_config_t flasher_config = {
         .reset_gpio_num = BSP_SSCMA_CLIENT_RST,
         .io_expander = sscma_client->io_expander,
+        .xmodem_window = CONFIG_SSCMA_FLASHER_XMODEM_WINDOW,
         .flags.reset_use_expander = BSP_SSCMA_CLIENT_RST_USE_EXPANDER,
         .flags.reset_high_active = false,
+#if CONFIG_SSCMA_FLASHER_XMODEM_1K
+        .flags.xmodem_1k = true,
+#endif
         .user_ctx = NULL,
     };
 
@@ -405,8 +735,12 @@ static void __sscma_writer_task(void *p_arg)
         content_len = userdata->content_len;
         ota_type = userdata->ota_type;
         if (content_len <= 0) continue;
+        if (userdata->err != ESP_OK) {
+            xSemaphoreGive(g_sem_sscma_writer_done);  //the transfer was refused before any byte reached us
+            continue;
+        }
 
-        ESP_LOGI(TAG, "starting sscma writer, content_len=%d ...", content_len);
+        ESP_LOGI(TAG, "starting sscma writer, content_len=%d, offset=%d ...", content_len, userdata->offset);
 
         int32_t ota_eventid = ota_type == OTA_TYPE_HIMAX ? CTRL_EVENT_OTA_HIMAX_FW: CTRL_EVENT_OTA_AI_MODEL;
 
@@ -446,6 +780,7 @@ static void __sscma_writer_task(void *p_arg)
         assert(sscma_flasher != NULL);
 
         int sscma_flasher_chunk_size_decided = use_spi_flasher ? SSCMA_FLASH_CHUNK_SIZE_SPI : SSCMA_FLASH_CHUNK_SIZE_UART;
+        int sscma_flasher_block_size_decided = use_spi_flasher ? SSCMA_FLASH_BLOCK_SIZE_SPI : SSCMA_FLASH_BLOCK_SIZE_UART;
 
         //sscma_client_init(sscma_client);
 
@@ -455,11 +790,23 @@ static void __sscma_writer_task(void *p_arg)
             ESP_LOGI(TAG, "flash Himax firmware ...");
         } else {
             ESP_LOGI(TAG, "flash Himax 4th ai model ...");
-            flash_addr = 0xA00000;
+            flash_addr = AI_MODEL_FLASH_ADDR;
+        }
+
+        //ai model blocks are hashed and verified as they are flashed, so an interrupted update can resume
+        ai_model_journal_t *journal = ota_type == OTA_TYPE_AI_MODEL ? g_model_journal : NULL;
+        int block_index = userdata->offset / AI_MODEL_BLOCK_SIZE;
+        int block_pos = 0;
+        mbedtls_sha256_context sha;
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts(&sha, 0);
+        if (journal && journal->size == 0) {
+            journal->size = content_len;
+            journal->blocks = MIN((content_len + AI_MODEL_BLOCK_SIZE - 1) / AI_MODEL_BLOCK_SIZE, AI_MODEL_BLOCKS_MAX);
         }
 
         //sscma_client_ota_start
-        if (sscma_client_ota_start(sscma_client, sscma_flasher, flash_addr) != ESP_OK) {
+        if (sscma_client_ota_start(sscma_client, sscma_flasher, flash_addr + userdata->offset) != ESP_OK) {
             ESP_LOGE(TAG, "sscma writer, sscma_client_ota_start failed");
             userdata->err = ESP_ERR_OTA_SSCMA_START_FAIL;
             goto sscma_writer_end;
@@ -471,85 +818,109 @@ static void __sscma_writer_task(void *p_arg)
                                             &ota_status, sizeof(struct view_data_ota_status),
                                             pdMS_TO_TICKS(10000));
 
-        // drain the ringbuffer and write to himax
+        // drain the ringbuffer and write to himax in blocks, the download keeps filling the
+        // ringbuffer while a block is being flashed
         int written_len = 0;
         int remain_len = content_len - written_len;
         int step_bytes = (int)(content_len / 10);
         int last_report_bytes = step_bytes;
-        int target_bytes;
+        int target_bytes, filled_bytes, flash_bytes;
         int retry_cnt = 0;
-        void *chunk = psram_calloc(1, sscma_flasher_chunk_size_decided);
+        int64_t last_report_time = start;
+        int last_report_written = 0;
+        void *chunk = psram_calloc(1, sscma_flasher_block_size_decided);
         void *tmp;
-        UBaseType_t available_bytes = 0;
-        size_t rcvlen, rcvlen2;
+        const void *block;
+        size_t rcvlen;
 
-        while (remain_len > 0 && !atomic_load(&g_sscma_writer_abort)) {
-            target_bytes = MIN(sscma_flasher_chunk_size_decided, remain_len);
-            vRingbufferGetInfo(g_rb_ai_model, NULL, NULL, NULL, NULL, &available_bytes);
-            if ((int)available_bytes < target_bytes) {
-                vTaskDelay(pdMS_TO_TICKS(1));
-                retry_cnt++;
-                if (retry_cnt > 60000) {
-                    ESP_LOGE(TAG, "sscma writer reach timeout on ringbuffer!!! want_bytes: %d", target_bytes);
-                    userdata->err = ESP_ERR_OTA_SSCMA_WRITE_FAIL;
-                    goto sscma_writer_end0;
-                }
-                continue;
-            }
-            retry_cnt = 0;
+        if (!chunk) {
+            ESP_LOGE(TAG, "sscma writer, no mem for flash block");
+            userdata->err = ESP_ERR_OTA_SSCMA_INTERNAL_ERR;
+            goto sscma_writer_end;
+        }
 
-            rcvlen = 0, rcvlen2 = 0;
-            tmp = xRingbufferReceiveUpTo(g_rb_ai_model, &rcvlen, 0, target_bytes);
-            if (!tmp) {
-                ESP_LOGW(TAG, "sscma writer, ringbuffer insufficient? this should never happen!");
-                userdata->err = ESP_ERR_OTA_SSCMA_INTERNAL_ERR;
-                goto sscma_writer_end0;
-            }
-            memset(chunk, 0, sscma_flasher_chunk_size_decided);
-            memcpy(chunk, tmp, rcvlen);
-            target_bytes -= rcvlen;
-            vRingbufferReturnItem(g_rb_ai_model, tmp);
-            //rollover?
-            if (target_bytes > 0) {
-                tmp = xRingbufferReceiveUpTo(g_rb_ai_model, &rcvlen2, 0, target_bytes);  //receive the 2nd part
+        while (remain_len > 0 && !atomic_load(&g_sscma_writer_abort)) {
+            target_bytes = MIN(sscma_flasher_block_size_decided, remain_len);
+            if (journal) target_bytes = MIN(target_bytes, AI_MODEL_BLOCK_SIZE - block_pos);
+            filled_bytes = 0;
+            block = NULL;
+            tmp = NULL;
+
+            while (filled_bytes < target_bytes && !atomic_load(&g_sscma_writer_abort)) {
+                rcvlen = 0;
+                tmp = xRingbufferReceiveUpTo(g_rb_ai_model, &rcvlen, pdMS_TO_TICKS(1000), target_bytes - filled_bytes);
                 if (!tmp) {
-                    ESP_LOGW(TAG, "sscma writer, ringbuffer insufficient? this should never happen [2]!");
-                    userdata->err = ESP_ERR_OTA_SSCMA_INTERNAL_ERR;
-                    goto sscma_writer_end0;
+                    //himax will move the written bytes into flash every 1MB, the downloader may stall meanwhile
+                    if (++retry_cnt > 60) {
+                        ESP_LOGE(TAG, "sscma writer reach timeout on ringbuffer!!! want_bytes: %d", target_bytes - filled_bytes);
+                        userdata->err = ESP_ERR_OTA_SSCMA_WRITE_FAIL;
+                        goto sscma_writer_end0;
+                    }
+                    continue;
+                }
+                retry_cnt = 0;
+                if (filled_bytes == 0 && rcvlen == target_bytes && target_bytes % sscma_flasher_chunk_size_decided == 0) {
+                    block = tmp;  //whole block in one piece, flash it straight from the ringbuffer
+                    filled_bytes = rcvlen;
+                    break;
                 }
-                memcpy(chunk + rcvlen, tmp, rcvlen2);
-                target_bytes -= rcvlen2;
+                memcpy(chunk + filled_bytes, tmp, rcvlen);
+                filled_bytes += rcvlen;
                 vRingbufferReturnItem(g_rb_ai_model, tmp);
+                tmp = NULL;
+            }
+            if (filled_bytes < target_bytes) {
+                if (tmp) vRingbufferReturnItem(g_rb_ai_model, tmp);
+                break;  //aborted
             }
 
-            if (target_bytes != 0) {
-                ESP_LOGW(TAG, "sscma writer, this really should never happen!");
-                userdata->err = ESP_ERR_OTA_SSCMA_INTERNAL_ERR;
-                goto sscma_writer_end0;
+            flash_bytes = target_bytes;
+            if (!block) {
+                //only the tail of the image needs padding up to the flasher chunk size
+                flash_bytes = (target_bytes + sscma_flasher_chunk_size_decided - 1) / sscma_flasher_chunk_size_decided * sscma_flasher_chunk_size_decided;
+                memset(chunk + target_bytes, 0, flash_bytes - target_bytes);
+                block = chunk;
             }
 
             //write to sscma client
-            // ESP_LOGD(TAG, "sscma writer, sscma_client_ota_write");
-            if (sscma_client_ota_write(sscma_client, chunk, sscma_flasher_chunk_size_decided) != ESP_OK)
+            esp_err_t write_err = sscma_client_ota_write(sscma_client, block, flash_bytes);
+            if (write_err == ESP_OK && journal) {
+                mbedtls_sha256_update(&sha, block, target_bytes);
+                block_pos += target_bytes;
+                if (block_pos == AI_MODEL_BLOCK_SIZE || remain_len == target_bytes) {
+                    write_err = ai_model_block_commit(sscma_client, block_index, &sha);
+                    block_index++;
+                    block_pos = 0;
+                    mbedtls_sha256_starts(&sha, 0);
+                }
+            }
+            if (tmp) vRingbufferReturnItem(g_rb_ai_model, tmp);
+            if (write_err != ESP_OK)
             {
                 ESP_LOGW(TAG, "sscma writer, sscma_client_ota_write failed\n");
                 userdata->err = ESP_ERR_OTA_SSCMA_WRITE_FAIL;
                 goto sscma_writer_end0;
             } else {
-                written_len += (rcvlen + rcvlen2);
+                written_len += target_bytes;
                 if (written_len >= last_report_bytes) {
+                    int64_t now = esp_timer_get_time();
                     ota_status.status = OTA_STATUS_DOWNLOADING;
-                    ota_status.percentage = (int)(100 * written_len / content_len);
+                    ota_status.percentage = userdata->progress_total > 0 ?
+                                            (int)(100LL * (userdata->progress_base + written_len) / userdata->progress_total) :
+                                            (int)(100 * written_len / content_len);
                     ota_status.err_code = ESP_OK;
                     esp_event_post_to(app_event_loop_handle, CTRL_EVENT_BASE, ota_eventid,
                                         &ota_status, sizeof(struct view_data_ota_status),
                                         pdMS_TO_TICKS(10000));
                     last_report_bytes += step_bytes;
-                    ESP_LOGI(TAG, "%s ota, bytes written: %d, %d%%", ota_type_str(ota_type), written_len, ota_status.percentage);
+                    ESP_LOGI(TAG, "%s ota, bytes written: %d, %d%%, %d KB/s", ota_type_str(ota_type), written_len, ota_status.percentage,
+                                    (int)(1000000LL * (written_len - last_report_written) / 1024 / MAX(now - last_report_time, 1)));
+                    last_report_time = now;
+                    last_report_written = written_len;
                 }
             }
 
-            remain_len -= (rcvlen + rcvlen2);
+            remain_len -= target_bytes;
         }  //while
 
         if (atomic_load(&g_sscma_writer_abort)) {
@@ -564,6 +935,10 @@ static void __sscma_writer_task(void *p_arg)
 sscma_writer_end0:
         free(chunk);
 sscma_writer_end:
+        mbedtls_sha256_free(&sha);
+        if (journal && g_model_journal_dirty) {
+            ai_model_journal_save();  //the verified blocks since the last batched save
+        }
         if (is_abort || userdata->err != ESP_OK) {
             ESP_LOGW(TAG, "sscma_client_ota_abort !!!");
             sscma_client_ota_abort(sscma_client);
@@ -585,6 +960,7 @@ static esp_err_t __http_event_handler(esp_http_client_event_t *evt)
             ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
             content_len = 0;
             written_len = 0;
+            memset(&g_model_object, 0, sizeof(g_model_object));
             //clear the ringbuffer
             void *tmp;
             size_t len;
@@ -600,6 +976,9 @@ static esp_err_t __http_event_handler(esp_http_client_event_t *evt)
             break;
         case HTTP_EVENT_ON_HEADER:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
+            if (userdata->ota_type == OTA_TYPE_AI_MODEL) {
+                ai_model_object_header(&g_model_object, evt->header_key, evt->header_value);
+            }
             break;
         case HTTP_EVENT_ON_DATA:
             ESP_LOGV(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
@@ -609,6 +988,17 @@ static esp_err_t __http_event_handler(esp_http_client_event_t *evt)
                 ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, content_len=%d", content_len);
                 userdata->content_len = content_len;
                 userdata->err = ESP_OK;
+                if (userdata->offset > 0 && esp_http_client_get_status_code(evt->client) != 206) {
+                    ESP_LOGW(TAG, "HTTP_EVENT_ON_DATA, server ignored the range request");
+                    userdata->err = ESP_ERR_OTA_DOWNLOAD_FAIL;
+                } else if (userdata->ota_type == OTA_TYPE_AI_MODEL &&
+                           !ai_model_object_accept(&g_model_object, userdata->progress_total > 0)) {
+                    //never splice blocks of two different images, start over on the next attempt
+                    memset(g_model_journal, 0, sizeof(ai_model_journal_t));
+                    g_model_journal->magic = AI_MODEL_JOURNAL_MAGIC;
+                    ai_model_journal_save();
+                    userdata->err = ESP_ERR_OTA_DOWNLOAD_FAIL;
+                }
                 xTaskNotifyGive(g_task_sscma_writer);
 
                 step_bytes = (int)(content_len / 10);
@@ -653,22 +1043,19 @@ static esp_err_t __http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
-static void sscma_ota_process(uint32_t ota_type, char *url)
+// one HTTP GET streamed through the sscma writer, the whole image if range_len is 0
+static esp_err_t sscma_ota_fetch(uint32_t ota_type, char *url, int range_start, int range_len)
 {
-    ESP_LOGI(TAG, "starting sscma ota, ota_type = %s ...", ota_type_str(ota_type));
-
     esp_err_t ret = ESP_OK;
-    struct view_data_ota_status ota_status;
-    int32_t ota_eventid = ota_type == OTA_TYPE_HIMAX ? CTRL_EVENT_OTA_HIMAX_FW: CTRL_EVENT_OTA_AI_MODEL;
-
     int64_t start = esp_timer_get_time();
+    char range[48];
 
     //https init
     esp_http_client_config_t *http_client_config = NULL;
     esp_http_client_handle_t http_client = NULL;
 
     http_client_config = psram_calloc(1, sizeof(esp_http_client_config_t));
-    ESP_GOTO_ON_FALSE(http_client_config != NULL, ESP_ERR_NO_MEM, sscma_ota_end,
+    ESP_GOTO_ON_FALSE(http_client_config != NULL, ESP_ERR_NO_MEM, sscma_fetch_end,
                       TAG, "sscma ota, mem alloc fail [1]");
     http_client_config->url = url;
     http_client_config->method = HTTP_METHOD_GET;
@@ -682,19 +1069,17 @@ static void sscma_ota_process(uint32_t ota_type, char *url)
 #endif
 
     http_client = esp_http_client_init(http_client_config);
-    ESP_GOTO_ON_FALSE(http_client != NULL, ESP_ERR_OTA_CONNECTION_FAIL, sscma_ota_end,
+    ESP_GOTO_ON_FALSE(http_client != NULL, ESP_ERR_OTA_CONNECTION_FAIL, sscma_fetch_end,
                       TAG, "sscma ota, http client init fail");
+    if (range_len > 0) {
+        snprintf(range, sizeof(range), "bytes=%d-%d", range_start, range_start + range_len - 1);
+        esp_http_client_set_header(http_client, "Range", range);
+    }
 
     g_sscma_writer_userdata.ota_type = ota_type;
     g_sscma_writer_userdata.http_client = http_client;
     g_sscma_writer_userdata.err = ESP_OK;
-
-    //breakpoint to check if user canceled, this is the last chance to do early abortion
-    if (xEventGroupWaitBits(g_eg_globalsync, EVENT_AI_MODEL_DL_EARLY_ABORT, pdTRUE, pdTRUE, 0) & EVENT_AI_MODEL_DL_EARLY_ABORT) {
-        ret = ESP_ERR_OTA_USER_CANCELED;
-        goto sscma_ota_end;
-    }
-    xEventGroupClearBits(g_eg_globalsync, EVENT_AI_MODEL_DL_PREPARING); //clear this bit regardless ai model dl or himax fw dl
+    g_sscma_writer_userdata.offset = range_start;
 
     xEventGroupSetBits(g_eg_globalsync, EVENT_OTA_HIMAX_HTTP_GOING);
     esp_err_t err = esp_http_client_perform(http_client);
@@ -730,12 +1115,72 @@ static void sscma_ota_process(uint32_t ota_type, char *url)
         xSemaphoreTake(g_sem_sscma_writer_done, pdMS_TO_TICKS(10000));
     }
 
-sscma_ota_end:
+sscma_fetch_end:
     if (http_client_config) free(http_client_config);
     if (http_client) esp_http_client_close(http_client);
     if (http_client) esp_http_client_cleanup(http_client);
     g_sscma_writer_userdata.http_client = NULL;
+    g_sscma_writer_userdata.offset = 0;
 
+    return ret;
+}
+
+static void sscma_ota_process(uint32_t ota_type, char *url)
+{
+    ESP_LOGI(TAG, "starting sscma ota, ota_type = %s ...", ota_type_str(ota_type));
+
+    esp_err_t ret = ESP_OK;
+    struct view_data_ota_status ota_status;
+    int32_t ota_eventid = ota_type == OTA_TYPE_HIMAX ? CTRL_EVENT_OTA_HIMAX_FW: CTRL_EVENT_OTA_AI_MODEL;
+    bool need[AI_MODEL_BLOCKS_MAX];
+    int image_size = 0, blocks = 0, done_bytes = 0;
+
+    //ai model: fetch only the blocks that are not in flash yet (delta with a manifest, or resume)
+    if (ota_type == OTA_TYPE_AI_MODEL) {
+        image_size = ai_model_plan(url, need);
+        blocks = (image_size + AI_MODEL_BLOCK_SIZE - 1) / AI_MODEL_BLOCK_SIZE;
+        for (int i = 0; i < blocks; i++) {
+            if (!need[i]) done_bytes += MIN(AI_MODEL_BLOCK_SIZE, image_size - i * AI_MODEL_BLOCK_SIZE);
+        }
+        if (image_size > 0) {
+            ESP_LOGI(TAG, "sscma ota, ai model %d bytes, %d of %d bytes already in flash", image_size, done_bytes, image_size);
+        }
+    } else {
+        //a firmware update may rewrite anything, forget what we knew about the model slot
+        ai_model_journal_load();
+        if (g_model_journal->size > 0) {
+            memset(g_model_journal, 0, sizeof(ai_model_journal_t));
+            g_model_journal->magic = AI_MODEL_JOURNAL_MAGIC;
+            ai_model_journal_save();
+        }
+    }
+    g_sscma_writer_userdata.progress_base = done_bytes;
+    g_sscma_writer_userdata.progress_total = image_size;
+
+    //breakpoint to check if user canceled, this is the last chance to do early abortion
+    if (xEventGroupWaitBits(g_eg_globalsync, EVENT_AI_MODEL_DL_EARLY_ABORT, pdTRUE, pdTRUE, 0) & EVENT_AI_MODEL_DL_EARLY_ABORT) {
+        ret = ESP_ERR_OTA_USER_CANCELED;
+        goto sscma_ota_end;
+    }
+    xEventGroupClearBits(g_eg_globalsync, EVENT_AI_MODEL_DL_PREPARING); //clear this bit regardless ai model dl or himax fw dl
+
+    if (image_size == 0) {
+        ret = sscma_ota_fetch(ota_type, url, 0, 0);
+    } else {
+        //one ranged request per run of consecutive blocks to fetch
+        for (int i = 0; i < blocks && ret == ESP_OK; i++) {
+            if (!need[i]) continue;
+            int first = i;
+            while (i + 1 < blocks && need[i + 1]) i++;
+            int run_start = first * AI_MODEL_BLOCK_SIZE;
+            int run_len = MIN((i + 1) * AI_MODEL_BLOCK_SIZE, image_size) - run_start;
+            ESP_LOGI(TAG, "sscma ota, fetching ai model blocks %d-%d", first, i);
+            ret = sscma_ota_fetch(ota_type, url, run_start, run_len);
+            g_sscma_writer_userdata.progress_base += run_len;
+        }
+    }
+
+sscma_ota_end:
     g_result_err = ret;
 
     ota_status.status = g_result_err == ESP_OK ? OTA_STATUS_SUCCEED : OTA_STATUS_FAIL;
@@ -1356,6 +1801,10 @@ esp_err_t app_ota_init(void)
     uint8_t *buffer_storage = (uint8_t *)psram_calloc(1, AI_MODEL_RINGBUFF_SIZE);
     g_rb_ai_model = xRingbufferCreateStatic(AI_MODEL_RINGBUFF_SIZE, RINGBUF_TYPE_BYTEBUF, buffer_storage, buffer_struct);
 
+    // ai model resume / delta state
+    g_model_journal = psram_calloc(1, sizeof(ai_model_journal_t));
+    g_model_manifest = psram_calloc(1, sizeof(ai_model_manifest_t));
+
     // ota main task
     const uint32_t stack_size = 10 * 1024;
     StackType_t *task_stack = (StackType_t *)psram_calloc(1, stack_size * sizeof(StackType_t));
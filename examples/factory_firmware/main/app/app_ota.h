@@ -60,6 +60,9 @@ typedef struct {
     int content_len;
     esp_err_t err;
     esp_http_client_handle_t http_client;
+    int offset;          // image offset of this transfer, non-zero for a ranged one
+    int progress_base;   // image bytes already in place before this transfer
+    int progress_total;  // image size, 0 if this transfer is the whole image
 } ota_sscma_writer_userdata_t;
 
 //worker cmd
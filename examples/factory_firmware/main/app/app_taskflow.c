@@ -1029,6 +1029,13 @@ static  void taskflow_engine_module_init( struct app_taskflow * p_taskflow)
     ESP_ERROR_CHECK(tf_module_http_alarm_register());
     //add more module
 
+    // frames go to a short lossy lane, slow alarm handlers get their own lane
+    ESP_ERROR_CHECK(tf_module_lane_set(TF_MODULE_IMG_ANALYZER_NAME, TF_LANE_MEDIA));
+    ESP_ERROR_CHECK(tf_module_lane_set(TF_MODULE_ALARM_TRIGGER_NAME, TF_LANE_MEDIA));
+    ESP_ERROR_CHECK(tf_module_lane_set(TF_MODULE_LOCAL_ALARM_NAME, TF_LANE_ALARM));
+    ESP_ERROR_CHECK(tf_module_lane_set(TF_MODULE_SENSECRAFT_ALARM_NAME, TF_LANE_ALARM));
+    ESP_ERROR_CHECK(tf_module_lane_set(TF_MODULE_UART_ALARM_NAME, TF_LANE_ALARM));
+
     ESP_ERROR_CHECK(tf_engine_status_cb_register(__task_flow_status_cb, p_taskflow));
     ESP_ERROR_CHECK(tf_module_status_cb_register(__task_flow_module_status_cb, p_taskflow));
 }
@@ -239,7 +239,10 @@ void app_main(void)
     const esp_app_desc_t *app_desc = esp_app_get_description();
     ESP_LOGI("", SENSECAP, app_desc->version, __DATE__, __TIME__);
 
-    cJSON_InitHooks(&cJSONHooks);
+    // let SSCMA replies parse into their pool block, everything else still goes to PSRAM
+    cJSON_Hooks hooks;
+    sscma_client_json_hooks(&cJSONHooks, &hooks);
+    cJSON_InitHooks(&hooks);
 
     esp_event_loop_args_t app_event_loop_args = { .queue_size = 64,
         .task_name = "app_eventloop",
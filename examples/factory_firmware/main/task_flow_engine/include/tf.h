@@ -16,6 +16,11 @@ extern "C"
 #define TF_ENGINE_TASK_PRIO 13
 #define TF_ENGINE_QUEUE_SIZE 3
 
+// Lane event queue size, the media lane is kept short so stale frames are not queued
+#define TF_LANE_DEFAULT_QUEUE_SIZE  32
+#define TF_LANE_MEDIA_QUEUE_SIZE    4
+#define TF_LANE_ALARM_QUEUE_SIZE    8
+
 // Define status codes for engine state
 #define TF_STATUS_RUNNING               0
 #define TF_STATUS_STARTING              1
@@ -50,19 +55,43 @@ typedef struct tf_module_node
     const char *p_desc;
     const char *p_version;
     tf_module_mgmt_t *mgmt_handle;
+    int lane;
     SLIST_ENTRY(tf_module_node)
     next;
 } tf_module_node_t;
 
 typedef SLIST_HEAD(tf_module_nodes, tf_module_node) tf_module_nodes_t;
 
+typedef struct tf_event_sub
+{
+    int32_t event_id;
+    int lane;
+    esp_event_handler_t event_handler;
+    void *event_handler_arg;
+    esp_event_handler_instance_t instance;
+    SLIST_ENTRY(tf_event_sub)
+    next;
+} tf_event_sub_t;
+
+typedef SLIST_HEAD(tf_event_subs, tf_event_sub) tf_event_subs_t;
+
+typedef struct tf_event_lane
+{
+    esp_event_loop_handle_t event_handle;
+    tf_lane_info_t info;
+    uint64_t latency_sum;
+    uint32_t dispatched;
+} tf_event_lane_t;
+
 typedef void (*tf_engine_status_cb_t)(void * p_arg, intmax_t tid, int status, const char *p_err_module);
 
 typedef void (*tf_module_status_cb_t)(void * p_arg, const char *p_name, int status);
 
 typedef struct tf_engine
 {
-    esp_event_loop_handle_t event_handle;
+    tf_event_lane_t lanes[TF_LANE_NUM];
+    portMUX_TYPE lane_lock;
+    tf_event_subs_t event_subs;
     tf_module_nodes_t module_nodes;
     TaskHandle_t task_handle;
     StaticTask_t *p_task_buf;
@@ -255,6 +284,7 @@ esp_err_t tf_engine_type_get(int *p_type);
  *
  * @note The retrieved engine information will be stored in the memory pointed to by `p_info`. 
  *          It is important to free the memory pointed to by `p_info->p_tf_name` after use.
+ *          `p_info->lanes` holds the queue depth and latency statistics of each lane since the flow started.
  */
 esp_err_t tf_engine_info_get(tf_info_t *p_info);
 
@@ -331,6 +361,21 @@ esp_err_t tf_module_register(const char *p_name,
                                 const char *p_version,
                                 tf_module_mgmt_t *mgmt_handle);
 
+/**
+ * Assigns a module class to a dispatch lane.
+ *
+ * @param p_name the name of the registered module
+ * @param lane the lane, TF_LANE_DEFAULT, TF_LANE_MEDIA or TF_LANE_ALARM
+ *
+ * @return esp_err_t ESP_OK if the lane is set, ESP_ERR_NOT_FOUND if the module is not registered
+ *
+ * @throws None
+ *
+ * @note Messages on a wire are dispatched on the lane of the module that receives them.
+ *       The new lane takes effect the next time the flow is started.
+ */
+esp_err_t tf_module_lane_set(const char *p_name, int lane);
+
 esp_err_t tf_modules_report(void);
 
 /**
@@ -344,6 +389,10 @@ esp_err_t tf_modules_report(void);
  * @return esp_err_t ESP_OK if the event is successfully posted, error code otherwise
  *
  * @throws None
+ *
+ * @note The event is queued on the lane of the receiving module. The media lane never
+ *       waits, when it is full the new event is dropped and the caller keeps ownership
+ *       of the data, so it must free it just like any other post failure.
  */
 esp_err_t tf_event_post(int32_t event_id,
                         const void *event_data,
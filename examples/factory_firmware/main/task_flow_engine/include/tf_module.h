@@ -8,6 +8,12 @@ extern "C"
 {
 #endif
 
+// Dispatch lanes, each lane has its own event queue and task
+#define TF_LANE_DEFAULT     0   // light messages: timer ticks, shutter, debug
+#define TF_LANE_MEDIA       1   // image frames, bounded and never blocks the producer
+#define TF_LANE_ALARM       2   // handlers that block on screen, audio, uart or network
+#define TF_LANE_NUM         3
+
 struct tf_module_ops
 {
     int (*start)(void *p_module);
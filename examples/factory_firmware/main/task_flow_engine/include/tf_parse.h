@@ -23,14 +23,26 @@ typedef struct tf_module_item
     tf_module_t *handle;
     tf_module_mgmt_t *mgmt_handle;
     uint32_t flag;
+    int lane;
 } tf_module_item_t;
 
+typedef struct tf_lane_info
+{
+    uint32_t posted;       // messages accepted by the lane
+    uint32_t dropped;      // messages rejected because the lane was full
+    uint32_t depth;        // messages waiting for dispatch
+    uint32_t depth_max;    // high-water mark of depth
+    uint32_t latency_avg;  // post to dispatch, us
+    uint32_t latency_max;  // post to dispatch, us
+} tf_lane_info_t;
+
 typedef struct tf_info
 {
     int type;
     intmax_t tid;
     intmax_t ctd;
     const char* p_tf_name; //memory from json parser
+    tf_lane_info_t lanes[TF_LANE_NUM]; // filled by tf_engine_info_get
 }tf_info_t;
 
 int tf_parse_json_with_length(const char *p_str, size_t len,
@@ -5,6 +5,7 @@
 #include "tf_util.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 
 ESP_EVENT_DEFINE_BASE(TF_EVENT_BASE);
 
@@ -27,6 +28,25 @@ static tf_engine_t *gp_engine = NULL;
 #define MODULE_FLAG_PUB_SET_DONE   BIT4
 #define MODULE_FLAG_START_DONE     BIT5
 
+// events small enough are wrapped on the stack, larger ones on the heap
+#define EVENT_WRAP_INLINE_SIZE     192
+
+typedef struct {
+    int64_t post_time;
+} tf_event_hdr_t;
+
+static const struct tf_lane_cfg {
+    const char *p_task_name;
+    int32_t queue_size;
+    UBaseType_t task_priority;
+    uint32_t task_stack_size;
+    bool drop_when_full;
+} __lane_cfgs[TF_LANE_NUM] = {
+    [TF_LANE_DEFAULT] = { "tf_event_task", TF_LANE_DEFAULT_QUEUE_SIZE, 14, 1024 * 3, false },
+    [TF_LANE_MEDIA]   = { "tf_media_task", TF_LANE_MEDIA_QUEUE_SIZE,   15, 1024 * 3, true },
+    [TF_LANE_ALARM]   = { "tf_alarm_task", TF_LANE_ALARM_QUEUE_SIZE,   12, 1024 * 4, false },
+};
+
 static void __data_lock( tf_engine_t *p_engine)
 {
     xSemaphoreTake(p_engine->sem_handle, portMAX_DELAY);
@@ -36,6 +56,62 @@ static void __data_unlock( tf_engine_t *p_engine)
     xSemaphoreGive(p_engine->sem_handle);  
 }
 
+static void __lanes_stats_reset( tf_engine_t *p_engine)
+{
+    taskENTER_CRITICAL(&p_engine->lane_lock);
+    for(int i = 0; i < TF_LANE_NUM; i++) {
+        uint32_t depth = p_engine->lanes[i].info.depth;
+        memset(&p_engine->lanes[i].info, 0, sizeof(tf_lane_info_t));
+        p_engine->lanes[i].info.depth = depth; // still in flight
+        p_engine->lanes[i].info.depth_max = depth;
+        p_engine->lanes[i].latency_sum = 0;
+        p_engine->lanes[i].dispatched = 0;
+    }
+    taskEXIT_CRITICAL(&p_engine->lane_lock);
+}
+
+// the lane of the module that receives event_id, the default lane if nobody does
+static int __lane_find( tf_engine_t *p_engine, int32_t event_id)
+{
+    int lane = TF_LANE_DEFAULT;
+    __data_lock(p_engine);
+    for(int i = 0; i < p_engine->module_item_num && p_engine->p_module_head; i++) {
+        if( p_engine->p_module_head[i].id == event_id ) {
+            lane = p_engine->p_module_head[i].lane;
+            break;
+        }
+    }
+    __data_unlock(p_engine);
+    return lane;
+}
+
+// registered for every id of a lane, the loop runs it once per dequeued event ahead of the
+// module handlers, whether or not any module still listens to that id
+static void __lane_account(void *handler_args, esp_event_base_t base, int32_t id, void *p_event_data)
+{
+    tf_event_lane_t *p_lane = (tf_event_lane_t *)handler_args;
+    tf_event_hdr_t *p_hdr = (tf_event_hdr_t *)p_event_data;
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - p_hdr->post_time);
+
+    taskENTER_CRITICAL(&gp_engine->lane_lock);
+    if( p_lane->info.depth > 0 ) {
+        p_lane->info.depth--;
+    }
+    p_lane->dispatched++;
+    p_lane->latency_sum += latency;
+    if( latency > p_lane->info.latency_max ) {
+        p_lane->info.latency_max = latency;
+    }
+    taskEXIT_CRITICAL(&gp_engine->lane_lock);
+}
+
+static void __event_dispatch(void *handler_args, esp_event_base_t base, int32_t id, void *p_event_data)
+{
+    tf_event_sub_t *p_sub = (tf_event_sub_t *)handler_args;
+
+    p_sub->event_handler(p_sub->event_handler_arg, base, id, (uint8_t *)p_event_data + sizeof(tf_event_hdr_t));
+}
+
 static void __status_cb( tf_engine_t *p_engine, int status, const char *p_err_module)
 {
     tf_engine_status_cb_t  status_cb = NULL;
@@ -87,6 +163,7 @@ static int __modules_init(tf_engine_t *p_engine, tf_module_item_t *p_head, int n
                 if (strcmp(it->p_name, p_head[i].p_name) == 0)
                 {
                     p_head[i].mgmt_handle = it->mgmt_handle;
+                    p_head[i].lane = it->lane;
                     break;
                 }
             }
@@ -285,6 +362,8 @@ static int __run(tf_engine_t *p_engine)
     ESP_LOGI(TAG, "num:  %d", p_engine->module_item_num);
     __modules_item_print(p_engine->p_module_head, p_engine->module_item_num);
     ESP_LOGI(TAG, "====================");
+
+    __lanes_stats_reset(p_engine);
     
     ret = __modules_init(p_engine, p_engine->p_module_head, p_engine->module_item_num, &p_err_module);
     if( ret != ESP_OK ) {
@@ -449,16 +528,23 @@ esp_err_t tf_engine_init(void)
     ESP_GOTO_ON_FALSE(gp_engine, ESP_ERR_NO_MEM, err, TAG, "no mem for tf engine");
     memset(gp_engine, 0, sizeof(tf_engine_t));
 
-    esp_event_loop_args_t event_task_args = {
-        .queue_size = 32,
-        .task_name = "tf_event_task",
-        .task_priority = 14,
-        .task_stack_size = 1024 * 3,
-        .task_core_id = 1
-    };
-    ret = esp_event_loop_create(&event_task_args, &gp_engine->event_handle);
-    ESP_GOTO_ON_ERROR(ret, err, TAG, "event_loop_create failed");
-
+    portMUX_INITIALIZE(&gp_engine->lane_lock);
+    for(int i = 0; i < TF_LANE_NUM; i++) {
+        esp_event_loop_args_t event_task_args = {
+            .queue_size = __lane_cfgs[i].queue_size,
+            .task_name = __lane_cfgs[i].p_task_name,
+            .task_priority = __lane_cfgs[i].task_priority,
+            .task_stack_size = __lane_cfgs[i].task_stack_size,
+            .task_core_id = 1
+        };
+        ret = esp_event_loop_create(&event_task_args, &gp_engine->lanes[i].event_handle);
+        ESP_GOTO_ON_ERROR(ret, err, TAG, "event_loop_create failed");
+        ret = esp_event_handler_register_with(gp_engine->lanes[i].event_handle, TF_EVENT_BASE, ESP_EVENT_ANY_ID,
+                                              __lane_account, &gp_engine->lanes[i]);
+        ESP_GOTO_ON_ERROR(ret, err, TAG, "lane accounting register failed");
+    }
+
+    SLIST_INIT(&(gp_engine->event_subs));
     SLIST_INIT(&(gp_engine->module_nodes));
 
     gp_engine->status = TF_STATUS_IDLE;
@@ -526,6 +612,13 @@ err:
             vEventGroupDelete(gp_engine->event_group);
             gp_engine->event_group = NULL;
         }
+
+        for(int i = 0; i < TF_LANE_NUM; i++) {
+            if (gp_engine->lanes[i].event_handle) {
+                esp_event_loop_delete(gp_engine->lanes[i].event_handle);
+                gp_engine->lanes[i].event_handle = NULL;
+            }
+        }
         tf_free(gp_engine);
         gp_engine = NULL;
     }
@@ -663,6 +756,14 @@ esp_err_t tf_engine_info_get(tf_info_t *p_info)
     memcpy(p_info, &gp_engine->tf_info, sizeof(tf_info_t));
     p_info->p_tf_name = tf_strdup(gp_engine->tf_info.p_tf_name);
     __data_unlock(gp_engine);
+
+    taskENTER_CRITICAL(&gp_engine->lane_lock);
+    for(int i = 0; i < TF_LANE_NUM; i++) {
+        tf_event_lane_t *p_lane = &gp_engine->lanes[i];
+        p_info->lanes[i] = p_lane->info;
+        p_info->lanes[i].latency_avg = p_lane->dispatched ? (uint32_t)(p_lane->latency_sum / p_lane->dispatched) : 0;
+    }
+    taskEXIT_CRITICAL(&gp_engine->lane_lock);
     return ESP_OK;
 }
 
@@ -751,6 +852,7 @@ esp_err_t tf_module_register(const char *p_name,
     p_node->p_desc = p_desc;
     p_node->p_version = p_version;
     p_node->mgmt_handle = mgmt_handle;
+    p_node->lane = TF_LANE_DEFAULT;
     SLIST_INSERT_HEAD(&(gp_engine->module_nodes), p_node, next);
     __data_unlock(gp_engine);
 
@@ -758,6 +860,30 @@ esp_err_t tf_module_register(const char *p_name,
     return ESP_OK;
 }
 
+esp_err_t tf_module_lane_set(const char *p_name, int lane)
+{
+    assert(gp_engine);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    if (p_name == NULL || lane < 0 || lane >= TF_LANE_NUM)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    __data_lock(gp_engine);
+    tf_module_node_t *it = NULL;
+    SLIST_FOREACH(it, &(gp_engine->module_nodes), next)
+    {
+        if (strcmp(it->p_name, p_name) == 0)
+        {
+            it->lane = lane;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    __data_unlock(gp_engine);
+    return ret;
+}
+
 esp_err_t tf_modules_report(void)
 {
     return ESP_OK;
@@ -769,7 +895,53 @@ esp_err_t tf_event_post(int32_t event_id,
                         TickType_t ticks_to_wait)
 {
     assert(gp_engine);
-    return esp_event_post_to(gp_engine->event_handle, TF_EVENT_BASE, event_id, event_data, event_data_size, ticks_to_wait);
+    esp_err_t ret = ESP_OK;
+    uint8_t inline_buf[EVENT_WRAP_INLINE_SIZE] __attribute__((aligned(8)));
+    uint8_t *p_buf = inline_buf;
+    size_t len = sizeof(tf_event_hdr_t) + event_data_size;
+    int lane = __lane_find(gp_engine, event_id);
+    tf_event_lane_t *p_lane = &gp_engine->lanes[lane];
+
+    if( len > sizeof(inline_buf) ) {
+        p_buf = (uint8_t *)tf_malloc(len);
+        if( p_buf == NULL ) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if( event_data && event_data_size ) {
+        memcpy(p_buf + sizeof(tf_event_hdr_t), event_data, event_data_size);
+    }
+
+    // a full media lane drops the new frame instead of stalling the producer,
+    // the caller still owns the data and frees it on failure
+    if( __lane_cfgs[lane].drop_when_full ) {
+        ticks_to_wait = 0;
+    }
+
+    // count before posting, the lane task may dispatch it before the post returns
+    taskENTER_CRITICAL(&gp_engine->lane_lock);
+    p_lane->info.depth++;
+    if( p_lane->info.depth > p_lane->info.depth_max ) {
+        p_lane->info.depth_max = p_lane->info.depth;
+    }
+    taskEXIT_CRITICAL(&gp_engine->lane_lock);
+
+    ((tf_event_hdr_t *)p_buf)->post_time = esp_timer_get_time();
+    ret = esp_event_post_to(p_lane->event_handle, TF_EVENT_BASE, event_id, p_buf, len, ticks_to_wait);
+
+    taskENTER_CRITICAL(&gp_engine->lane_lock);
+    if( ret == ESP_OK ) {
+        p_lane->info.posted++;
+    } else {
+        p_lane->info.depth--;
+        p_lane->info.dropped++;
+    }
+    taskEXIT_CRITICAL(&gp_engine->lane_lock);
+
+    if( p_buf != inline_buf ) {
+        tf_free(p_buf);
+    }
+    return ret;
 }
 
 esp_err_t tf_event_handler_register(int32_t event_id,
@@ -777,12 +949,60 @@ esp_err_t tf_event_handler_register(int32_t event_id,
                                     void *event_handler_arg)
 {
     assert(gp_engine);
-    return esp_event_handler_register_with(gp_engine->event_handle, TF_EVENT_BASE, event_id, event_handler, event_handler_arg);
+    esp_err_t ret = ESP_OK;
+
+    tf_event_sub_t *p_sub = (tf_event_sub_t *)tf_malloc(sizeof(tf_event_sub_t));
+    if (p_sub == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(p_sub, 0, sizeof(tf_event_sub_t));
+    p_sub->event_id = event_id;
+    p_sub->lane = __lane_find(gp_engine, event_id);
+    p_sub->event_handler = event_handler;
+    p_sub->event_handler_arg = event_handler_arg;
+
+    ret = esp_event_handler_instance_register_with(gp_engine->lanes[p_sub->lane].event_handle, TF_EVENT_BASE, event_id,
+                                                   __event_dispatch, p_sub, &p_sub->instance);
+    if (ret != ESP_OK)
+    {
+        tf_free(p_sub);
+        return ret;
+    }
+
+    __data_lock(gp_engine);
+    SLIST_INSERT_HEAD(&(gp_engine->event_subs), p_sub, next);
+    __data_unlock(gp_engine);
+
+    ESP_LOGD(TAG, "event %d on lane %d", (int)event_id, p_sub->lane);
+    return ESP_OK;
 }
 
 esp_err_t tf_event_handler_unregister(int32_t event_id,
                                       esp_event_handler_t event_handler)
 {
     assert(gp_engine);
-    return esp_event_handler_unregister_with(gp_engine->event_handle, TF_EVENT_BASE, event_id, event_handler);
-}
\ No newline at end of file
+    esp_err_t ret = ESP_OK;
+    tf_event_sub_t *p_sub = NULL;
+
+    __data_lock(gp_engine);
+    SLIST_FOREACH(p_sub, &(gp_engine->event_subs), next)
+    {
+        if (p_sub->event_id == event_id && p_sub->event_handler == event_handler)
+        {
+            SLIST_REMOVE(&(gp_engine->event_subs), p_sub, tf_event_sub, next);
+            break;
+        }
+    }
+    __data_unlock(gp_engine);
+
+    if (p_sub == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // the loop holds its mutex while dispatching, so once this returns the handler is no longer running
+    ret = esp_event_handler_instance_unregister_with(gp_engine->lanes[p_sub->lane].event_handle, TF_EVENT_BASE, event_id, p_sub->instance);
+    tf_free(p_sub);
+    return ret;
+}
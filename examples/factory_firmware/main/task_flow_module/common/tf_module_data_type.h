@@ -32,11 +32,21 @@ struct tf_data_buf
     uint32_t len;
 };
 
+// Shared, read only image data. Copies of an image take a reference instead of the bytes,
+// the buffer is freed when the last tf_data_image holding it is freed.
+struct tf_data_frame
+{
+    uint32_t ref;    //atomic
+    uint32_t len;
+    uint8_t *p_buf;  //base64 data, '\0' terminated, never written once shared
+};
+
 struct tf_data_image
 {
     uint8_t *p_buf;  //base64 data
     uint32_t len;
     time_t   time;
+    struct tf_data_frame *p_frame; //owner of p_buf when shared, NULL for a plain buffer
 };
 
 enum tf_data_inference_type {
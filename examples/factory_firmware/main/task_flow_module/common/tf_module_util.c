@@ -1,7 +1,25 @@
+#include "sdkconfig.h"
 #include "tf_module_util.h"
 #include "tf_module_data_type.h"
 #include "tf_util.h"
 
+
+static uint32_t __image_mem_cur = 0;
+static uint32_t __image_mem_max = 0;
+
+static void __image_mem_add(uint32_t len)
+{
+    uint32_t cur = __atomic_add_fetch(&__image_mem_cur, len, __ATOMIC_RELAXED);
+    uint32_t max = __atomic_load_n(&__image_mem_max, __ATOMIC_RELAXED);
+    while( cur > max && !__atomic_compare_exchange_n(&__image_mem_max, &max, cur, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void __image_mem_sub(uint32_t len)
+{
+    __atomic_sub_fetch(&__image_mem_cur, len, __ATOMIC_RELAXED);
+}
+
 const char * tf_data_type_to_str(uint32_t type)
 {
     switch (type)
@@ -74,10 +92,20 @@ void tf_data_image_copy(struct tf_data_image *p_dst, struct tf_data_image *p_src
 {
     p_dst->len  = p_src->len;
     p_dst->time = p_src->time;
-    if( p_src->p_buf != NULL &&  p_src->len > 0) {
+    p_dst->p_frame = NULL;
+    if( p_src->p_frame != NULL ) {
+        __atomic_add_fetch(&p_src->p_frame->ref, 1, __ATOMIC_RELAXED);
+        p_dst->p_frame = p_src->p_frame;
+        p_dst->p_buf = p_src->p_buf;
+    } else if( p_src->p_buf != NULL &&  p_src->len > 0) {
         p_dst->p_buf = tf_malloc(p_src->len + 1);
+        if( p_dst->p_buf == NULL ) {
+            p_dst->len  = 0;
+            return;
+        }
         memcpy(p_dst->p_buf, p_src->p_buf, p_src->len);
         p_dst->p_buf[p_src->len] = 0; // image is base64 data, so add last char '\0'.
+        tf_data_image_share(p_dst);
     } else {
         p_dst->p_buf = NULL;
         p_dst->len  = 0;
@@ -86,12 +114,49 @@ void tf_data_image_copy(struct tf_data_image *p_dst, struct tf_data_image *p_src
 
 void tf_data_image_free(struct tf_data_image *p_data)
 {
-    p_data->len  = 0;
-    p_data->time  = 0;
-    if( p_data->p_buf != NULL) {
+    struct tf_data_frame *p_frame = p_data->p_frame;
+
+    if( p_frame != NULL ) {
+        if( __atomic_sub_fetch(&p_frame->ref, 1, __ATOMIC_ACQ_REL) == 0 ) {
+            __image_mem_sub(p_frame->len);
+            tf_free(p_frame->p_buf);
+            tf_free(p_frame);
+        }
+    } else if( p_data->p_buf != NULL) {
         tf_free(p_data->p_buf);
     }
+    p_data->len  = 0;
+    p_data->time  = 0;
     p_data->p_buf = NULL;
+    p_data->p_frame = NULL;
+}
+
+void tf_data_image_share(struct tf_data_image *p_data)
+{
+    struct tf_data_frame *p_frame = NULL;
+
+    if( p_data->p_frame != NULL || p_data->p_buf == NULL || p_data->len == 0 ) {
+        return;
+    }
+#if CONFIG_TF_IMAGE_COPY_PER_WIRE
+    return; // measurement baseline, every copy of a plain buffer is a full memcpy
+#endif
+    p_frame = (struct tf_data_frame *)tf_malloc(sizeof(struct tf_data_frame));
+
+    if( p_frame == NULL ) {
+        return; // stays a plain buffer, copies of it fall back to memcpy
+    }
+    p_frame->ref   = 1;
+    p_frame->len   = p_data->len;
+    p_frame->p_buf = p_data->p_buf;
+    p_data->p_frame = p_frame;
+    __image_mem_add(p_frame->len);
+}
+
+void tf_data_image_mem_get(uint32_t *p_cur, uint32_t *p_max)
+{
+    *p_cur = __atomic_load_n(&__image_mem_cur, __ATOMIC_RELAXED);
+    *p_max = __atomic_load_n(&__image_mem_max, __ATOMIC_RELAXED);
 }
 
 void tf_data_inference_copy(struct tf_data_inference_info *p_dst, struct tf_data_inference_info *p_src)
@@ -16,9 +16,16 @@ void tf_data_free(void *event_data);
 void tf_data_buf_copy(struct tf_data_buf *p_dst, struct tf_data_buf *p_src);
 void tf_data_buf_free(struct tf_data_buf *p_data);
 
+// copy takes a reference when p_src is shared, otherwise the data is copied into a new shared frame
 void tf_data_image_copy(struct tf_data_image *p_dst, struct tf_data_image *p_src);
 void tf_data_image_free(struct tf_data_image *p_data);
 
+// adopt a plain, '\0' terminated buffer as a shared frame without copying it
+void tf_data_image_share(struct tf_data_image *p_data);
+
+// bytes of image data currently held in shared frames, and the high-water mark
+void tf_data_image_mem_get(uint32_t *p_cur, uint32_t *p_max);
+
 void tf_data_inference_copy(struct tf_data_inference_info *p_dst, struct tf_data_inference_info *p_src);
 void tf_data_inference_free(struct tf_data_inference_info *p_inference);
 
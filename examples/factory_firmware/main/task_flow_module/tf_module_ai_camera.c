@@ -560,6 +560,7 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
 
             info.img.p_buf = NULL;
             info.img.len = 0;
+            info.img.p_frame = NULL;
 
             info.inference.cnt = 0;
             info.inference.is_valid = false;
@@ -575,6 +576,7 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
                 info.img.p_buf = (uint8_t *)img;
                 info.img.len = img_size;
                 info.img.time = time(NULL);
+                tf_data_image_share(&info.img); // preview cache and outputs take references, not copies
                 ESP_LOGD(TAG, "Small img:%.1fk (%d), time: %ld", (float)img_size/1024, img_size, (long)time(NULL));
             }
 
@@ -657,6 +659,7 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
                     p_module_ins->output_data.img_large.p_buf = NULL;
                     p_module_ins->output_data.img_large.len = 0;
                     p_module_ins->output_data.img_large.time = 0;
+                    p_module_ins->output_data.img_large.p_frame = NULL;
                     for (int i = 0; i < p_module_ins->output_evt_num; i++)
                     {
                         tf_data_image_copy(&p_module_ins->output_data.img_small, &info.img);
@@ -689,6 +692,8 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
             struct tf_data_image img_large;
             // printf("sscma:%s\r\n",reply->data);
 
+            img_large.p_frame = NULL;
+
             if (esp_timer_is_active( p_module_ins->timer_handle ) == true)
             {
                 ESP_LOGI(TAG, "stop timer");
@@ -699,6 +704,7 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
                 img_large.p_buf = (uint8_t *)img;
                 img_large.len = img_size;
                 img_large.time = time(NULL);
+                tf_data_image_share(&img_large);
                 ESP_LOGI(TAG, "Large img:%.1fk(%d), time: %ld", (float)img_size/1024, img_size, (long)time(NULL));
             } else {
                 img_large.p_buf = NULL;
@@ -1086,6 +1092,8 @@ static void ai_camera_task(void *p_arg)
         if( ( bits & EVENT_SIMPLE_640_480 ) != 0  && run_flag ) {
             ESP_LOGI(TAG, "EVENT_SIMPLE_640_480");
             sscma_client_break(p_module_ins->sscma_client_handle);
+            // the single large sample must never be throttled away
+            sscma_client_set_result_rate(p_module_ins->sscma_client_handle, 0);
             sscma_client_set_sensor(p_module_ins->sscma_client_handle, 1,  \
                                     TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_640_480, true);
 
@@ -1100,6 +1108,8 @@ static void ai_camera_task(void *p_arg)
         if( ( bits & EVENT_PRVIEW_416_416 ) != 0 && run_flag ) {
             ESP_LOGI(TAG, "EVENT_PRVIEW_416_416");
             sscma_client_break(p_module_ins->sscma_client_handle);
+            // preview only needs the newest result, stale ones are dropped before parsing
+            sscma_client_set_result_rate(p_module_ins->sscma_client_handle, CONFIG_TF_MODULE_AI_CAMERA_PREVIEW_RESULT_RATE);
             sscma_client_set_sensor(p_module_ins->sscma_client_handle, 1,  \
                                     TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_416_416, true);
 
@@ -1116,23 +1126,22 @@ static void ai_camera_task(void *p_arg)
                     ESP_LOGD(TAG, "Invoke reply, code=0, algorithm.type=%d, algorithm.category=%d", p_params->algorithm.type,
                                                                                                     p_params->algorithm.category);
                 }
+                int iou = -1, confidence = -1;  // -1 leaves the threshold unchanged
                 if (p_params->algorithm.type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_YOLO_POSE ||
                     p_params->algorithm.type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_YOLO_WORLD ||
                     p_params->algorithm.type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_YOLO ||
                     p_params->algorithm.type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_YOLO_V8)
                 {
-                    if (sscma_client_set_iou_threshold(p_module_ins->sscma_client_handle, p_params->model.iou) != ESP_OK) {
-                        ESP_LOGE(TAG, "Failed to set iou threshold: %d\n", p_params->model.iou);
-                    } else {
-                        ESP_LOGI(TAG, "Set iou threshold: %d", p_params->model.iou);
-                    }
+                    iou = p_params->model.iou;
                 }
                 if (p_params->algorithm.type != TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_PFLD) {
-                    if (sscma_client_set_confidence_threshold(p_module_ins->sscma_client_handle, p_params->model.confidence)) {
-                        ESP_LOGE(TAG, "Failed to set confidence threshold: %d\n", p_params->model.confidence);
-                    } else {
-                        ESP_LOGI(TAG, "Set confidence threshold: %d", p_params->model.confidence);
-                    }
+                    confidence = p_params->model.confidence;
+                }
+                // both thresholds go out in one round trip
+                if (sscma_client_set_thresholds(p_module_ins->sscma_client_handle, iou, confidence) != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to set thresholds, iou: %d, confidence: %d\n", iou, confidence);
+                } else {
+                    ESP_LOGI(TAG, "Set thresholds, iou: %d, confidence: %d", iou, confidence);
                 }
             } else {
                 if (sscma_client_sample(p_module_ins->sscma_client_handle, -1) != ESP_OK) {
@@ -1455,6 +1464,11 @@ static int __stop(void *p_module)
     p_module_ins->params.condition_num = 0;
     __data_unlock(p_module_ins);
 
+    uint32_t img_mem_cur = 0, img_mem_max = 0;
+    tf_data_image_mem_get(&img_mem_cur, &img_mem_max);
+    ESP_LOGI(TAG, "image frames: %.1fk in use, %.1fk peak, psram min free: %.1fk", (float)img_mem_cur/1024, (float)img_mem_max/1024,
+             (float)heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM)/1024);
+
     esp_err_t ret = tf_event_handler_unregister(p_module_ins->input_evt_id, __event_handler);
 
     
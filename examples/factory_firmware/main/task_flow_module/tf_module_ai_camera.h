@@ -168,6 +168,9 @@ struct tf_module_ai_camera_params
 // default silence duration(if not set)
 #define CONFIG_TF_MODULE_AI_CAMERA_SILENCE_DURATION_DEFAULT     60
 
+// results per second taken from the Himax while previewing, 0 for all
+#define CONFIG_TF_MODULE_AI_CAMERA_PREVIEW_RESULT_RATE          10
+
 struct tf_module_ai_camera_preview_info
 {
     struct tf_data_image                      img;
@@ -351,12 +351,13 @@ static int __https_upload_image(tf_module_img_analyzer_t             *p_module_i
             p_result->img.len   = 0;
             cJSON *json_img = cJSON_GetObjectItem(json_data, "img");
             if ( json_img != NULL && cJSON_IsString(json_img)) {
-                uint8_t *p_img = (uint8_t *)tf_malloc( strlen(json_img->valuestring) );
+                uint8_t *p_img = (uint8_t *)tf_malloc( strlen(json_img->valuestring) + 1 );
                 if( p_img ) {
-                    memcpy(p_img, json_img->valuestring, strlen(json_img->valuestring));
+                    memcpy(p_img, json_img->valuestring, strlen(json_img->valuestring) + 1);
                     p_result->img.p_buf = p_img;
                     p_result->img.len   = strlen(json_img->valuestring);
                     p_result->img.time  = p_data->img_large.time;
+                    tf_data_image_share(&p_result->img); // every output takes a reference
                     ESP_LOGI(TAG, "img:%d", p_result->img.len);
                 }
             }
@@ -128,9 +128,7 @@ static void __event_handler(void *handler_args, esp_event_base_t base, int32_t i
     info.is_show_img = p_params->img;
     info.is_show_text = p_params->text;
     if( info.is_show_img ) {
-        info.img.p_buf = p_data->img_small.p_buf;
-        info.img.time = p_data->img_small.time;
-        info.img.len = p_data->img_small.len;
+        info.img = p_data->img_small; // hand over the buffer and its frame to the view
         img_small_used = true;
     }
     if( info.is_show_text ) {
@@ -10,6 +10,7 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 
 #include <net/if.h>
 
@@ -52,13 +53,31 @@ static char mqtt_tx_topic[128];
 static char mqtt_rx_topic[128];
 static char mqtt_client_id[64];
 
-void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx)
-{
-    // Note: reply is automatically recycled after exiting the function.
+static QueueHandle_t s_forward_queue;
 
+// Hands every reply to the publish task by reference, a slow broker no longer stalls the client.
+void on_forward(sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx)
+{
     EventBits_t mqttConnectBits = xEventGroupGetBits(s_mqtt_event_group);
-    if (mqttConnectBits & MQTT_CONNECTED_BIT)
+    if (!(mqttConnectBits & MQTT_CONNECTED_BIT))
     {
+        return;
+    }
+
+    sscma_client_reply_ref(reply);
+    if (xQueueSend(s_forward_queue, &reply, 0) != pdTRUE)
+    {
+        ESP_LOGW(TAG, "Forward queue full, dropping reply");
+        sscma_client_reply_unref(reply);
+    }
+}
+
+static void forward_task(void *arg)
+{
+    const sscma_client_reply_t *reply = NULL;
+    while (1)
+    {
+        xQueueReceive(s_forward_queue, &reply, portMAX_DELAY);
         int msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_tx_topic, reply->data, reply->len, 0, 0);
         if (msg_id < 0)
         {
@@ -68,7 +87,18 @@ void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, v
         {
             ESP_LOGI(TAG, "Publish success: %d", reply->len);
         }
-        return;
+        sscma_client_reply_unref(reply);
+    }
+}
+
+void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    // Note: reply is automatically recycled after exiting the function.
+
+    EventBits_t mqttConnectBits = xEventGroupGetBits(s_mqtt_event_group);
+    if (mqttConnectBits & MQTT_CONNECTED_BIT)
+    {
+        return; // forwarded by on_forward
     }
 
     char *img = NULL;
@@ -112,16 +142,7 @@ void on_log(sscma_client_handle_t client, const sscma_client_reply_t *reply, voi
     EventBits_t mqttConnectBits = xEventGroupGetBits(s_mqtt_event_group);
     if (mqttConnectBits & MQTT_CONNECTED_BIT)
     {
-        int msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_tx_topic, reply->data, reply->len, 0, 0);
-        if (msg_id < 0)
-        {
-            ESP_LOGE(TAG, "Failed to publish: %d", msg_id);
-        }
-        else
-        {
-            ESP_LOGI(TAG, "Publish success: %d", reply->len);
-        }
-        return;
+        return; // forwarded by on_forward
     }
 
     if (reply->len >= 100)
@@ -137,16 +158,7 @@ void on_response(sscma_client_handle_t client, const sscma_client_reply_t *reply
     EventBits_t mqttConnectBits = xEventGroupGetBits(s_mqtt_event_group);
     if (mqttConnectBits & MQTT_CONNECTED_BIT)
     {
-        int msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_tx_topic, reply->data, reply->len, 0, 0);
-        if (msg_id < 0)
-        {
-            ESP_LOGE(TAG, "Failed to publish: %d", msg_id);
-        }
-        else
-        {
-            ESP_LOGI(TAG, "Publish success: %d", reply->len);
-        }
-        return;
+        return; // forwarded by on_forward
     }
 
     if (reply->len >= 100)
@@ -329,6 +341,16 @@ void app_main(void)
         ESP_LOGI(TAG, "set callback failed\n");
         abort();
     }
+
+    sscma_client_subscriber_handle_t forwarder = NULL;
+    s_forward_queue = xQueueCreate(4, sizeof(const sscma_client_reply_t *));
+    assert(s_forward_queue != NULL);
+    xTaskCreate(forward_task, "forward_task", 4096, NULL, 5, NULL);
+    if (sscma_client_subscribe(client, -1, NULL, on_forward, NULL, &forwarder) != ESP_OK)
+    {
+        ESP_LOGI(TAG, "subscribe failed\n");
+        abort();
+    }
     sscma_client_init(client);
     vTaskDelay(200 / portTICK_PERIOD_MS);
     sscma_client_set_sensor(client, 1, 2, true);